@@ -0,0 +1,77 @@
+#pragma once
+#include <Arduino.h>
+
+// Debounce policies
+// Symmetric: presses and releases both need DEBOUNCE_SAMPLES agreeing samples.
+struct SymmetricDebounce {
+  static constexpr bool FAST_PRESS = false;
+};
+// Fast press: a press is taken on the first sample (lowest latency), releases are debounced.
+struct FastPressDebounce {
+  static constexpr bool FAST_PRESS = true;
+};
+
+// Smallest unsigned type holding BitsN inputs
+template <uint8_t BitsN, bool Fits8 = (BitsN <= 8), bool Fits16 = (BitsN <= 16)>
+struct DebounceBits { typedef uint32_t type; };
+template <uint8_t BitsN, bool Fits16>
+struct DebounceBits<BitsN, true, Fits16> { typedef uint8_t type; };
+template <uint8_t BitsN>
+struct DebounceBits<BitsN, false, true> { typedef uint16_t type; };
+
+// Debounces up to BitsN inputs packed into one word (bit set = active) with 2-bit vertical
+// counters: every bit has its own counter, spread over _c0/_c1, so one update is a handful of
+// word-wide logic operations however many inputs there are.
+// A bit changes state after DEBOUNCE_SAMPLES consecutive samples that disagree with it; any
+// agreeing sample restarts its count. Samples are taken at most every debounceMs / 4.
+// pressed()/released() report the edges taken by the latest update() call only.
+template <class Policy, uint8_t BitsN>
+class Debouncer {
+public:
+  typedef typename DebounceBits<BitsN>::type Bits;
+  static constexpr uint8_t DEBOUNCE_SAMPLES = 4;
+
+  explicit Debouncer(uint16_t debounceMs)
+    : _sampleMs(debounceMs >= DEBOUNCE_SAMPLES ? debounceMs / DEBOUNCE_SAMPLES : 1) {}
+
+  // Set the debounced state without edges (begin/reset)
+  void reset(Bits state = 0) {
+    _state = state;
+    _c0 = _c1 = 0;
+    _pressed = _released = 0;
+  }
+
+  // Feed the raw inputs; returns true if this call took a sample
+  bool update(Bits raw, uint32_t now) {
+    _pressed = _released = 0;
+    if ((now - _lastSample) < _sampleMs) {
+      return false;
+    }
+    _lastSample = now;
+
+    const Bits delta = raw ^ _state;
+    Bits toggle = delta & _c0 & _c1;      // Counter at 3 and still disagreeing
+    if (Policy::FAST_PRESS) {
+      toggle |= delta & raw;              // Presses pass straight through
+    }
+    // Count disagreeing samples, clear the counters everywhere else (including toggled bits)
+    _c1 = (_c1 ^ _c0) & delta & ~toggle;
+    _c0 = ~_c0 & delta & ~toggle;
+
+    _state ^= toggle;
+    _pressed = toggle & _state;
+    _released = toggle & ~_state;
+    return true;
+  }
+
+  Bits state() const { return _state; }
+  Bits pressed() const { return _pressed; }
+  Bits released() const { return _released; }
+
+private:
+  uint16_t _sampleMs;
+  uint32_t _lastSample = 0;
+  Bits _state = 0;
+  Bits _c0 = 0, _c1 = 0;   // Vertical counter bit 0 / bit 1
+  Bits _pressed = 0, _released = 0;
+};
@@ -0,0 +1,104 @@
+#pragma once
+#include <Arduino.h>
+#include <TM1637Display.h>
+
+// Layered framebuffer for a 4-digit TM1637.
+// Owners set layers whenever they like and call flush() once per tick; the layers are composed
+// into one frame that is bit-banged out only if it or the brightness changed since the last
+// transfer. Layers, bottom to top:
+//   digits   - stored content per position
+//   cursor   - live segments at one position
+//   blink    - positions blanked during the off half of the blink interval
+//   overlay  - animation frame, replaces the positions in its mask
+class DisplayCompositor {
+public:
+  static constexpr uint8_t WIDTH = 4;
+  static constexpr uint8_t ALL = (1 << WIDTH) - 1;
+
+  explicit DisplayCompositor(TM1637Display& display) : _display(display) {}
+
+  void setDigit(uint8_t pos, uint8_t segments) { _digits[pos] = segments; }
+
+  void setCursor(uint8_t pos, uint8_t segments) {
+    _cursorPos = pos;
+    _cursor = segments;
+  }
+  void hideCursor() { _cursorPos = NO_CURSOR; }
+
+  // Blank the positions in mask every other intervalMs, starting with a visible half at now
+  void setBlink(uint8_t mask, uint16_t intervalMs, uint32_t now) {
+    _blinkMask = mask;
+    _blinkIntervalMs = intervalMs;
+    _blinkStart = now;
+  }
+  void restartBlink(uint32_t now) { _blinkStart = now; }
+
+  void setOverlay(const uint8_t segments[WIDTH], uint8_t mask = ALL) {
+    memcpy(_overlay, segments, WIDTH);
+    _overlayMask = mask;
+  }
+  void clearOverlay() { _overlayMask = 0; }
+
+  void setBrightness(uint8_t brightness) { _brightness = brightness; }
+
+  // Blank every layer (brightness and blink configuration are kept)
+  void clear() {
+    memset(_digits, 0, WIDTH);
+    _cursorPos = NO_CURSOR;
+    _overlayMask = 0;
+  }
+
+  // Compose and send if anything visible changed; returns true if the display was written
+  bool flush(uint32_t now) {
+    uint8_t frame[WIDTH];
+    compose(frame, now);
+    if (_brightness == _sentBrightness && memcmp(frame, _sent, WIDTH) == 0) {
+      return false;
+    }
+    send(frame);
+    return true;
+  }
+
+  // Re-send the last frame unconditionally (BENCH)
+  void rewrite() {
+    _display.setSegments(_sent);
+  }
+
+private:
+  static constexpr uint8_t NO_CURSOR = 0xFF;
+
+  void compose(uint8_t frame[WIDTH], uint32_t now) const {
+    const bool blinkOff = _blinkMask != 0 && _blinkIntervalMs != 0 &&
+                          (((now - _blinkStart) / _blinkIntervalMs) & 1);
+    for (uint8_t i = 0; i < WIDTH; i++) {
+      const uint8_t bit = 1 << i;
+      uint8_t seg = (i == _cursorPos) ? _cursor : _digits[i];
+      if (blinkOff && (_blinkMask & bit)) seg = 0;
+      if (_overlayMask & bit) seg = _overlay[i];
+      frame[i] = seg;
+    }
+  }
+
+  void send(const uint8_t frame[WIDTH]) {
+    // TM1637Display applies brightness with the next segment transfer
+    if (_brightness != _sentBrightness) _display.setBrightness(_brightness, true);
+    _display.setSegments(frame);
+    memcpy(_sent, frame, WIDTH);
+    _sentBrightness = _brightness;
+  }
+
+  TM1637Display& _display;
+
+  uint8_t _digits[WIDTH] = {0, 0, 0, 0};
+  uint8_t _cursorPos = NO_CURSOR;
+  uint8_t _cursor = 0;
+  uint8_t _blinkMask = 0;
+  uint16_t _blinkIntervalMs = 0;
+  uint32_t _blinkStart = 0;
+  uint8_t _overlay[WIDTH] = {0, 0, 0, 0};
+  uint8_t _overlayMask = 0;
+  uint8_t _brightness = 7;
+
+  uint8_t _sent[WIDTH] = {0, 0, 0, 0};   // Last frame on the display
+  uint8_t _sentBrightness = 0xFF;        // Forces the first flush
+};
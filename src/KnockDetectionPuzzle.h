@@ -1,54 +1,60 @@
 #pragma once
 #include "Puzzle.h"
-#include <Wire.h>
+#include "SensorHub.h"
 
-// ADXL345 I2C Address (default with SDO/ALT grounded)
-#define ADXL345_ADDR 0x53
-
-// ADXL345 Registers
-#define ADXL345_REG_POWER_CTL 0x2D
-#define ADXL345_REG_DATA_FORMAT 0x31
-#define ADXL345_REG_DATAX0 0x32
-
-class KnockDetectionPuzzle : public Puzzle {
+class KnockDetectionPuzzle : public Puzzle, public AccelSubscriber {
 public:
+  // Face of the box that was knocked, named by the sensor axis pointing out of it.
+  // A knock pushes the box away from the knocked face, so the face is opposite the impulse.
+  typedef AccelAxis Face;
+
   /**
+   * @param hub Accelerometer stream (the ADXL345 is owned by the SensorHub)
    * @param requiredKnocks Number of knocks required to solve (default 4)
    * @param knockThreshold Acceleration deviation from gravity in m/s^2 (default 5.0)
    * @param knockWindowMs Time window for knocks to count as a sequence (default 2000ms)
    * @param quietPeriodMs Minimum time between individual knocks (default 100ms)
+   * @param hysteresis Fraction of the threshold delta must drop below to re-arm (default 0.5)
    */
   KnockDetectionPuzzle(
+    SensorHub& hub,
     uint8_t requiredKnocks = 4,
     float knockThreshold = 3.0,
     uint32_t knockWindowMs = 2000,
-    uint32_t quietPeriodMs = 50
+    uint32_t quietPeriodMs = 50,
+    float hysteresis = 0.5
   )
-    : _requiredKnocks(requiredKnocks)
+    : _hub(hub)
+    , _requiredKnocks(requiredKnocks)
     , _knockThreshold(knockThreshold)
+    , _hysteresis(hysteresis)
     , _knockWindowMs(knockWindowMs)
     , _quietPeriodMs(quietPeriodMs)
     , _state(State::WAITING_TO_START)
     , _knockCount(0)
     , _sequenceStartTime(0)
-    , _lastKnockTime(0)
-    , _lastMagnitude(0.0)
+    , _lastKnockUs(0)
     , _knockArmed(true)
-  {}
+  {
+    updateThresholds();
+  }
 
   void begin() override {
-    Wire.begin();
-    
-    // Initialize ADXL345
-    if (!initADXL345()) {
-      Serial.println(F("[Knock] ERROR: ADXL345 initialization failed!"));
+    if (!_hub.ready()) {
+      Serial.println(F("[Knock] ERROR: accelerometer not available!"));
       return;
     }
-    
-    Serial.println(F("[Knock] ADXL345 initialized"));
+    _hub.subscribe(this);
+
+    // Seed the high-pass filter with the resting vector measured by the hub
+    const int16_t* rest = _hub.restVector();
+    for (uint8_t a = 0; a < 3; a++) {
+      _gravity[a] = (int32_t)rest[a] << GRAVITY_Q;
+    }
+
     Serial.print(F("[Knock] Requires "));
-    Serial.print(_requiredKnocks);
-    Serial.print(F(" knocks within "));
+    Serial.print(requiredKnocks());
+    Serial.print(_patternLen > 0 ? F(" rhythm knocks within ") : F(" knocks within "));
     Serial.print(_knockWindowMs);
     Serial.print(F(" ms, threshold "));
     Serial.print(_knockThreshold, 2);
@@ -62,86 +68,12 @@ public:
       return;
     }
 
-    // Read accelerometer data
-    int16_t x, y, z;
-    if (!readAcceleration(x, y, z)) {
-      return;  // Read failed, skip this update
-    }
-
-    // Calculate magnitude using proper Euclidean distance
-    // At ±16g range, scale is ~3.9 mg/LSB, so LSB to m/s^2: value * 0.0039 * 9.81
-    float x_ms2 = x * 0.03827;  // Combined scale factor
-    float y_ms2 = y * 0.03827;
-    float z_ms2 = z * 0.03827;
-    float magnitude = sqrt(x_ms2 * x_ms2 + y_ms2 * y_ms2 + z_ms2 * z_ms2);
-    
-    // Calculate deviation from gravity (rest state is ~9.81 m/s^2)
-    float delta = abs(magnitude - 9.81);
-    
-    // Debug output when activity is detected
-    if (delta > 2.0) {
-      Serial.print(F("[Knock] mag="));
-      Serial.print(magnitude, 2);
-      Serial.print(F(" delta="));
-      Serial.print(delta, 2);
-      Serial.print(F(" thresh="));
-      Serial.print(_knockThreshold);
-      Serial.print(F(" armed="));
-      Serial.print(_knockArmed ? "Y" : "N");
-      Serial.print(F(" time="));
-      Serial.println(now - _lastKnockTime);
-    }
-    
-    // State machine: must go below threshold before next knock can trigger
-    // This prevents shaking (sustained high delta) from counting as multiple knocks
-    bool isKnock = false;
-    
-    if (delta < (_knockThreshold * 0.5)) {
-      // Below hysteresis threshold - arm the knock detector
-      _knockArmed = true;
-    } else if (delta > _knockThreshold && _knockArmed && (now - _lastKnockTime >= _quietPeriodMs)) {
-      // Above threshold, armed, and cooldown expired - register knock
-      isKnock = true;
-      _knockArmed = false;  // Disarm until delta drops again
-    }
-
-    // Handle knock detection
-    if (isKnock) {
-      _lastKnockTime = now;
-      
-      // Start new sequence if idle or window expired
-      if (_state == State::IDLE || (now - _sequenceStartTime) > _knockWindowMs) {
-        _knockCount = 1;
-        _sequenceStartTime = now;
-        _state = State::DETECTING;
-        Serial.print(F("[Knock] Sequence started (1/"));
-        Serial.print(_requiredKnocks);
-        Serial.println(F(")"));
-      }
-      // Continue sequence
-      else if (_state == State::DETECTING) {
-        _knockCount++;
-        Serial.print(F("[Knock] Knock detected ("));
-        Serial.print(_knockCount);
-        Serial.print(F("/"));
-        Serial.print(_requiredKnocks);
-        Serial.println(F(")"));
-        
-        // Check if solved
-        if (_knockCount >= _requiredKnocks) {
-          _state = State::SOLVED;
-          Serial.println(F("[Knock] ✓ SOLVED! Correct knock sequence detected"));
-          return;
-        }
-      }
-    }
-
     // Check for sequence timeout
     if (_state == State::DETECTING && (now - _sequenceStartTime) > _knockWindowMs) {
       Serial.print(F("[Knock] Sequence timed out with "));
       Serial.print(_knockCount);
       Serial.print(F("/"));
-      Serial.print(_requiredKnocks);
+      Serial.print(requiredKnocks());
       Serial.println(F(" knocks"));
       _knockCount = 0;
       _state = State::IDLE;
@@ -152,13 +84,30 @@ public:
     return _state == State::SOLVED;
   }
 
+  // Samples arrive from the SensorHub, in order, at the full output data rate
+  void onAccelSample(const AccelSample& sample) override {
+    if (_state == State::SOLVED || _state == State::WAITING_TO_START) {
+      return;
+    }
+    processSample(sample.x, sample.y, sample.z, sample.ms, sample.us);
+  }
+
+  // Keep the sensor at full rate while a sequence is in progress
+  bool wantsHighRate() const override {
+    return _state == State::DETECTING;
+  }
+
+  // Until solved, idle at full power so the opening knock keeps its peak
+  bool wantsResponsiveIdle() const override {
+    return _state == State::IDLE || _state == State::DETECTING;
+  }
+
   void reset() override {
     Serial.println(F("[Knock] Reset"));
     _state = State::IDLE;
     _knockCount = 0;
     _sequenceStartTime = 0;
-    _lastKnockTime = 0;
-    _lastMagnitude = 0.0;
+    _lastKnockUs = 0;
     _knockArmed = true;
   }
 
@@ -166,6 +115,74 @@ public:
     return F("Knock Detection");
   }
 
+  /**
+   * Enable rhythm ("secret knock") mode: knocks must follow the given gaps, not just their count.
+   * Gaps are normalised to the total duration, so the rhythm may be knocked faster or slower.
+   * @param intervalsMs Target gaps between consecutive knocks (knocks - 1 entries, at most MAX_KNOCKS - 1)
+   * @param count Number of gaps; 0 returns to plain knock counting
+   * @param tolerancePct Allowed deviation of each gap, in percent of the total sequence duration
+   */
+  void setPattern(const uint16_t* intervalsMs, uint8_t count, uint8_t tolerancePct = 10) {
+    if (count > MAX_KNOCKS - 1) count = MAX_KNOCKS - 1;
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < count; i++) total += intervalsMs[i];
+    if (total == 0) count = 0;
+    for (uint8_t i = 0; i < count; i++) {
+      _patternNorm[i] = (uint16_t)(((uint32_t)intervalsMs[i] << NORM_SHIFT) / total);
+    }
+    _patternLen = count;
+    _patternTolerance = count > 0 ? (uint16_t)(((uint32_t)tolerancePct << NORM_SHIFT) / 100) : 0;
+  }
+
+  /**
+   * Require the knocks to land on the given faces, in order (e.g. lid, then left side twice).
+   * Combines with setPattern(): then both the rhythm and the faces must match.
+   * @param faces Face per knock (at most MAX_KNOCKS entries)
+   * @param count Number of knocks; 0 disables face matching
+   */
+  void setFaceSequence(const Face* faces, uint8_t count) {
+    if (count > MAX_KNOCKS) count = MAX_KNOCKS;
+    for (uint8_t i = 0; i < count; i++) _faceSequence[i] = faces[i];
+    _faceLen = count;
+  }
+
+  /**
+   * Retune the detector at runtime (KNOCKCFG command) so thresholds can be swept on the real box.
+   * @param knockThreshold Acceleration deviation from gravity in m/s^2, up to MAX_THRESHOLD
+   * @param hysteresis Re-arm fraction of the threshold (above 0, at most 1)
+   * @param quietPeriodMs Minimum time between individual knocks, at most the knock window
+   * @return false (configuration unchanged) if a value is out of range or the re-arm level
+   *         would be below one LSB, so the detector could never re-arm
+   */
+  bool configure(float knockThreshold, float hysteresis, uint32_t quietPeriodMs) {
+    if (!(knockThreshold > 0 && knockThreshold <= MAX_THRESHOLD) ||
+        !(hysteresis > 0 && hysteresis <= 1) || knockThreshold * hysteresis < MS2_PER_LSB ||
+        quietPeriodMs > _knockWindowMs) {
+      return false;
+    }
+    _knockThreshold = knockThreshold;
+    _hysteresis = hysteresis;
+    _quietPeriodMs = quietPeriodMs;
+    _knockArmed = true;
+    updateThresholds();
+    printConfig();
+    return true;
+  }
+
+  static constexpr float MAX_THRESHOLD = 156.9;          // +/-16 g range
+
+  void printConfig() const {
+    Serial.print(F("[Knock] threshold="));
+    Serial.print(_knockThreshold, 2);
+    Serial.print(F(" m/s^2 hysteresis="));
+    Serial.print(_hysteresis, 2);
+    Serial.print(F(" quiet="));
+    Serial.print(_quietPeriodMs);
+    Serial.print(F(" ms window="));
+    Serial.print(_knockWindowMs);
+    Serial.println(F(" ms"));
+  }
+
 private:
   enum class State {
     WAITING_TO_START,  // Before begin() is called
@@ -174,96 +191,190 @@ private:
     SOLVED             // Puzzle completed
   };
 
+  static constexpr float MS2_PER_LSB = 0.03827;         // 3.9 mg/LSB * 9.81
+
+  // High-pass filter: gravity tracker time constant is 2^HP_SHIFT samples (~0.32 s at 200 Hz)
+  static constexpr uint8_t HP_SHIFT = 6;
+  static constexpr uint8_t GRAVITY_Q = 8;               // Fractional bits of the gravity estimate
+
+  // Rhythm matching: gaps are normalised so that the whole sequence spans 1 << NORM_SHIFT
+  static constexpr uint8_t MAX_KNOCKS = 8;
+  static constexpr uint8_t NORM_SHIFT = 10;
+
+  SensorHub& _hub;
+
   // Configuration
   const uint8_t _requiredKnocks;
-  const float _knockThreshold;
+  float _knockThreshold;
+  float _hysteresis;
   const uint32_t _knockWindowMs;
-  const uint32_t _quietPeriodMs;
+  uint32_t _quietPeriodMs;
 
   // State
   State _state;
   uint8_t _knockCount;
   uint32_t _sequenceStartTime;
-  uint32_t _lastKnockTime;
-  float _lastMagnitude;
+  uint32_t _lastKnockUs;
   bool _knockArmed;
 
+  // Integer detector: gravity is tracked per axis and knocks are found in the dynamic component
+  int32_t _gravity[3] = {0, 0, 0};   // Q(GRAVITY_Q) raw LSB
+  uint32_t _thresholdSq = 0;         // (threshold in LSB)^2
+  uint32_t _rearmSq = 0;             // (threshold * hysteresis in LSB)^2
+
+  // Convert the m/s^2 tuning to squared raw LSB once, so the per-sample path stays integer-only
+  void updateThresholds() {
+    const float thrLsb = _knockThreshold / MS2_PER_LSB;
+    const float rearmLsb = thrLsb * _hysteresis;
+    _thresholdSq = (uint32_t)(thrLsb * thrLsb);
+    _rearmSq = (uint32_t)(rearmLsb * rearmLsb);
+  }
+
   /**
-   * Initialize ADXL345 accelerometer
-   * @return true if successful, false otherwise
+   * Run one accelerometer sample through the high-pass filter and knock state machine.
    */
-  bool initADXL345() {
-    // Check device ID (should be 0xE5)
-    Wire.beginTransmission(ADXL345_ADDR);
-    Wire.write(0x00);  // Device ID register
-    if (Wire.endTransmission() != 0) {
-      return false;
+  void processSample(int16_t x, int16_t y, int16_t z, uint32_t now, uint32_t sampleUs) {
+    // Dynamic component = raw minus the slowly tracked gravity vector (single-pole IIR, integer only)
+    const int16_t raw[3] = {x, y, z};
+    int16_t dyn[3];
+    uint32_t dynSq = 0;
+    for (uint8_t a = 0; a < 3; a++) {
+      const int32_t d = raw[a] - (_gravity[a] >> GRAVITY_Q);
+      dyn[a] = (int16_t)d;
+      dynSq += (uint32_t)(d * d);
+      _gravity[a] += (((int32_t)raw[a] << GRAVITY_Q) - _gravity[a]) >> HP_SHIFT;
     }
-    
-    Wire.requestFrom((uint8_t)ADXL345_ADDR, (uint8_t)1);
-    if (Wire.available()) {
-      uint8_t deviceId = Wire.read();
-      if (deviceId != 0xE5) {
-        Serial.print(F("[Knock] Unexpected device ID: 0x"));
-        Serial.println(deviceId, HEX);
-        return false;
-      }
-    } else {
-      return false;
+
+    // State machine: must go below threshold before next knock can trigger
+    // This prevents shaking (sustained high delta) from counting as multiple knocks
+    bool isKnock = false;
+
+    if (dynSq < _rearmSq) {
+      // Below hysteresis threshold - arm the knock detector
+      _knockArmed = true;
+    } else if (dynSq > _thresholdSq && _knockArmed && (sampleUs - _lastKnockUs >= _quietPeriodMs * 1000UL)) {
+      // Above threshold, armed, and cooldown expired - register knock
+      isKnock = true;
+      _knockArmed = false;  // Disarm until delta drops again
     }
 
-    // Set data format: ±16g range, full resolution
-    Wire.beginTransmission(ADXL345_ADDR);
-    Wire.write(ADXL345_REG_DATA_FORMAT);
-    Wire.write(0x0B);  // Full resolution, ±16g
-    if (Wire.endTransmission() != 0) {
-      return false;
+    if (!isKnock) {
+      return;
     }
 
-    // Enable measurement mode
-    Wire.beginTransmission(ADXL345_ADDR);
-    Wire.write(ADXL345_REG_POWER_CTL);
-    Wire.write(0x08);  // Measurement mode
-    if (Wire.endTransmission() != 0) {
-      return false;
+    const Face face = classifyFace(dyn);
+    Serial.print(F("[Knock] hit dyn^2="));
+    Serial.print(dynSq);
+    Serial.print(F(" thresh^2="));
+    Serial.print(_thresholdSq);
+    Serial.print(F(" face="));
+    SensorHub::printAxis(face);
+    Serial.print(F(" gap="));
+    Serial.print((sampleUs - _lastKnockUs) / 1000);
+    Serial.println(F(" ms"));
+    _lastKnockUs = sampleUs;
+
+    // Start new sequence if idle or window expired
+    if (_state == State::IDLE || (now - _sequenceStartTime) > _knockWindowMs) {
+      startSequence(now, sampleUs, face);
     }
+    // Continue sequence
+    else if (_state == State::DETECTING) {
+      if (_knockCount < MAX_KNOCKS) {
+        _knockUs[_knockCount] = sampleUs;
+        _knockFace[_knockCount] = face;
+      }
+      _knockCount++;
+      Serial.print(F("[Knock] Knock detected ("));
+      Serial.print(_knockCount);
+      Serial.print(F("/"));
+      Serial.print(requiredKnocks());
+      Serial.println(F(")"));
 
-    delay(10);  // Wait for sensor to stabilize
-    return true;
+      // Check if solved
+      if (_knockCount >= requiredKnocks()) {
+        const uint16_t deviation = _patternLen > 0 ? rhythmDeviation() : 0;
+        const bool facesMatch = facesMatchSequence();
+        if (deviation <= _patternTolerance && facesMatch) {
+          _state = State::SOLVED;
+          Serial.println(F("[Knock] ✓ SOLVED! Correct knock sequence detected"));
+          return;
+        }
+        // Wrong rhythm or faces: this knock may be the start of a new attempt
+        if (!facesMatch) {
+          Serial.println(F("[Knock] Wrong faces knocked"));
+        } else {
+          Serial.print(F("[Knock] Rhythm mismatch (off by "));
+          Serial.print(((uint32_t)deviation * 100) >> NORM_SHIFT);
+          Serial.println(F("%)"));
+        }
+        startSequence(now, sampleUs, face);
+      }
+    }
+  }
+
+  // Rhythm mode
+  uint8_t _patternLen = 0;                    // Number of gaps, 0 = count-only mode
+  uint16_t _patternNorm[MAX_KNOCKS - 1] = {}; // Target gaps, normalised
+  uint16_t _patternTolerance = 0;             // Max deviation per gap, normalised
+  uint32_t _knockUs[MAX_KNOCKS] = {};         // Sample timestamps of the current sequence
+
+  // Face sequence mode
+  uint8_t _faceLen = 0;                       // Number of faces, 0 = any face
+  Face _faceSequence[MAX_KNOCKS] = {};
+  Face _knockFace[MAX_KNOCKS] = {};           // Classified faces of the current sequence
+
+  uint8_t requiredKnocks() const {
+    if (_patternLen == 0 && _faceLen == 0) return _requiredKnocks;
+    return _patternLen + 1 > _faceLen ? _patternLen + 1 : _faceLen;
   }
 
   /**
-   * Read acceleration data from ADXL345
-   * @param x Output: X-axis acceleration (raw ADC value)
-   * @param y Output: Y-axis acceleration (raw ADC value)
-   * @param z Output: Z-axis acceleration (raw ADC value)
-   * @return true if read successful, false otherwise
+   * Knocked face from the dynamic vector: dominant axis by magnitude, opposite its sign.
+   * Three integer compares, cheap enough for every sample.
    */
-  bool readAcceleration(int16_t& x, int16_t& y, int16_t& z) {
-    Wire.beginTransmission(ADXL345_ADDR);
-    Wire.write(ADXL345_REG_DATAX0);
-    if (Wire.endTransmission() != 0) {
-      return false;
-    }
+  static Face classifyFace(const int16_t dyn[3]) {
+    const int16_t ax = abs(dyn[0]);
+    const int16_t ay = abs(dyn[1]);
+    const int16_t az = abs(dyn[2]);
+    if (ax >= ay && ax >= az) return dyn[0] < 0 ? Face::X_POS : Face::X_NEG;
+    if (ay >= az) return dyn[1] < 0 ? Face::Y_POS : Face::Y_NEG;
+    return dyn[2] < 0 ? Face::Z_POS : Face::Z_NEG;
+  }
 
-    Wire.requestFrom((uint8_t)ADXL345_ADDR, (uint8_t)6);
-    if (Wire.available() < 6) {
-      return false;
+  bool facesMatchSequence() const {
+    for (uint8_t i = 0; i < _faceLen; i++) {
+      if (_knockFace[i] != _faceSequence[i]) return false;
     }
+    return true;
+  }
 
-    // Read 6 bytes (2 bytes per axis: X, Y, Z)
-    uint8_t x0 = Wire.read();
-    uint8_t x1 = Wire.read();
-    uint8_t y0 = Wire.read();
-    uint8_t y1 = Wire.read();
-    uint8_t z0 = Wire.read();
-    uint8_t z1 = Wire.read();
-
-    // Combine bytes (little-endian)
-    x = (int16_t)((x1 << 8) | x0);
-    y = (int16_t)((y1 << 8) | y0);
-    z = (int16_t)((z1 << 8) | z0);
+  void startSequence(uint32_t now, uint32_t sampleUs, Face face) {
+    _knockCount = 1;
+    _knockUs[0] = sampleUs;
+    _knockFace[0] = face;
+    _sequenceStartTime = now;
+    _state = State::DETECTING;
+    Serial.print(F("[Knock] Sequence started (1/"));
+    Serial.print(requiredKnocks());
+    Serial.println(F(")"));
+  }
 
-    return true;
+  /**
+   * Worst deviation of the recorded gaps from the target rhythm (integer only, O(MAX_KNOCKS)).
+   * @return Normalised deviation, 1 << NORM_SHIFT = the whole sequence duration
+   */
+  uint16_t rhythmDeviation() const {
+    // 64 us units keep (gap << NORM_SHIFT) within 32 bits for sequences up to ~70 s
+    const uint32_t total = (_knockUs[_patternLen] - _knockUs[0]) >> 6;
+    if (total == 0) return 0xFFFF;
+    uint16_t worst = 0;
+    for (uint8_t i = 0; i < _patternLen; i++) {
+      const uint32_t gap = (_knockUs[i + 1] - _knockUs[i]) >> 6;
+      const uint16_t norm = (uint16_t)((gap << NORM_SHIFT) / total);
+      const uint16_t dev = norm > _patternNorm[i] ? norm - _patternNorm[i] : _patternNorm[i] - norm;
+      if (dev > worst) worst = dev;
+    }
+    return worst;
   }
 };
@@ -0,0 +1,121 @@
+#pragma once
+#include <Arduino.h>
+
+// Input-to-feedback latency probe.
+// Puzzles call inputEdge() when they sample an input change and feedback() when the matching
+// output is issued (LED, tone, display, servo). The probe pin goes HIGH on the edge and LOW on
+// the feedback, so a logic analyser sees the true latency as the pulse width; the same interval
+// is timed with micros() and collected in a log2 histogram for the LATENCY serial report.
+// Disabled by default: the hooks then cost a single flag test.
+class LatencyProbe {
+public:
+  static void enable(uint8_t pin) {
+    _pin = pin;
+    pinMode(_pin, OUTPUT);
+    digitalWrite(_pin, LOW);
+    clear();
+    _enabled = true;
+  }
+
+  static void disable() {
+    if (_enabled) digitalWrite(_pin, LOW);
+    _enabled = false;
+    _pending = false;
+  }
+
+  static bool enabled() { return _enabled; }
+
+  // An input edge was sampled. Only the first edge counts until its feedback arrives.
+  static void inputEdge() {
+    if (!_enabled) return;
+    const uint32_t us = micros();
+    if (_pending && (us - _edgeUs) < PENDING_TIMEOUT_US) return;
+    _edgeUs = us;
+    _pending = true;
+    digitalWrite(_pin, HIGH);
+  }
+
+  // Feedback for the pending edge was issued.
+  static void feedback() {
+    if (!_enabled || !_pending) return;
+    const uint32_t latency = micros() - _edgeUs;
+    digitalWrite(_pin, LOW);
+    _pending = false;
+    if (latency >= PENDING_TIMEOUT_US) return;  // stale edge that never got feedback
+    if (_count == 0xFFFF) return;               // histogram full
+
+    uint8_t bucket = 0;
+    for (uint32_t v = latency; v > 1 && bucket < BUCKETS - 1; v >>= 1) bucket++;
+    if (_hist[bucket] < 0xFFFF) _hist[bucket]++;
+    _count++;
+    _sumUs += latency;
+    if (latency < _minUs) _minUs = latency;
+    if (latency > _maxUs) _maxUs = latency;
+  }
+
+  static void report() {
+    Serial.print(F("Latency: "));
+    Serial.print(_count);
+    Serial.print(F(" samples"));
+    if (_count == 0) {
+      Serial.println();
+      return;
+    }
+    Serial.print(F(", min/avg/max "));
+    Serial.print(_minUs);
+    Serial.print('/');
+    Serial.print(_sumUs / _count);
+    Serial.print('/');
+    Serial.print(_maxUs);
+    Serial.println(F(" us"));
+
+    // Percentiles resolve to the upper bound of their power-of-two bucket
+    static const uint8_t pcts[] = {50, 90, 99};
+    for (uint8_t p = 0; p < sizeof(pcts); p++) {
+      const uint32_t target = ((uint32_t)_count * pcts[p] + 99) / 100;
+      uint32_t seen = 0;
+      uint8_t b = 0;
+      for (; b < BUCKETS; b++) {
+        seen += _hist[b];
+        if (seen >= target) break;
+      }
+      Serial.print(F("  p"));
+      Serial.print(pcts[p]);
+      Serial.print(F(" <= "));
+      Serial.print(1UL << (b + 1));
+      Serial.println(F(" us"));
+    }
+  }
+
+  static void clear() {
+    for (uint8_t i = 0; i < BUCKETS; i++) _hist[i] = 0;
+    _count = 0;
+    _sumUs = 0;
+    _minUs = 0xFFFFFFFF;
+    _maxUs = 0;
+    _pending = false;
+  }
+
+private:
+  static constexpr uint8_t BUCKETS = 24;                      // up to ~16 s
+  static constexpr uint32_t PENDING_TIMEOUT_US = 2000000UL;   // edges without feedback expire
+
+  static bool _enabled;
+  static bool _pending;
+  static uint8_t _pin;
+  static uint32_t _edgeUs;
+  static uint16_t _hist[BUCKETS];
+  static uint16_t _count;
+  static uint32_t _sumUs, _minUs, _maxUs;
+};
+
+// Static member definitions
+bool LatencyProbe::_enabled = false;
+bool LatencyProbe::_pending = false;
+uint8_t LatencyProbe::_pin = 0;
+uint32_t LatencyProbe::_edgeUs = 0;
+uint16_t LatencyProbe::_hist[LatencyProbe::BUCKETS] = {};
+uint16_t LatencyProbe::_count = 0;
+uint32_t LatencyProbe::_sumUs = 0;
+uint32_t LatencyProbe::_minUs = 0xFFFFFFFF;
+uint32_t LatencyProbe::_maxUs = 0;
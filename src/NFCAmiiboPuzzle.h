@@ -3,7 +3,22 @@
 #include <Wire.h>
 #include <Adafruit_PN532.h>
 #include "Puzzle.h"
+#include "UidAllowlist.h"
 
+// Accepted figures come from an EEPROM allowlist (NFCADD/NFCDEL/NFCLIST/NFCLEARN), so props can
+// be swapped without reflashing. A blank EEPROM is seeded with the original Goomba UID.
+// Any other figure of the required character is accepted too: the amiibo ID is read from NTAG215
+// pages 21-22 and its game/character field compared. The required character is learned from the
+// first SOLVE tag presented (or set with NFCCHAR) and stored in EEPROM after the allowlist.
+// Polling is adaptive: the interval doubles up to POLL_MAX_MS while nothing is seen and drops
+// back to POLL_FAST_MS for a hover window after a tag or pollBurst().
+// Optional IRQ/RESET pins: with IRQ the driver waits on the pin instead of polling the I2C status
+// byte, and detection runs split-phase (start InListPassiveTarget, read it once IRQ asserts) so a
+// poll never blocks the loop. With RESET a wedged module is hard-reset and reinitialised.
+// Power: the RF field is switched off (RFConfiguration) after a poll once the hover window has
+// passed, so it is only energised for the poll itself, and the chip is put into PowerDown with
+// I2C wakeup while the puzzle stays solved, unless hint/admin tags are enrolled: those keep a slow
+// poll (POLL_MAX_MS) running. STATUS reports an estimated average current.
 class NFCAmiiboPuzzle : public Puzzle {
 public:
   enum class State {
@@ -14,48 +29,60 @@ public:
     SOLVED
   };
 
-  NFCAmiiboPuzzle() 
-    : _nfc(-1, -1),  // I2C mode: pass -1 for IRQ and Reset pins
+  static constexpr uint8_t NO_PIN = 0xFF;
+
+  NFCAmiiboPuzzle(uint16_t eepromBase = 0, uint8_t irqPin = NO_PIN, uint8_t resetPin = NO_PIN)
+    : _nfc(irqPin, resetPin),  // I2C mode: NO_PIN (-1) for unused IRQ and Reset pins
+      _irqPin(irqPin), _resetPin(resetPin),
       _state(State::WAITING_TO_START), _solved(false), _stateTimer(0),
+      _allowlist(eepromBase), _charAddr(eepromBase + UidAllowlist::EEPROM_SIZE),
       _lastUIDLen(0), _lastSeenAt(0) {
-    // Goomba UID: 04:A6:89:72:3C:4D:80
-    _targetUID[0] = 0x04;
-    _targetUID[1] = 0xA6;
-    _targetUID[2] = 0x89;
-    _targetUID[3] = 0x72;
-    _targetUID[4] = 0x3C;
-    _targetUID[5] = 0x4D;
-    _targetUID[6] = 0x80;
-    _targetUIDLen = 7;
   }
 
   void begin() override {
     Serial.println(F("NFCAmiiboPuzzle: Initializing..."));
+
+    if (!_allowlist.begin()) {
+      // Fresh EEPROM: keep the original Goomba (04:A6:89:72:3C:4D:80) working
+      static const uint8_t GOOMBA_UID[] = {0x04, 0xA6, 0x89, 0x72, 0x3C, 0x4D, 0x80};
+      _allowlist.add(GOOMBA_UID, sizeof(GOOMBA_UID), NfcRole::SOLVE);
+      EEPROM.update(_charAddr, 0);  // Relearn the character from the Goomba
+    }
+    _requiredChar = EEPROM.read(_charAddr) == CHAR_MAGIC
+        ? (uint16_t)((EEPROM.read(_charAddr + 1) << 8) | EEPROM.read(_charAddr + 2))
+        : NO_CHARACTER;
     
     Wire.begin();
-    _nfc.begin();
-    
-    uint32_t versiondata = _nfc.getFirmwareVersion();
-    if (!versiondata) {
-      Serial.println(F("NFCAmiiboPuzzle: PN532 not found. Check wiring and I2C mode switch."));
+    if (!initReader()) {
       _state = State::WAITING_TO_START;
       return;
     }
     
-    Serial.print(F("NFCAmiiboPuzzle: PN532 firmware 0x"));
-    Serial.println((versiondata >> 16) & 0xFF, HEX);
-    
-    // Configure for normal read mode
-    _nfc.SAMConfig();
-    
-    Serial.println(F("NFCAmiiboPuzzle: Ready! Waiting for Goomba amiibo..."));
+    Serial.print(F("NFCAmiiboPuzzle: Ready! "));
+    Serial.print(_allowlist.count());
+    Serial.println(F(" tag(s) on the allowlist"));
     _state = State::IDLE;
   }
 
   void update(uint32_t now) override {
-    if (_state == State::SOLVED || _state == State::WAITING_TO_START) {
+    if (_state == State::WAITING_TO_START) {
       return; // Nothing to do
     }
+    if (_learnRole != NfcRole::NONE && (now - _learnStartedAt) >= LEARN_TIMEOUT_MS) {
+      Serial.println(F("NFCAmiiboPuzzle: Learn mode timed out"));
+      _learnRole = NfcRole::NONE;
+    }
+    if (_state == State::SOLVED && _learnRole == NfcRole::NONE && !_detectPending) {
+      if (_rfState == RfState::POWERDOWN || (int32_t)(now - _nextPollAt) < 0) {
+        return;
+      }
+      // Hint and admin tags still act once solved (the reset tag is needed at the end of a
+      // session), so keep a slow poll while the allowlist has any; otherwise power down
+      if (!hasRoleTags()) {
+        if ((int32_t)(now - _powerDownRetryAt) >= 0) powerDown(now);
+        return;
+      }
+    }
     
     if (_state == State::SUCCESS_FEEDBACK) {
       // Show success feedback for 2 seconds
@@ -65,18 +92,47 @@ public:
       return;
     }
     
-    // IDLE or READING_NFC - check for NFC tag
+    // IDLE or READING_NFC - check for NFC tag when the poll schedule says so
     uint8_t uid[10];
     uint8_t uidLen = 0;
-    bool detected = _nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLen, 50);
+    bool detected;
+    if (_irqPin == NO_PIN) {
+      if ((int32_t)(now - _nextPollAt) < 0) {
+        return;
+      }
+      if (_rfState == RfState::OFF) setRfState(RfState::ON, now);
+      detected = _nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLen, 50);
+    } else if (!_detectPending) {
+      if ((int32_t)(now - _nextPollAt) < 0) {
+        return;
+      }
+      if (_rfState == RfState::OFF) setRfState(RfState::ON, now);
+      _detectPending = _nfc.startPassiveTargetIDDetection(PN532_MIFARE_ISO14443A);
+      _detectStartedAt = now;
+      if (!_detectPending) recover(now);
+      return;
+    } else if (digitalRead(_irqPin) == HIGH) {
+      if ((now - _detectStartedAt) >= IRQ_TIMEOUT_MS) {
+        Serial.println(F("NFCAmiiboPuzzle: No IRQ from PN532"));
+        recover(now);
+      }
+      return;  // Response not ready yet
+    } else {
+      _detectPending = false;
+      detected = _nfc.readDetectedPassiveTargetID(uid, &uidLen);
+    }
+    _polls++;
+    schedulePoll(now, detected);
+    if (_state == State::SOLVED && !detected) _nextPollAt = now + POLL_MAX_MS;
     
     if (!detected) {
       return; // No tag present
     }
     
-    // Debounce same card hovering
+    // Debounce same card hovering: it has to leave the field for 800ms before it counts again
     if (uidLen == _lastUIDLen && memcmp(uid, _lastUID, uidLen) == 0) {
       if ((now - _lastSeenAt) < 800) { // 800ms cooldown
+        _lastSeenAt = now;
         return;
       }
     }
@@ -90,39 +146,175 @@ public:
     Serial.print(F("NFCAmiiboPuzzle: Detected UID["));
     Serial.print(uidLen);
     Serial.print(F("]: "));
-    for (uint8_t i = 0; i < uidLen; i++) {
-      if (uid[i] < 0x10) Serial.print('0');
-      Serial.print(uid[i], HEX);
-      if (i + 1 < uidLen) Serial.print(':');
-    }
+    UidAllowlist::printUID(uid, uidLen);
     Serial.println();
-    
-    // Check if it matches the Goomba
-    if (uidLen == _targetUIDLen && memcmp(uid, _targetUID, uidLen) == 0) {
-      Serial.println(F("NFCAmiiboPuzzle: GOOMBA DETECTED! PUZZLE SOLVED!"));
-      _solved = true;
-      _state = State::SUCCESS_FEEDBACK;
-      _stateTimer = now;
+
+    if (_learnRole != NfcRole::NONE) {
+      enroll(uid, uidLen);
+      return;
+    }
+    const NfcRole role = _allowlist.lookup(uid, uidLen);
+    if (_state == State::SOLVED && role != NfcRole::HINT && role != NfcRole::ADMIN_RESET) {
+      return;
+    }
+
+    switch (role) {
+      case NfcRole::SOLVE:
+        Serial.println(F("NFCAmiiboPuzzle: AMIIBO ACCEPTED! PUZZLE SOLVED!"));
+        if (_requiredChar == NO_CHARACTER) {
+          const uint16_t character = characterOf(uid, uidLen);
+          if (character != NO_CHARACTER) setRequiredCharacter(character);
+        }
+        solve(now);
+        break;
+      case NfcRole::HINT:
+        Serial.println(F("NFCAmiiboPuzzle: Hint tag"));
+        _pendingAction = NfcRole::HINT;
+        break;
+      case NfcRole::ADMIN_RESET:
+        Serial.println(F("NFCAmiiboPuzzle: Admin tag, reset requested"));
+        _pendingAction = NfcRole::ADMIN_RESET;
+        break;
+      default: {
+        const uint16_t character = _requiredChar == NO_CHARACTER ? NO_CHARACTER : characterOf(uid, uidLen);
+        if (character != NO_CHARACTER && character == _requiredChar) {
+          Serial.println(F("NFCAmiiboPuzzle: CHARACTER MATCHED! PUZZLE SOLVED!"));
+          solve(now);
+        } else {
+          Serial.println(F("NFCAmiiboPuzzle: Wrong amiibo!"));
+        }
+        break;
+      }
+    }
+  }
+
+  // Required amiibo game/character ID (NFCCHAR); NO_CHARACTER accepts allowlisted UIDs only
+  // and relearns from the next SOLVE tag
+  void setRequiredCharacter(uint16_t character) {
+    _requiredChar = character;
+    EEPROM.update(_charAddr + 1, character >> 8);
+    EEPROM.update(_charAddr + 2, character & 0xFF);
+    EEPROM.update(_charAddr, character == NO_CHARACTER ? 0 : CHAR_MAGIC);
+    printRequiredCharacter();
+  }
+
+  void printRequiredCharacter() const {
+    Serial.print(F("NFCAmiiboPuzzle: Required character "));
+    if (_requiredChar == NO_CHARACTER) {
+      Serial.println(F("not set"));
     } else {
-      Serial.println(F("NFCAmiiboPuzzle: Wrong amiibo, need the Goomba!"));
+      printCharacter(_requiredChar);
+      Serial.println();
     }
   }
 
+  static constexpr uint16_t NO_CHARACTER = 0xFFFF;
+
+  // Something is happening near the reader: poll at the fast rate for the hover window
+  void pollBurst(uint32_t now) {
+    if (_pollIntervalMs != POLL_FAST_MS) _nextPollAt = now;
+    _pollIntervalMs = POLL_FAST_MS;
+    _lastActivityAt = now;
+  }
+
+  void printPollStats() const {
+    Serial.print(F("  NFC: "));
+    Serial.print(_polls);
+    Serial.print(F(" polls, interval "));
+    Serial.print(_pollIntervalMs);
+    Serial.print(F(" ms, "));
+    Serial.print(_recoveries);
+    Serial.println(F(" recoveries"));
+
+    // Estimated PN532 supply current from the time spent in each power state
+    uint32_t ms[3] = {_rfMs[0], _rfMs[1], _rfMs[2]};
+    ms[(uint8_t)_rfState] += millis() - _rfSince;
+    const uint32_t total = ms[0] + ms[1] + ms[2];
+    if (total < 1000) return;
+    // Per-mille shares (scaled so ms * 1000 fits 32 bits) keep the weighted sum inside 32 bits
+    uint8_t shift = 0;
+    while ((total >> shift) > 4000000UL) shift++;
+    uint32_t permille[3];
+    for (uint8_t i = 0; i < 3; i++) permille[i] = (ms[i] >> shift) * 1000 / (total >> shift);
+    const uint32_t avgUa = (permille[(uint8_t)RfState::ON] * RF_ON_UA + permille[(uint8_t)RfState::OFF] * RF_OFF_UA +
+                            permille[(uint8_t)RfState::POWERDOWN] * POWERDOWN_UA) / 1000;
+    Serial.print(F("  NFC power: RF on "));
+    Serial.print(permille[(uint8_t)RfState::ON] / 10);
+    Serial.print(F("%, off "));
+    Serial.print(permille[(uint8_t)RfState::OFF] / 10);
+    Serial.print(F("%, powerdown "));
+    Serial.print(permille[(uint8_t)RfState::POWERDOWN] / 10);
+    Serial.print(F("%; est. "));
+    Serial.print(avgUa / 1000);
+    Serial.print(F(" mA avg vs "));
+    Serial.print(RF_ON_UA / 1000);
+    Serial.println(F(" mA always-on"));
+  }
+
+  // Call after editing the allowlist directly (NFCADD): a solved puzzle may have powered the
+  // reader down for lack of hint/admin tags; wake it so the next tick decides again
+  void allowlistChanged(uint32_t now) {
+    wake(now);
+  }
+
+  // Enroll the next presented tag with the given role (NFCLEARN)
+  void startLearning(NfcRole role, uint32_t now) {
+    wake(now);
+    pollBurst(now);
+    _learnRole = role;
+    _learnStartedAt = now;
+    _lastUIDLen = 0;  // Accept the tag that is already on the reader
+    Serial.print(F("NFCAmiiboPuzzle: Learn mode, present a tag to enroll as "));
+    UidAllowlist::printRole(role);
+    Serial.println();
+  }
+
+  // Hint/admin tag seen since the last call (NfcRole::NONE if none); the sketch acts on it
+  NfcRole takeAction() {
+    const NfcRole action = _pendingAction;
+    _pendingAction = NfcRole::NONE;
+    return action;
+  }
+
+  UidAllowlist& allowlist() { return _allowlist; }
+
   bool isSolved() const override {
     return _solved;
   }
 
   void reset() override {
     Serial.println(F("NFCAmiiboPuzzle: Reset"));
+    wake(millis());
     _solved = false;
     _state = State::IDLE;
     _stateTimer = 0;
-    _lastSeenAt = 0;
-    _lastUIDLen = 0;
+    // The last UID is kept: an admin tag that triggered this reset must not trigger it again
+    _pendingAction = NfcRole::NONE;
+    _pollIntervalMs = POLL_FAST_MS;
+    _nextPollAt = 0;
+    _lastActivityAt = millis();
+    _polls = 0;
+    _powerDownFailures = 0;
+    _powerDownRetryAt = millis();
   }
 
   const __FlashStringHelper* name() const override {
-    return F("Goomba Amiibo");
+    return F("Amiibo");
+  }
+
+  // One blocking no-card poll (BENCH command). Wakes the chip, aborts a pending detection and
+  // accounts the field as on; the poll schedule or the solved state switches it off again.
+  bool benchPoll() {
+    if (_state == State::WAITING_TO_START) return false;
+    const uint32_t now = millis();
+    wake(now);
+    if (_state == State::WAITING_TO_START) return false;
+    _detectPending = false;
+    if (_rfState == RfState::OFF) setRfState(RfState::ON, now);
+    uint8_t uid[10];
+    uint8_t uidLen = 0;
+    _nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLen, 50);
+    return true;
   }
 
   int ledBrightness() const override {
@@ -142,13 +334,224 @@ public:
   }
 
 private:
+  static constexpr uint32_t LEARN_TIMEOUT_MS = 15000;
+  static constexpr uint8_t CHAR_MAGIC = 'C';
+  static constexpr uint8_t AMIIBO_ID_PAGE = 21;   // NTAG215 pages 21-22: 8-byte amiibo ID
+  static constexpr uint8_t CACHE_SIZE = 4;
+  static constexpr uint16_t POLL_FAST_MS = 100;    // Interval while a tag is (or may be) near
+  static constexpr uint16_t POLL_MAX_MS = 800;     // Backoff cap when idle
+  static constexpr uint16_t HOVER_MS = 3000;       // Fast rate kept after the last activity
+  static constexpr uint16_t IRQ_TIMEOUT_MS = 500;  // Split-phase detection must answer by then
+  static constexpr uint8_t PASSIVE_RETRIES = 0x10; // Bounded InListPassiveTarget (default 0xFF = forever)
+  static constexpr uint16_t POWERDOWN_RETRY_MS = 500;  // Doubles per failed PowerDown...
+  static constexpr uint8_t POWERDOWN_MAX_SHIFT = 6;    // ...up to 32 s
+  static constexpr uint8_t POWERDOWN_TRIES = 3;        // Failures before a recover()
+
+  // begin() pulses RESET when wired; then handshake and configure for tag reading
+  bool initReader() {
+    _nfc.begin();
+    uint32_t versiondata = _nfc.getFirmwareVersion();
+    if (!versiondata) {
+      Serial.println(F("NFCAmiiboPuzzle: PN532 not found. Check wiring and I2C mode switch."));
+      return false;
+    }
+
+    Serial.print(F("NFCAmiiboPuzzle: PN532 firmware 0x"));
+    Serial.println((versiondata >> 16) & 0xFF, HEX);
+
+    // Configure for normal read mode; a split-phase detection must end even without a tag
+    _nfc.SAMConfig();
+    _nfc.setPassiveActivationRetries(PASSIVE_RETRIES);
+    return true;
+  }
+
+  struct CacheEntry {
+    uint8_t uidLen;           // 0 = unused
+    uint8_t uid[UidAllowlist::MAX_UID_LEN];
+    uint16_t character;
+  };
+
+  // Exponential backoff once the hover window has passed without a tag
+  void schedulePoll(uint32_t now, bool detected) {
+    if (detected) {
+      _pollIntervalMs = POLL_FAST_MS;
+      _lastActivityAt = now;
+    } else if ((now - _lastActivityAt) >= HOVER_MS) {
+      if (_pollIntervalMs < POLL_MAX_MS) _pollIntervalMs = min((uint16_t)(_pollIntervalMs * 2), POLL_MAX_MS);
+      rfOff(now);  // InListPassiveTarget switches it back on for the next poll
+    }
+    _nextPollAt = now + _pollIntervalMs;
+  }
+
+  // PN532 supply current per state (datasheet typicals, 3.3 V) for the STATUS estimate
+  static constexpr uint32_t RF_ON_UA = 60000;      // Field energised
+  static constexpr uint32_t RF_OFF_UA = 15000;     // Idle, field off
+  static constexpr uint32_t POWERDOWN_UA = 10;     // Soft power-down
+
+  enum class RfState : uint8_t { ON, OFF, POWERDOWN };
+
+  void setRfState(RfState state, uint32_t now) {
+    _rfMs[(uint8_t)_rfState] += now - _rfSince;
+    _rfSince = now;
+    _rfState = state;
+  }
+
+  void rfOff(uint32_t now) {
+    if (_rfState != RfState::ON) return;
+    uint8_t cmd[] = {PN532_COMMAND_RFCONFIGURATION, 0x01, 0x00};  // CfgItem 1: RF field off, no auto RFCA
+    if (sendCommand(cmd, sizeof(cmd))) setRfState(RfState::OFF, now);
+  }
+
+  void powerDown(uint32_t now) {
+    _detectPending = false;  // The new command aborts a pending detection
+    uint8_t cmd[] = {PN532_COMMAND_POWERDOWN, 0x80};  // WakeUpEnable: I2C
+    if (sendCommand(cmd, sizeof(cmd))) {
+      setRfState(RfState::POWERDOWN, now);
+      _powerDownFailures = 0;
+      Serial.println(F("NFCAmiiboPuzzle: PN532 powered down"));
+      return;
+    }
+    // Each attempt blocks for the ACK timeout: back off, and re-initialise a reader that keeps refusing
+    if (_powerDownFailures < 0xFF) _powerDownFailures++;
+    if (_powerDownFailures % POWERDOWN_TRIES == 0) recover(now);
+    const uint8_t shift = _powerDownFailures < POWERDOWN_MAX_SHIFT ? _powerDownFailures : POWERDOWN_MAX_SHIFT;
+    _powerDownRetryAt = now + ((uint32_t)POWERDOWN_RETRY_MS << shift);
+  }
+
+  // Any I2C frame wakes the chip; re-run the handshake and configuration after it
+  void wake(uint32_t now) {
+    if (_rfState != RfState::POWERDOWN) return;
+    _nfc.getFirmwareVersion();  // Wake-up frame, may not be answered
+    delay(2);
+    if (!initReader()) {
+      _state = State::WAITING_TO_START;
+      return;
+    }
+    setRfState(RfState::OFF, now);  // Field comes back with the next poll
+  }
+
+  // Send a command and drain its response frame; only for commands whose answer is not needed
+  bool sendCommand(uint8_t* cmd, uint8_t len) {
+    if (!_nfc.sendCommandCheckAck(cmd, len)) return false;
+    const uint32_t start = millis();
+    while (!responseReady()) {
+      if ((millis() - start) >= 20) return false;
+    }
+    Wire.requestFrom((uint8_t)PN532_I2C_ADDRESS, (uint8_t)10);  // Status byte + short frame
+    while (Wire.available()) Wire.read();
+    return true;
+  }
+
+  bool responseReady() {
+    if (_irqPin != NO_PIN) return digitalRead(_irqPin) == LOW;
+    Wire.requestFrom((uint8_t)PN532_I2C_ADDRESS, (uint8_t)1);
+    return Wire.available() && (Wire.read() & 0x01);
+  }
+
+  // Hard reset (RESET pin) or re-handshake the PN532 and restore its configuration
+  void recover(uint32_t now) {
+    _detectPending = false;
+    _recoveries++;
+    Serial.println(_resetPin == NO_PIN ? F("NFCAmiiboPuzzle: Re-initialising PN532...")
+                                       : F("NFCAmiiboPuzzle: Hard-resetting PN532..."));
+    if (!initReader()) {
+      Serial.println(F("NFCAmiiboPuzzle: PN532 lost"));
+      _state = State::WAITING_TO_START;
+      return;
+    }
+    _nextPollAt = now + POLL_FAST_MS;
+  }
+
+  bool hasRoleTags() const {
+    return _allowlist.contains(NfcRole::HINT) || _allowlist.contains(NfcRole::ADMIN_RESET);
+  }
+
+  void solve(uint32_t now) {
+    _solved = true;
+    _state = State::SUCCESS_FEEDBACK;
+    _stateTimer = now;
+  }
+
+  static void printCharacter(uint16_t character) {
+    if (character < 0x1000) Serial.print('0');
+    if (character < 0x100) Serial.print('0');
+    if (character < 0x10) Serial.print('0');
+    Serial.print(character, HEX);
+  }
+
+  // Game/character ID of the detected tag, from the cache or two NTAG page reads.
+  // NO_CHARACTER if the tag is not readable as an amiibo.
+  uint16_t characterOf(const uint8_t* uid, uint8_t uidLen) {
+    for (uint8_t i = 0; i < CACHE_SIZE; i++) {
+      if (_cache[i].uidLen == uidLen && memcmp(_cache[i].uid, uid, uidLen) == 0) {
+        return _cache[i].character;
+      }
+    }
+
+    // ntag2xx_ReadPage addresses Tg 1, the target listed by the last detection. inDataExchange
+    // would use the driver's inListPassiveTarget() bookkeeping, which split-phase detection skips.
+    uint8_t page[8];
+    if (uidLen != 7 || !_nfc.ntag2xx_ReadPage(AMIIBO_ID_PAGE, page) ||
+        !_nfc.ntag2xx_ReadPage(AMIIBO_ID_PAGE + 1, page + 4) || page[7] != 0x02) {
+      return NO_CHARACTER;  // Not an NTAG215 amiibo (ID always ends in 0x02), or read failed
+    }
+    // Bytes 0-1 game/character, 2 variant, 3 figure type, 4-5 model, 6 series
+    const uint16_t character = (uint16_t)((page[0] << 8) | page[1]);
+    Serial.print(F("NFCAmiiboPuzzle: Character "));
+    printCharacter(character);
+    Serial.println();
+
+    CacheEntry& e = _cache[_cacheNext];
+    _cacheNext = (_cacheNext + 1) % CACHE_SIZE;
+    memcpy(e.uid, uid, uidLen);
+    e.uidLen = uidLen;
+    e.character = character;
+    return character;
+  }
+
+  void enroll(const uint8_t* uid, uint8_t uidLen) {
+    if (_allowlist.add(uid, uidLen, _learnRole)) {
+      Serial.print(F("NFCAmiiboPuzzle: Enrolled as "));
+      UidAllowlist::printRole(_learnRole);
+      Serial.println();
+      if (_learnRole == NfcRole::SOLVE) {
+        // An enrolled figure also defines the character other figures must match
+        const uint16_t character = characterOf(uid, uidLen);
+        if (character != NO_CHARACTER) setRequiredCharacter(character);
+      }
+    } else {
+      Serial.println(F("NFCAmiiboPuzzle: Enroll failed (allowlist full?)"));
+    }
+    _learnRole = NfcRole::NONE;
+  }
+
   Adafruit_PN532 _nfc;
+  uint8_t _irqPin, _resetPin;
+  bool _detectPending = false;
+  uint32_t _detectStartedAt = 0;
+  uint16_t _recoveries = 0;
+  RfState _rfState = RfState::OFF;  // No field until the first InListPassiveTarget
+  uint32_t _rfSince = 0;
+  uint32_t _rfMs[3] = {0, 0, 0};  // Time spent per RfState
+  uint8_t _powerDownFailures = 0;
+  uint32_t _powerDownRetryAt = 0;
   State _state;
   bool _solved;
   uint32_t _stateTimer;
   
-  uint8_t _targetUID[10];   // Target Goomba UID
-  uint8_t _targetUIDLen;
+  UidAllowlist _allowlist;  // Accepted tags and their roles (EEPROM)
+  uint16_t _charAddr;       // EEPROM: magic, character hi, lo
+  uint16_t _requiredChar = NO_CHARACTER;
+  CacheEntry _cache[CACHE_SIZE] = {};  // UID -> character, skips page reads on re-presentation
+  uint8_t _cacheNext = 0;
+
+  uint16_t _pollIntervalMs = POLL_FAST_MS;
+  uint32_t _nextPollAt = 0;
+  uint32_t _lastActivityAt = 0;
+  uint32_t _polls = 0;
+  NfcRole _learnRole = NfcRole::NONE;
+  uint32_t _learnStartedAt = 0;
+  NfcRole _pendingAction = NfcRole::NONE;
   
   uint8_t _lastUID[10];     // Last seen UID for debouncing
   uint8_t _lastUIDLen;
@@ -11,4 +11,6 @@ public:
   virtual const __FlashStringHelper* name() const = 0;
   // optional PWM level for the puzzle's LED (0..255). Return <0 to let the manager do HIGH/LOW.
   virtual int ledBrightness() const { return -1; }
+  // optional: the shared MCP23017 was reset (brown-out); reapply its pin setup, game state is kept
+  virtual void restoreHardware() {}
 };
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <Servo.h>
 #include <Adafruit_MCP23X17.h>
 #include "Puzzle.h"
+#include "LatencyProbe.h"
 
 template<size_t N>
 class PuzzleManager {
@@ -32,11 +33,9 @@ public:
       return;
     }
     
-    // Configure pins A3-A7 as outputs for puzzle status LEDs
-    for (uint8_t pin = 3; pin <= 7; pin++) {
-      _mcp.pinMode(pin, OUTPUT);
-      _mcp.digitalWrite(pin, HIGH);  // Active LOW: HIGH = LED OFF
-    }
+    _ledLatch = 0xFF;                // Active LOW: HIGH = LED OFF
+    configureLEDs();
+    _ledCheckAt = millis();
     Serial.println(F("  LEDs configured"));
     
     // Initialize puzzles
@@ -54,14 +53,28 @@ public:
     
     _servo.attach(_servoPin);
     lock();
+    startSession();
     Serial.println(F("PuzzleManager: Ready!"));
   }
 
   void update(uint32_t now) {
     uint8_t solvedCount = 0;
+
+    // Loop period statistics (time between consecutive update() calls)
+    const uint32_t us = micros();
+    if (_loopCount > 0) {
+      const uint32_t period = us - _lastUpdateUs;
+      _loopSumUs += period;
+      if (period < _loopMinUs) _loopMinUs = period;
+      if (period > _loopMaxUs) _loopMaxUs = period;
+    }
+    _lastUpdateUs = us;
+    _loopCount++;
     
     for (size_t i = 0; i < N; i++) {
+      const uint32_t t0 = micros();
       _puzzles[i]->update(now);
+      checkUpdateBudget(i, micros() - t0);
       const bool solved = _puzzles[i]->isSolved();
 
       // Debug puzzle state changes
@@ -74,6 +87,7 @@ public:
         Serial.print(F("): "));
         Serial.println(solved ? F("SOLVED!") : F("Reset"));
         prevSolved[i] = solved;
+        if (solved) _solvedAt[i] = now - _sessionStart;
       }
 
       // Update puzzle LED - check if puzzle wants custom control
@@ -88,6 +102,11 @@ public:
 
       if (solved) solvedCount++;
     }
+
+    if ((now - _ledCheckAt) >= LED_CHECK_MS) checkLEDPort(now);
+
+    // One port A write per tick at most, and only when an LED actually changed
+    flushLEDs();
     
     // Check if all puzzles are solved
     if (!_allSolved && solvedCount == N) {
@@ -104,12 +123,68 @@ public:
       _puzzles[i]->reset();
       setLED(i, false);
     }
+    _ledLatchWritten = ~_ledLatch;   // Rewrite even if unchanged, in case the expander lost it
+    flushLEDs();
     lock();
+    startSession();
     Serial.println(F("All puzzles reset, box locked"));
   }
 
   bool allSolved() const { return _allSolved; }
 
+  // Restart the solve clock (called on begin/reset and when the key is turned back on).
+  // Also restarts the loop window, so the dormant or blocking time before it is not a loop period.
+  void startSession() {
+    _sessionStart = millis();
+    for (size_t i = 0; i < N; i++) _solvedAt[i] = 0;
+    resetLoopStats();
+  }
+
+  // Print per-puzzle solve times for this session and loop statistics since the last call
+  void printStats() {
+    Serial.print(F("Session time: "));
+    Serial.print((millis() - _sessionStart) / 1000);
+    Serial.println(F(" s"));
+    for (size_t i = 0; i < N; i++) {
+      Serial.print(F("  P"));
+      Serial.print(i);
+      Serial.print(F(" ("));
+      Serial.print(_puzzles[i]->name());
+      Serial.print(F("): "));
+      if (_solvedAt[i] == 0) {
+        Serial.println(F("unsolved"));
+      } else {
+        Serial.print(F("solved at "));
+        Serial.print(_solvedAt[i]);
+        Serial.println(F(" ms"));
+      }
+    }
+
+    Serial.print(F("Max update() us:"));
+    for (size_t i = 0; i < N; i++) {
+      Serial.print(' ');
+      Serial.print(_maxUpdateUs[i]);
+      _maxUpdateUs[i] = 0;
+    }
+    Serial.println();
+
+    Serial.print(F("Loop: "));
+    Serial.print(_loopCount);
+    Serial.print(F(" ticks"));
+    if (_loopCount > 1) {
+      Serial.print(F(", period min/avg/max "));
+      Serial.print(_loopMinUs);
+      Serial.print('/');
+      Serial.print((uint32_t)(_loopSumUs / (_loopCount - 1)));
+      Serial.print('/');
+      Serial.print(_loopMaxUs);
+      Serial.print(F(" us"));
+    }
+    Serial.println();
+
+    resetLoopStats();
+  }
+
   void testLEDs() {
     Serial.println(F("Testing puzzle status LEDs..."));
     
@@ -121,12 +196,14 @@ public:
       Serial.print(_puzzles[i]->name());
       Serial.println(F(") ON"));
       setLED(i, true);
+      flushLEDs();
       delay(500);
       
       Serial.print(F("  LED "));
       Serial.print(i);
       Serial.println(F(" OFF"));
       setLED(i, false);
+      flushLEDs();
       delay(300);
     }
     
@@ -137,6 +214,7 @@ public:
     for (size_t i = 0; i < N; i++) {
       setLED(i, true);
     }
+    flushLEDs();
     delay(1000);
     
     // Test all LEDs off
@@ -144,6 +222,7 @@ public:
     for (size_t i = 0; i < N; i++) {
       setLED(i, false);
     }
+    flushLEDs();
     
     Serial.println(F("LED test complete"));
   }
@@ -165,6 +244,7 @@ public:
       Serial.print(_unlockedAngle);
       Serial.println(F(")"));
       _servo.write(_unlockedAngle);
+      LatencyProbe::feedback();
       _currentAngle = _unlockedAngle;
       delay(500);
     }
@@ -175,13 +255,74 @@ public:
     return &_mcp;
   }
 
+  Servo* getServo() {
+    return &_servo;
+  }
+
 private:
+  // Updates the shadow latch only; flushLEDs() pushes it to the MCP23017
   void setLED(size_t index, bool state) {
     if (index >= 5) return;   // Only 5 LEDs supported (A3-A7)
     
-    uint8_t pin = index + 3;  // Map puzzle index 0-4 to MCP pins A3-A7
+    const uint8_t bit = 1 << (index + 3);  // Map puzzle index 0-4 to MCP pins A3-A7
     // Active LOW LEDs: LOW = LED ON, HIGH = LED OFF
-    _mcp.digitalWrite(pin, state ? LOW : HIGH);
+    if (state) _ledLatch &= ~bit;
+    else       _ledLatch |= bit;
+  }
+
+  // Start a fresh loop measurement window; the first update() after it only takes a timestamp
+  void resetLoopStats() {
+    _loopCount = 0;
+    _loopSumUs = 0;
+    _loopMinUs = 0xFFFFFFFF;
+    _loopMaxUs = 0;
+  }
+
+  // Track the slowest update() per puzzle and warn when a new worst case blows the tick budget
+  void checkUpdateBudget(size_t index, uint32_t elapsedUs) {
+    if (elapsedUs <= _maxUpdateUs[index]) return;
+    _maxUpdateUs[index] = elapsedUs;
+    if (elapsedUs > UPDATE_BUDGET_US) {
+      Serial.print(F("WARNING: P"));
+      Serial.print(index);
+      Serial.print(F(" ("));
+      Serial.print(_puzzles[index]->name());
+      Serial.print(F(") update() took "));
+      Serial.print(elapsedUs);
+      Serial.println(F(" us"));
+    }
+  }
+
+  // Configure pins A3-A7 as outputs for puzzle status LEDs and write the latch to them
+  void configureLEDs() {
+    for (uint8_t pin = 3; pin <= 7; pin++) {
+      _mcp.pinMode(pin, OUTPUT);
+    }
+    _mcp.writeGPIOA(_ledLatch);
+    _ledLatchWritten = _ledLatch;
+  }
+
+  // The shadow latch assumes the chip keeps its state. A brown-out or glitch resets it to all
+  // inputs, so read IODIRA (2 transfers) now and then. If the LED outputs are gone the whole chip
+  // was reset: restore the LEDs and let the puzzles on port B reapply their pin setup.
+  void checkLEDPort(uint32_t now) {
+    _ledCheckAt = now;
+    Wire.beginTransmission(_mcpAddr);
+    Wire.write((uint8_t)0x00);       // IODIRA
+    if (Wire.endTransmission(false) != 0) return;
+    if (Wire.requestFrom((int)_mcpAddr, 1) != 1) return;
+    if ((Wire.read() & 0xF8) == 0) return;
+    Serial.println(F("WARNING: MCP23017 lost its configuration, restoring it"));
+    configureLEDs();
+    for (size_t i = 0; i < N; i++) _puzzles[i]->restoreHardware();
+  }
+
+  // Write port A in a single transaction if the shadow latch differs from the chip.
+  // Port A only carries the status LEDs (A0-A2 are unused inputs), so no read-modify-write is needed.
+  void flushLEDs() {
+    if (_ledLatch == _ledLatchWritten) return;
+    _mcp.writeGPIOA(_ledLatch);
+    _ledLatchWritten = _ledLatch;
   }
 
 private:
@@ -195,4 +336,18 @@ private:
   // MCP23017 for puzzle status LEDs and future puzzle I/O
   uint8_t _mcpAddr;
   Adafruit_MCP23X17 _mcp;
+  uint8_t _ledLatch = 0xFF;         // Desired port A output state (all LEDs off)
+  uint8_t _ledLatchWritten = 0xFF;  // Last value written to the chip
+  uint32_t _ledCheckAt = 0;
+  static constexpr uint32_t LED_CHECK_MS = 1000;   // IODIRA check period
+
+  // Session / loop statistics
+  uint32_t _sessionStart = 0;
+  uint32_t _solvedAt[N]{};          // ms since session start, 0 = unsolved
+  uint32_t _loopCount = 0;
+  uint32_t _lastUpdateUs = 0;
+  uint64_t _loopSumUs = 0;          // 32 bits would wrap after ~71 min without a STATS call
+  uint32_t _loopMinUs = 0xFFFFFFFF, _loopMaxUs = 0;
+  uint32_t _maxUpdateUs[N]{};       // Worst update() duration per puzzle since last STATS
+  static constexpr uint32_t UPDATE_BUDGET_US = 20000;  // One puzzle should never stall the loop longer
 };
\ No newline at end of file
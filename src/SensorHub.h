@@ -0,0 +1,429 @@
+#pragma once
+#include <Arduino.h>
+#include <Wire.h>
+
+// ADXL345 I2C Address (default with SDO/ALT grounded)
+#define ADXL345_ADDR 0x53
+
+// ADXL345 Registers
+#define ADXL345_REG_THRESH_ACT 0x24
+#define ADXL345_REG_THRESH_INACT 0x25
+#define ADXL345_REG_TIME_INACT 0x26
+#define ADXL345_REG_ACT_INACT_CTL 0x27
+#define ADXL345_REG_BW_RATE 0x2C
+#define ADXL345_REG_POWER_CTL 0x2D
+#define ADXL345_REG_INT_ENABLE 0x2E
+#define ADXL345_REG_INT_SOURCE 0x30
+#define ADXL345_REG_DATA_FORMAT 0x31
+#define ADXL345_REG_DATAX0 0x32
+#define ADXL345_REG_FIFO_CTL 0x38
+#define ADXL345_REG_FIFO_STATUS 0x39
+
+// Sensor axis direction; also names the box face the axis points out of.
+enum class AccelAxis : uint8_t {
+  X_POS, X_NEG,
+  Y_POS, Y_NEG,
+  Z_POS, Z_NEG
+};
+
+// One accelerometer sample: raw LSB (3.9 mg, full-res +-16g), sample time and the tick it was read in
+struct AccelSample {
+  int16_t x, y, z;
+  uint32_t us;   // micros() at which the sensor took the sample (back-dated from the FIFO read)
+  uint32_t ms;   // millis() of the tick that delivered it
+};
+
+// Anything that wants the accelerometer stream
+class AccelSubscriber {
+public:
+  virtual ~AccelSubscriber() {}
+  virtual void onAccelSample(const AccelSample& sample) = 0;
+  // Return true to keep the sensor at its full rate (e.g. in the middle of a knock sequence)
+  virtual bool wantsHighRate() const { return false; }
+  // Return true while the first impulse after a still period matters (e.g. a knock puzzle waiting
+  // for its opening knock): the box then idles at RESPONSIVE_IDLE_RATE without low-power mode
+  virtual bool wantsResponsiveIdle() const { return false; }
+};
+
+// Owns the ADXL345: initialises it, reads each FIFO batch once per tick and publishes every
+// sample to all subscribers, so the sensor is read once however many puzzles consume it.
+class SensorHub {
+public:
+  // ADXL345 output data rates (BW_RATE codes)
+  enum class Rate : uint8_t {
+    HZ_25 = 0x08,
+    HZ_50 = 0x09,
+    HZ_100 = 0x0A,
+    HZ_200 = 0x0B,
+    HZ_400 = 0x0C
+  };
+
+  static constexpr uint8_t MAX_SUBSCRIBERS = 4;
+  static constexpr int16_t LSB_PER_G = 256;  // Full resolution: 3.9 mg/LSB
+
+  void begin() {
+    Wire.begin();
+    if (!initADXL345()) {
+      Serial.println(F("[Accel] ERROR: ADXL345 initialization failed!"));
+      return;
+    }
+    Serial.println(F("[Accel] ADXL345 initialized"));
+    calibrate();
+    _ready = true;
+  }
+
+  bool ready() const { return _ready; }
+
+  // Box is being handled: the sensor is at its active rate after an activity event
+  bool active() const { return _activeMode; }
+
+  // Register a consumer of the sample stream. Returns false when the subscriber table is full.
+  bool subscribe(AccelSubscriber* subscriber) {
+    for (uint8_t i = 0; i < _subscriberCount; i++) {
+      if (_subscribers[i] == subscriber) return true;
+    }
+    if (_subscriberCount >= MAX_SUBSCRIBERS) return false;
+    _subscribers[_subscriberCount++] = subscriber;
+    return true;
+  }
+
+  void update(uint32_t now) {
+    if (!_ready || _subscriberCount == 0) return;
+
+    updatePowerMode();
+
+    // Drain the FIFO so every sample at the output data rate is seen, however slow this tick was.
+    // A long tick can leave more than one batch queued; the rest is popped on the next tick.
+    const uint32_t readUs = micros();
+    const uint8_t queued = fifoEntries();
+    const uint8_t entries = queued > MAX_SAMPLES_PER_TICK ? MAX_SAMPLES_PER_TICK : queued;
+    if (!_synced || now - _lastUpdateMs > RESYNC_GAP_MS) {
+      // First tick or a long pause (key off): the last timestamp is stale, restart ordering here
+      _lastSampleUs = readUs - (uint32_t)queued * _samplePeriodUs;
+      _synced = true;
+    }
+    _lastUpdateMs = now;
+
+    AccelSample sample;
+    sample.ms = now;
+    for (uint8_t i = 0; i < entries; i++) {
+      if (!readAcceleration(sample.x, sample.y, sample.z)) {
+        return;  // Read failed, skip the rest of this batch
+      }
+      // Oldest entry comes out first: the newest queued sample is the one at readUs
+      sample.us = readUs - (uint32_t)(queued - 1 - i) * _samplePeriodUs;
+      // Rate changes and read jitter shift the estimate; never date a sample before the last one
+      if ((int32_t)(sample.us - _lastSampleUs) <= 0) {
+        sample.us = _lastSampleUs + 1;
+      }
+      _lastSampleUs = sample.us;
+      for (uint8_t s = 0; s < _subscriberCount; s++) {
+        _subscribers[s]->onAccelSample(sample);
+      }
+    }
+  }
+
+  // Average resting vector measured at begin() (raw LSB)
+  const int16_t* restVector() const { return _rest; }
+
+  /**
+   * Choose the output data rates: the low-power rate used while the box is still, and the
+   * full-power rate used from the first motion until the sensor reports inactivity.
+   * While a subscriber wants a responsive idle, RESPONSIVE_IDLE_RATE replaces the idle rate.
+   * Call before begin().
+   */
+  void setDataRates(Rate idleRate, Rate activeRate) {
+    _idleRate = idleRate;
+    _activeRate = activeRate;
+  }
+
+  /**
+   * Read acceleration data from ADXL345
+   * @param x Output: X-axis acceleration (raw ADC value)
+   * @param y Output: Y-axis acceleration (raw ADC value)
+   * @param z Output: Z-axis acceleration (raw ADC value)
+   * @return true if read successful, false otherwise
+   */
+  bool readAcceleration(int16_t& x, int16_t& y, int16_t& z) {
+    Wire.beginTransmission(ADXL345_ADDR);
+    Wire.write(ADXL345_REG_DATAX0);
+    if (Wire.endTransmission() != 0) {
+      return false;
+    }
+
+    Wire.requestFrom((uint8_t)ADXL345_ADDR, (uint8_t)6);
+    if (Wire.available() < 6) {
+      return false;
+    }
+
+    // Read 6 bytes (2 bytes per axis: X, Y, Z)
+    uint8_t x0 = Wire.read();
+    uint8_t x1 = Wire.read();
+    uint8_t y0 = Wire.read();
+    uint8_t y1 = Wire.read();
+    uint8_t z0 = Wire.read();
+    uint8_t z1 = Wire.read();
+
+    // Combine bytes (little-endian)
+    x = (int16_t)((x1 << 8) | x0);
+    y = (int16_t)((y1 << 8) | y0);
+    z = (int16_t)((z1 << 8) | z0);
+
+    return true;
+  }
+
+  /**
+   * Stream raw ADXL345 samples over serial until any byte is received (KNOCKREC command).
+   * Blocking: the rest of the box is paused while recording.
+   *
+   * Output: a text line "KNOCKREC BEGIN <periodUs>", then binary frames of 9 bytes each:
+   *   0xA5 | dt_us (uint16 LE, sample time since previous frame) | x | y | z (int16 LE, raw LSB)
+   * followed by a text line "KNOCKREC END <frames>". Raw LSB are 3.9 mg (full-res, +-16g).
+   * Samples come from the FIFO, so dt_us is the sample period; 0xFFFF marks a possible gap
+   * where the FIFO filled up before it was read. tools/knock_replay.cpp replays captures
+   * through the knock detector on the host.
+   */
+  void recordSamples() {
+    if (!_ready) {
+      Serial.println(F("[Accel] ERROR: ADXL345 not initialized"));
+      return;
+    }
+
+    while (Serial.available()) Serial.read();  // drop the rest of the command line
+    setDataRate(_activeRate, false);
+    clearFifo();  // Start from the first sample taken after the command
+    Serial.print(F("KNOCKREC BEGIN "));
+    Serial.println(_samplePeriodUs);
+
+    uint32_t frames = 0;
+    while (!Serial.available()) {
+      const uint8_t entries = fifoEntries();
+      // A full FIFO may have dropped samples before this read
+      uint16_t dt16 = entries >= FIFO_DEPTH ? 0xFFFF : (uint16_t)_samplePeriodUs;
+      for (uint8_t i = 0; i < entries; i++) {
+        int16_t x, y, z;
+        if (!readAcceleration(x, y, z)) break;
+
+        uint8_t frame[9] = {
+          RECORD_SYNC,
+          (uint8_t)dt16, (uint8_t)(dt16 >> 8),
+          (uint8_t)x, (uint8_t)((uint16_t)x >> 8),
+          (uint8_t)y, (uint8_t)((uint16_t)y >> 8),
+          (uint8_t)z, (uint8_t)((uint16_t)z >> 8)
+        };
+        Serial.write(frame, sizeof(frame));
+        frames++;
+        dt16 = (uint16_t)_samplePeriodUs;
+      }
+    }
+    while (Serial.available()) Serial.read();
+    clearFifo();  // Don't hand the recording's backlog to the subscribers
+
+    Serial.println();
+    Serial.print(F("KNOCKREC END "));
+    Serial.println(frames);
+  }
+
+  static void printAxis(AccelAxis axis) {
+    static const char axes[] = "XYZ";
+    const uint8_t a = (uint8_t)axis;
+    Serial.print(axes[a >> 1]);
+    Serial.print((a & 1) ? '-' : '+');
+  }
+
+private:
+  // Sampling
+  static constexpr uint8_t MAX_SAMPLES_PER_TICK = 16;   // Bounds the I2C time spent per update()
+  static constexpr uint16_t RESYNC_GAP_MS = 2000;       // Longer than a full FIFO at the slowest rate
+  static constexpr uint8_t CALIBRATION_SAMPLES = 32;
+  static constexpr uint8_t RECORD_SYNC = 0xA5;
+  static constexpr uint8_t FIFO_DEPTH = 32;
+
+  // Activity/inactivity detection (THRESH_* in 62.5 mg/LSB, TIME_INACT in s)
+  static constexpr uint8_t ACTIVITY_THRESHOLD = 4;      // 0.25 g, below the knock threshold
+  static constexpr uint8_t INACTIVITY_THRESHOLD = 2;    // 0.125 g
+  static constexpr uint8_t INACTIVITY_TIME_S = 2;
+  static constexpr uint8_t BW_RATE_LOW_POWER = 0x10;
+  // Idle rate while a subscriber needs the first impulse: the full-power 100 Hz the knock
+  // detector was tuned on. Low-power 50 Hz has ~25 Hz bandwidth and blunts a knock's peak.
+  static constexpr Rate RESPONSIVE_IDLE_RATE = Rate::HZ_100;
+  static constexpr uint8_t FIFO_BYPASS = 0x00;          // FIFO_CTL modes
+  static constexpr uint8_t FIFO_STREAM = 0x80;
+
+  bool _ready = false;
+  AccelSubscriber* _subscribers[MAX_SUBSCRIBERS] = {};
+  uint8_t _subscriberCount = 0;
+  int16_t _rest[3] = {0, 0, LSB_PER_G};
+
+  // Power management
+  Rate _idleRate = Rate::HZ_50;
+  Rate _activeRate = Rate::HZ_200;
+  bool _activeMode = false;          // Between an activity event and the next inactivity event
+  uint8_t _bwRate = 0xFF;            // BW_RATE value last written
+  uint32_t _samplePeriodUs = 10000;  // Period of the current output data rate
+  uint32_t _lastSampleUs = 0;        // Timestamp of the last sample delivered to subscribers
+  uint32_t _lastUpdateMs = 0;
+  bool _synced = false;
+
+  /**
+   * Measure the resting vector by averaging samples while the box is still
+   */
+  void calibrate() {
+    int32_t sum[3] = {0, 0, 0};
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < CALIBRATION_SAMPLES; i++) {
+      delay(_samplePeriodUs / 1000);
+      int16_t x, y, z;
+      if (!readAcceleration(x, y, z)) continue;
+      sum[0] += x; sum[1] += y; sum[2] += z;
+      n++;
+    }
+    if (n == 0) return;
+    for (uint8_t a = 0; a < 3; a++) {
+      _rest[a] = (int16_t)(sum[a] / n);
+    }
+    Serial.print(F("[Accel] Gravity calibrated: "));
+    Serial.print(_rest[0]);
+    Serial.print(',');
+    Serial.print(_rest[1]);
+    Serial.print(',');
+    Serial.print(_rest[2]);
+    Serial.println(F(" LSB"));
+  }
+
+  /**
+   * Number of samples waiting in the ADXL345 FIFO
+   */
+  uint8_t fifoEntries() {
+    uint8_t status;
+    if (!readRegister(ADXL345_REG_FIFO_STATUS, status)) {
+      return 0;
+    }
+    return status & 0x3F;
+  }
+
+  /**
+   * Empty the FIFO: bypass mode discards its contents, then stream mode starts refilling it
+   */
+  void clearFifo() {
+    writeRegister(ADXL345_REG_FIFO_CTL, FIFO_BYPASS);
+    writeRegister(ADXL345_REG_FIFO_CTL, FIFO_STREAM);
+  }
+
+  /**
+   * Switch the output data rate (and low-power bit) and keep the sample period in step
+   */
+  void setDataRate(Rate rate, bool lowPower) {
+    const uint8_t code = (uint8_t)rate;
+    const uint8_t bwRate = code | (lowPower ? BW_RATE_LOW_POWER : 0);
+    if (bwRate == _bwRate) return;
+    if (!writeRegister(ADXL345_REG_BW_RATE, bwRate)) {
+      return;
+    }
+    _bwRate = bwRate;
+    const uint8_t ref = (uint8_t)Rate::HZ_100;
+    _samplePeriodUs = code >= ref ? (10000UL >> (code - ref)) : (10000UL << (ref - code));
+  }
+
+  /**
+   * Follow the sensor's activity/inactivity events: full rate from the first motion, idle rate
+   * once it has been still for INACTIVITY_TIME_S (unless a subscriber objects)
+   */
+  void updatePowerMode() {
+    uint8_t source;
+    if (!readRegister(ADXL345_REG_INT_SOURCE, source)) {  // Reading clears the latched events
+      return;
+    }
+    if ((source & 0x10) && !_activeMode) {  // Activity
+      _activeMode = true;
+      Serial.println(F("[Accel] Activity - full sample rate"));
+    } else if ((source & 0x08) && _activeMode && !anyWants(&AccelSubscriber::wantsHighRate)) {
+      _activeMode = false;  // Inactivity
+      Serial.println(F("[Accel] Inactive - idle sample rate"));
+    }
+    // The idle rate follows the subscribers (a solved knock puzzle releases the responsive idle)
+    if (_activeMode) {
+      setDataRate(_activeRate, false);
+    } else if (anyWants(&AccelSubscriber::wantsResponsiveIdle)) {
+      setDataRate(RESPONSIVE_IDLE_RATE, false);
+    } else {
+      setDataRate(_idleRate, true);
+    }
+  }
+
+  bool anyWants(bool (AccelSubscriber::*wants)() const) const {
+    for (uint8_t i = 0; i < _subscriberCount; i++) {
+      if ((_subscribers[i]->*wants)()) return true;
+    }
+    return false;
+  }
+
+  bool writeRegister(uint8_t reg, uint8_t value) {
+    Wire.beginTransmission(ADXL345_ADDR);
+    Wire.write(reg);
+    Wire.write(value);
+    return Wire.endTransmission() == 0;
+  }
+
+  bool readRegister(uint8_t reg, uint8_t& value) {
+    Wire.beginTransmission(ADXL345_ADDR);
+    Wire.write(reg);
+    if (Wire.endTransmission() != 0) {
+      return false;
+    }
+    Wire.requestFrom((uint8_t)ADXL345_ADDR, (uint8_t)1);
+    if (!Wire.available()) {
+      return false;
+    }
+    value = Wire.read();
+    return true;
+  }
+
+  /**
+   * Initialize ADXL345 accelerometer
+   * @return true if successful, false otherwise
+   */
+  bool initADXL345() {
+    // Check device ID (should be 0xE5)
+    uint8_t deviceId;
+    if (!readRegister(0x00, deviceId)) {
+      return false;
+    }
+    if (deviceId != 0xE5) {
+      Serial.print(F("[Accel] Unexpected device ID: 0x"));
+      Serial.println(deviceId, HEX);
+      return false;
+    }
+
+    // Set data format: ±16g range, full resolution
+    if (!writeRegister(ADXL345_REG_DATA_FORMAT, 0x0B)) {
+      return false;
+    }
+
+    // FIFO in stream mode: keeps the latest 32 samples so none are lost between ticks
+    if (!writeRegister(ADXL345_REG_FIFO_CTL, FIFO_STREAM)) {
+      return false;
+    }
+
+    // Activity/inactivity detection, AC-coupled on all axes, latched in INT_SOURCE
+    if (!writeRegister(ADXL345_REG_THRESH_ACT, ACTIVITY_THRESHOLD) ||
+        !writeRegister(ADXL345_REG_THRESH_INACT, INACTIVITY_THRESHOLD) ||
+        !writeRegister(ADXL345_REG_TIME_INACT, INACTIVITY_TIME_S) ||
+        !writeRegister(ADXL345_REG_ACT_INACT_CTL, 0xFF) ||
+        !writeRegister(ADXL345_REG_INT_ENABLE, 0x18)) {  // Activity + inactivity
+      return false;
+    }
+
+    // Start at the full rate for calibration; the first inactivity event drops to the idle rate
+    _activeMode = true;
+    setDataRate(_activeRate, false);
+
+    // Enable measurement mode
+    if (!writeRegister(ADXL345_REG_POWER_CTL, 0x08)) {
+      return false;
+    }
+
+    delay(10);  // Wait for sensor to stabilize
+    return true;
+  }
+};
@@ -3,13 +3,21 @@
 #include <Wire.h>
 #include <TM1637Display.h>
 #include "Puzzle.h"
+#include "LatencyProbe.h"
+#include "Debouncer.h"
+#include "DisplayCompositor.h"
 
 // Calculator-style code entry with rightmost "cursor" driven by 7 toggles on a PCF8574.
 // - P0..P6 control 7-segment display segments a..g
 // - P7 is the button input (to GND, with internal pull-up)
 // - Cursor always shows live segments on rightmost digit
 // - Button press: shift stored digits left, stuff snapshot into the stored tail (visual "double")
-// - On 4th press: evaluate code; success -> celebrate + lock solid, failure -> angry flash + 0000 + reset
+// - On the last digit (codeLength): evaluate; success -> celebrate + lock solid, failure -> angry flash + 0000 + reset
+// Codes are packed BCD (one nibble per digit, 0x9197 = "9197"); several may be accepted if the sketch
+// lists more than one. Entered digits shift through a packed BCD ring of the same width
+// and are checked against every code without early exit.
+// Display output goes through a DisplayCompositor (stored digits, blinking cursor, animation
+// overlay, brightness), flushed once per tick and only when the frame changed.
 class SevenSegCodePuzzle : public Puzzle {
 public:
   SevenSegCodePuzzle(
@@ -17,10 +25,18 @@ public:
     uint8_t pinCLK, uint8_t pinDIO,
     // PCF8574 I2C address (e.g., 0x20 with A0/A1/A2 to GND)
     uint8_t pcfAddr,
-    // Correct 4-digit code
-    int correctCode
+    // Accepted codes, packed BCD, codeLength digits each
+    const uint16_t* codes, uint8_t numCodes, uint8_t codeLength = 4
   )
-  : _display(pinCLK, pinDIO), _pcfAddr(pcfAddr), _correct(correctCode) {}
+  : _display(pinCLK, pinDIO), _frame(_display), _pcfAddr(pcfAddr),
+    _codes(codes), _numCodes(numCodes),
+    _codeLength(codeLength >= 1 && codeLength <= MAX_CODE_LENGTH ? codeLength : MAX_CODE_LENGTH),
+    _inputs(DEBOUNCE_MS) {}
+
+  // True if code is packed BCD with at most length digits (usable in static_assert)
+  static constexpr bool isValidCode(uint16_t code, uint8_t length) {
+    return length == 0 ? code == 0 : (code & 0x0F) <= 9 && isValidCode(code >> 4, length - 1);
+  }
 
   void begin() override {
     Serial.println(F("7Seg init"));
@@ -31,16 +47,23 @@ public:
     Wire.write(0xFF); 
     Wire.endTransmission();
 
-    _display.setBrightness(7,true);
-    _display.clear();
-
     // reset model
-    _stored[0]=_stored[1]=_stored[2]=-1;
-    _nStored=0;
-    _cursorOn=true;
-    _lastCursorBlink=millis();
+    clearEntry();
+    resetFrame(millis());
     _state = State::PREVIEW;
     _solved=false;
+    _inputs.reset((uint8_t)~readPort());
+
+    // A code that is not BCD or is longer than codeLength can never be entered
+    for (uint8_t i = 0; i < _numCodes; i++) {
+      if (!isValidCode(_codes[i], _codeLength)) {
+        Serial.print(F("7Seg ERROR: code 0x"));
+        Serial.print(_codes[i], HEX);
+        Serial.print(F(" is not a "));
+        Serial.print(_codeLength);
+        Serial.println(F("-digit BCD code"));
+      }
+    }
     
     Serial.println(F("7Seg OK"));
   }
@@ -48,49 +71,40 @@ public:
   void update(uint32_t now) override {
     if (_state == State::LOCKED) { return; } // solid display, ignore input when solved
 
-    const uint8_t btn = readButtonState();
-    const uint8_t liveMask = readSwitchSegments();
-
-    // edge-debounce for button (falling edge)
-    if (btn != _lastBtn) { _lastChange = now; _lastBtn = btn; }
-    if ((now - _lastChange) >= DEBOUNCE_MS && btn != _stableBtn) {
-      _stableBtn = btn;
-      if (_stableBtn == LOW && _state == State::PREVIEW) {
-        _snapshotMask = liveMask;
-        _state = State::VALIDATE;
-        _stateSince = now;
-      }
-    }
-
-    // cursor blink
-    if (_state == State::PREVIEW && (now - _lastCursorBlink) >= cursorBlinkMs) {
-      _cursorOn = !_cursorOn;
-      _lastCursorBlink = now;
+    // One PCF8574 read per tick: switches drive the live preview undebounced,
+    // the whole port (switches + button) is debounced for the snapshot
+    const uint8_t pressedBits = (uint8_t)~readPort();
+    const uint8_t liveMask = segmentsOf(pressedBits);
+    if (liveMask != _lastLiveMask) { _lastLiveMask = liveMask; LatencyProbe::inputEdge(); }
+
+    _inputs.update(pressedBits, now);
+    if ((_inputs.pressed() & PCF_BUTTON) && _state == State::PREVIEW) {
+      _snapshotMask = segmentsOf(_inputs.state());
+      _state = State::VALIDATE;
+      _stateSince = now;
     }
 
     switch (_state) {
       case State::PREVIEW:
-        renderPreview(liveMask, _cursorOn);
+        _frame.setCursor(3, liveMask);
         break;
 
       case State::VALIDATE: {
         uint8_t d;
         if (maskToDigit(_snapshotMask, d)) {
-          if (_nStored < 3) {
-            // accept: shift stored left, drop snapshot at end
-            _stored[0] = _stored[1];
-            _stored[1] = _stored[2];
-            _stored[2] = (int8_t)d;
-            _nStored++;
-            _cursorOn = true;
-            renderPreview(liveMask, true);
+          // accept: shift the ring left, drop snapshot at the end
+          _entry = (uint16_t)((_entry << 4) | d) & codeMask();
+          _nStored++;
+          if (_nStored < _codeLength) {
+            showStored();
+            _frame.setCursor(3, liveMask);
+            _frame.restartBlink(now);
             _state = State::PREVIEW;
           } else {
-            // 4th accept: evaluate code
-            const int code = buildCodeWith(d);
-            int8_t digits[4]; getCodeDigits(d, digits);
+            // last accept: evaluate code
+            int8_t digits[4]; getCodeDigits(digits);
 
-            if (code == _correct) {
+            if (matchesAnyCode(_entry)) {
               celebrateSuccessAndLock(digits); // sets _state=LOCKED
               _solved = true;
             } else {
@@ -99,10 +113,7 @@ public:
           }
         } else {
           // invalid -> blink rightmost off once
-          uint8_t out[4] = {0,0,0,0};
-          for (uint8_t i=0;i<3;i++) if (_stored[i] >= 0) out[i] = _display.encodeDigit(_stored[i]);
-          out[3] = 0x00;
-          _display.setSegments(out);
+          _frame.hideCursor();
           _state = State::INVALID_BLINK;
           _stateSince = now;
         }
@@ -110,9 +121,8 @@ public:
 
       case State::INVALID_BLINK:
         if (now - _stateSince >= INVALID_BLINK_MS) {
-          _cursorOn = true;
-          _lastCursorBlink = now;
-          renderPreview(liveMask, true);
+          _frame.setCursor(3, liveMask);
+          _frame.restartBlink(now);
           _state = State::PREVIEW;
         }
         break;
@@ -121,28 +131,35 @@ public:
         // nothing
         break;
     }
+
+    if (_frame.flush(now)) {
+      LatencyProbe::feedback();
+    }
   }
 
   bool isSolved() const override { return _solved; }
 
   void reset() override {
     // Only reset if not locked (manager may call this)
-    _stored[0]=_stored[1]=_stored[2]=-1;
-    _nStored=0;
-    _cursorOn=true;
-    _lastCursorBlink=millis();
-    _display.setBrightness(7,true);
-    _display.clear();
+    clearEntry();
+    resetFrame(millis());
     _state = State::PREVIEW;
     _solved=false;
+    _inputs.reset((uint8_t)~readPort());  // A button held through the reset is not a press
   }
 
   const __FlashStringHelper* name() const override { return F("TM1637 Safe Dial"); }
 
   // Early display clear for use before full initialization
   void clearDisplay() {
-    _display.setBrightness(7, true);
-    _display.clear();
+    _frame.setBrightness(7);
+    _frame.clear();
+    _frame.flush(millis());
+  }
+
+  // Re-send the frame currently shown (BENCH: times a full 4-digit write without visible change)
+  void rewriteDisplay() {
+    _frame.rewrite();
   }
 
   // ———— Tunables you can change per instance ————
@@ -155,10 +172,18 @@ public:
   uint16_t zeroHoldMs            = 1000;
 
 private:
+  friend struct PuzzleFuzz;   // Host fuzzing checks the state invariants (test/shim/PuzzleFuzz.h)
+
   // ===== pins / deps =====
   TM1637Display _display;
+  DisplayCompositor _frame;
   uint8_t _pcfAddr;
-  int     _correct;
+
+  // ===== codes =====
+  static constexpr uint8_t MAX_CODE_LENGTH = DisplayCompositor::WIDTH;  // 4 nibbles = uint16_t
+  const uint16_t* _codes;
+  uint8_t _numCodes;
+  uint8_t _codeLength;
 
   // ===== timings =====
   static constexpr uint16_t DEBOUNCE_MS       = 35;
@@ -169,20 +194,17 @@ private:
   State _state = State::PREVIEW;
   unsigned long _stateSince = 0;
 
-  // button debounce
-  uint8_t _lastBtn = HIGH, _stableBtn = HIGH;
-  unsigned long _lastChange = 0;
-
-  // cursor blink
-  unsigned long _lastCursorBlink = 0;
-  bool _cursorOn = true;
+  // PCF8574 port debounce (bit set = switch on / button pressed)
+  static constexpr uint8_t PCF_BUTTON = 1 << 7;
+  Debouncer<SymmetricDebounce, 8> _inputs;
 
-  // model: three stored digits (left 3 slots), rightmost is always live preview
-  int8_t _stored[3] = {-1,-1,-1};
+  // model: entered digits as a packed BCD ring (newest in the low nibble), rightmost is always live preview
+  uint16_t _entry = 0;
   uint8_t _nStored = 0;
 
   // snapshot on press
   uint8_t _snapshotMask = 0;
+  uint8_t _lastLiveMask = 0;  // for latency probing of switch changes
 
   // solved flag exposed to manager
   bool _solved = false;
@@ -201,52 +223,64 @@ private:
     SEG_A|SEG_B|SEG_C|SEG_D|SEG_F|SEG_G             // 9
   };
 
-  uint8_t readSwitchSegments() {
+  // Raw PCF8574 port, inputs pulled low when on/pressed; reads as idle (0xFF) on a bus error
+  uint8_t readPort() {
     Wire.requestFrom((int)_pcfAddr, 1);
-    if (!Wire.available()) return 0;
-    uint8_t raw = Wire.read();
-    uint8_t m = 0;
-    if ((raw & (1<<0)) == 0) m |= SEG_A; // P0..P6 → a..g
-    if ((raw & (1<<1)) == 0) m |= SEG_B;
-    if ((raw & (1<<2)) == 0) m |= SEG_C;
-    if ((raw & (1<<3)) == 0) m |= SEG_D;
-    if ((raw & (1<<4)) == 0) m |= SEG_E;
-    if ((raw & (1<<5)) == 0) m |= SEG_F;
-    if ((raw & (1<<6)) == 0) m |= SEG_G;
-    return m;
+    if (!Wire.available()) return 0xFF;
+    return Wire.read();
   }
 
-  uint8_t readButtonState() {
-    Wire.requestFrom((int)_pcfAddr, 1);
-    if (!Wire.available()) return HIGH;
-    uint8_t raw = Wire.read();
-    // Button is on P7 (bit 7), return LOW when pressed (input pulled low)
-    return (raw & (1<<7)) ? HIGH : LOW;
+  // P0..P6 → a..g: same bit order as SEG_A..SEG_G
+  static uint8_t segmentsOf(uint8_t pressedBits) {
+    return pressedBits & (SEG_A|SEG_B|SEG_C|SEG_D|SEG_E|SEG_F|SEG_G);
   }
 
-  static bool maskToDigit(uint8_t mask, uint8_t &dOut) {
-    for (uint8_t d=0; d<10; ++d) if (mask == DIGIT_MASKS[d]) { dOut = d; return true; }
-    return false;
+  // Blank display, full brightness, blinking cursor on the rightmost digit
+  void resetFrame(uint32_t now) {
+    _frame.clear();
+    _frame.setBrightness(7);
+    _frame.setBlink(1 << 3, cursorBlinkMs, now);
+    _frame.flush(now);
   }
 
-  void renderPreview(uint8_t liveMask, bool showPreview) {
-    uint8_t out[4] = {0,0,0,0};
-    for (uint8_t i=0;i<3;i++) if (_stored[i] >= 0) out[i] = _display.encodeDigit(_stored[i]);
-    if (showPreview) out[3] = liveMask;
-    _display.setSegments(out);
+  void clearEntry() {
+    _entry = 0;
+    _nStored = 0;
+  }
+
+  uint16_t codeMask() const {
+    return _codeLength >= 4 ? 0xFFFF : (uint16_t)((1u << (4 * _codeLength)) - 1);
   }
 
-  int buildCodeWith(uint8_t lastDigit) {
-    int v = 0;
-    for (uint8_t i=0;i<3;i++) v = v*10 + (_stored[i] >= 0 ? _stored[i] : 0);
-    return v*10 + lastDigit;
+  // Stored digits into the base layer, right-aligned against the cursor (rightmost position)
+  void showStored() {
+    for (uint8_t i=0;i<3;i++) {
+      const uint8_t age = 2 - i;  // nibble index: position 2 holds the newest digit
+      _frame.setDigit(i, age < _nStored ? _display.encodeDigit((_entry >> (4 * age)) & 0x0F) : 0);
+    }
   }
 
-  void getCodeDigits(uint8_t lastDigit, int8_t out[4]) {
-    out[0] = (_stored[0] >= 0 ? _stored[0] : 0);
-    out[1] = (_stored[1] >= 0 ? _stored[1] : 0);
-    out[2] = (_stored[2] >= 0 ? _stored[2] : 0);
-    out[3] = lastDigit;
+  // Compare against every code with no data-dependent exit or branch
+  bool matchesAnyCode(uint16_t candidate) const {
+    uint8_t matched = 0;
+    for (uint8_t i = 0; i < _numCodes; i++) {
+      const uint32_t diff = (uint16_t)(candidate ^ _codes[i]);
+      matched |= (uint8_t)((diff - 1) >> 31);  // 1 only when diff == 0
+    }
+    return matched != 0;
+  }
+
+  static bool maskToDigit(uint8_t mask, uint8_t &dOut) {
+    for (uint8_t d=0; d<10; ++d) if (mask == DIGIT_MASKS[d]) { dOut = d; return true; }
+    return false;
+  }
+
+  // Entered code right-aligned on the display, -1 = blank position
+  void getCodeDigits(int8_t out[4]) {
+    for (uint8_t i=0;i<4;i++) {
+      const uint8_t age = 3 - i;
+      out[i] = age < _codeLength ? (int8_t)((_entry >> (4 * age)) & 0x0F) : -1;
+    }
   }
 
   void celebrateSuccessAndLock(const int8_t d[4]) {
@@ -257,12 +291,12 @@ private:
         float phase = (millis() - start) / (float)successBreathPeriodMs; // 0..1
         float level = 0.5f - 0.5f * cos(phase * TWO_PI);                 // 0..1
         uint8_t brightness = 1 + (uint8_t)(level * 6);                   // 1..7
-        _display.setBrightness(brightness, true);
+        _frame.setBrightness(brightness);
         renderDigits(d[0], d[1], d[2], d[3]);
         delay(10);
       }
     }
-    _display.setBrightness(7, true);
+    _frame.setBrightness(7);
     renderDigits(d[0], d[1], d[2], d[3]);
     _state = State::LOCKED;
   }
@@ -270,8 +304,9 @@ private:
   void failureRitualAndReset(const int8_t d[4], uint8_t liveMask) {
     // Angry flashes
     for (uint8_t i=0;i<angryFlashes; ++i) {
-      uint8_t blank[4] = {0,0,0,0};
-      _display.setSegments(blank);
+      const uint8_t blank[4] = {0,0,0,0};
+      _frame.setOverlay(blank);
+      _frame.flush(millis());
       delay(angryFlashMs);
       renderDigits(d[0], d[1], d[2], d[3]);
       delay(angryFlashMs);
@@ -280,6 +315,7 @@ private:
     // Rapid per-digit countdown to 0000 (left → right)
     int8_t cur[4] = { d[0], d[1], d[2], d[3] };
     for (uint8_t pos=0; pos<4; ++pos) {
+      if (cur[pos] < 0) continue;  // not part of a shorter code
       for (int val = cur[pos]; val > 0; --val) {
         cur[pos] = val - 1;
         renderDigits(cur[0],cur[1],cur[2],cur[3]);
@@ -291,26 +327,26 @@ private:
     }
 
     // Hold 0000
-    renderDigits(0,0,0,0);
+    renderDigits(cur[0],cur[1],cur[2],cur[3]);
     delay(zeroHoldMs);
 
     // Reset model, resume preview blinking
-    _stored[0]=_stored[1]=_stored[2]=-1;
-    _nStored=0;
-    _display.setBrightness(7,true);
-    _cursorOn=true;
-    _lastCursorBlink=millis();
-    renderPreview(liveMask, true);
+    clearEntry();
+    const uint32_t now = millis();
+    resetFrame(now);
+    _frame.setCursor(3, liveMask);
     _state = State::PREVIEW;
   }
 
+  // Animation frame: full-width overlay, sent right away (animations block the loop)
   void renderDigits(const int8_t d0, const int8_t d1, const int8_t d2, const int8_t d3) {
     uint8_t out[4] = {0,0,0,0};
     if (d0 >= 0) out[0] = _display.encodeDigit(d0);
     if (d1 >= 0) out[1] = _display.encodeDigit(d1);
     if (d2 >= 0) out[2] = _display.encodeDigit(d2);
     if (d3 >= 0) out[3] = _display.encodeDigit(d3);
-    _display.setSegments(out);
+    _frame.setOverlay(out);
+    _frame.flush(millis());
   }
 };
 
@@ -0,0 +1,75 @@
+#pragma once
+#include <Arduino.h>
+#include "SensorHub.h"
+
+// "Box was shaken/dropped" alarm fed by the SensorHub sample stream.
+// - Drop: total acceleration near zero (free fall) for FREEFALL_MS
+// - Shake: at least SHAKE_SAMPLES samples above SHAKE_G within SHAKE_WINDOW_MS
+// Integer only: compares squared magnitudes in raw LSB. Events are logged and counted for STATUS.
+class ShakeAlarm : public AccelSubscriber {
+public:
+  void onAccelSample(const AccelSample& s) override {
+    const uint32_t magSq = (uint32_t)((int32_t)s.x * s.x) + (uint32_t)((int32_t)s.y * s.y) +
+                           (uint32_t)((int32_t)s.z * s.z);
+
+    // Free fall: every axis reads ~0 g while the box is in the air
+    if (magSq < FREEFALL_SQ) {
+      if (!_falling) {
+        _falling = true;
+        _fallStartUs = s.us;
+      } else if (!_fallReported && (s.us - _fallStartUs) >= FREEFALL_MS * 1000UL) {
+        _fallReported = true;
+        _drops++;
+        Serial.println(F("[Alarm] Box DROPPED!"));
+      }
+    } else {
+      _falling = false;
+      _fallReported = false;
+    }
+
+    // Shaking: count hard samples in a rolling window
+    if (magSq > SHAKE_SQ) {
+      if (_shakeCount == 0 || (s.ms - _shakeWindowStart) > SHAKE_WINDOW_MS) {
+        _shakeWindowStart = s.ms;
+        _shakeCount = 0;
+      }
+      if (_shakeCount < 0xFF) _shakeCount++;
+      if (_shakeCount == SHAKE_SAMPLES && (_shakes == 0 || (s.ms - _lastShakeAt) > SHAKE_COOLDOWN_MS)) {
+        _shakes++;
+        _lastShakeAt = s.ms;
+        Serial.println(F("[Alarm] Box is being SHAKEN!"));
+      }
+    }
+  }
+
+  void reset() {
+    _drops = 0;
+    _shakes = 0;
+    _shakeCount = 0;
+    _falling = false;
+    _fallReported = false;
+  }
+
+  void printStatus() const {
+    Serial.print(F("  Alarms: "));
+    Serial.print(_drops);
+    Serial.print(F(" drop(s), "));
+    Serial.print(_shakes);
+    Serial.println(F(" shake(s)"));
+  }
+
+private:
+  static constexpr uint32_t G_SQ = (uint32_t)SensorHub::LSB_PER_G * SensorHub::LSB_PER_G;
+  static constexpr uint32_t FREEFALL_SQ = G_SQ / 9;      // below ~0.33 g
+  static constexpr uint32_t SHAKE_SQ = G_SQ * 4;         // above 2 g
+  static constexpr uint32_t FREEFALL_MS = 60;            // ~2 cm of free fall
+  static constexpr uint32_t SHAKE_WINDOW_MS = 1000;
+  static constexpr uint8_t SHAKE_SAMPLES = 20;
+  static constexpr uint32_t SHAKE_COOLDOWN_MS = 5000;
+
+  bool _falling = false, _fallReported = false;
+  uint32_t _fallStartUs = 0;
+  uint8_t _shakeCount = 0;
+  uint32_t _shakeWindowStart = 0, _lastShakeAt = 0;
+  uint16_t _drops = 0, _shakes = 0;
+};
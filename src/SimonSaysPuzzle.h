@@ -3,15 +3,20 @@
 #include <Wire.h>
 #include <Adafruit_MCP23X17.h>
 #include "Puzzle.h"
+#include "LatencyProbe.h"
+#include "Debouncer.h"
 
 // Simon Says puzzle with 3 rounds of melodies
 // 4 buttons (B0-B3) with corresponding LEDs (B4-B7) on MCP23017
 // Buzzer on Arduino pin 5
 // Each round plays a different melody sequence that players must copy
+// Optional procedural mode: rounds are generated by an xorshift PRNG seeded per game from ADC noise,
+// start timing and caller-supplied entropy. Only the seed and a generator cursor are stored, so RAM
+// use is the same at any sequence length.
 class SimonSaysPuzzle : public Puzzle {
 public:
   SimonSaysPuzzle(Adafruit_MCP23X17* mcp, uint8_t buzzerPin) 
-    : _mcp(mcp), _buzzerPin(buzzerPin) {}
+    : _mcp(mcp), _buzzerPin(buzzerPin), _buttons(DEBOUNCE_MS) {}
 
   void begin() override {
     if (_mcp == nullptr) {
@@ -26,25 +31,25 @@ public:
     // Initialize puzzle state first
     reset();
     
-    // Configure pins B0-B3 as inputs (buttons), B4-B7 as outputs (LEDs)
-    for (int i = 8; i <= 11; i++) { // B0-B3 (pins 8-11)
-      _mcp->pinMode(i, INPUT_PULLUP);
-    }
-    for (int i = 12; i <= 15; i++) { // B4-B7 (pins 12-15)
-      _mcp->pinMode(i, OUTPUT);
-      _mcp->digitalWrite(i, HIGH);     // LEDs off (active low)
-    }
-    
+    configurePins();
     Serial.println(F("Simon Says B pins configured"));
     
     pinMode(_buzzerPin, OUTPUT);
     digitalWrite(_buzzerPin, LOW);
     noTone(_buzzerPin);  // Ensure tone generator is off
     
+    if (_noisePin != NO_PIN) {
+      pinMode(_noisePin, INPUT);  // Left floating: the ADC LSBs are noise
+    }
+    
     Serial.println(F("Simon Says puzzle initialized"));
-    Serial.println(F("Round 1: Zie ginds komt de stoomboot"));
-    Serial.println(F("Round 2: Sinterklaas kapoentje")); 
-    Serial.println(F("Round 3: O, kom er eens kijken"));
+    if (_procLength > 0) {
+      printMode();
+    } else {
+      Serial.println(F("Round 1: Zie ginds komt de stoomboot"));
+      Serial.println(F("Round 2: Sinterklaas kapoentje")); 
+      Serial.println(F("Round 3: O, kom er eens kijken"));
+    }
   }
 
   void update(uint32_t now) override {
@@ -56,8 +61,11 @@ public:
     switch (_state) {
       case State::WAITING_TO_START:
         // Check if buttons 1, 2, and 4 are pressed simultaneously to start the game
-        if (_buttonState[0] && _buttonState[1] && _buttonState[3]) { // Buttons 1, 2, 4 (indices 0, 1, 3)
+        if ((_buttons.state() & START_CHORD) == START_CHORD) { // Buttons 1, 2, 4 (indices 0, 1, 3)
           Serial.println(F("Buttons 1, 2, 4 pressed simultaneously - Simon Says starting! Get ready..."));
+          if (_procLength > 0 && _currentRound == 0) {
+            _newSession();
+          }
           _playStartChime();
           _state = State::IDLE;
           _stateTimer = now;
@@ -101,6 +109,7 @@ public:
     _sequenceIndex = 0;
     _playerIndex = 0;
     _currentLength = 1;  // Start with just the first note
+    _cursor.index = 0;
     _timeoutCount = 0;   // Reset timeout counter
     _state = State::WAITING_TO_START;
     _stateTimer = millis();
@@ -114,12 +123,8 @@ public:
     }
     
     // Initialize button states
-    for (int i = 0; i < 4; i++) {
-      _buttonState[i] = false;
-      _lastRawState[i] = false;
-      _lastPressedState[i] = false;
-      _buttonChangeTime[i] = 0;
-    }
+    _buttons.reset(0);
+    _handled = 0;
     
     Serial.println(F("Simon Says puzzle reset"));
     if (_mcpInitialized) {
@@ -129,11 +134,51 @@ public:
 
   const __FlashStringHelper* name() const override { return F("Simon Says"); }
 
+  void restoreHardware() override {
+    if (_mcpInitialized) configurePins();  // LEDs come back with the next playback step
+  }
+
   // Set the MCP reference (called after PuzzleManager initializes MCP)
   void setMCP(Adafruit_MCP23X17* mcp) {
     _mcp = mcp;
   }
 
+  static constexpr uint8_t NO_PIN = 0xFF;
+
+  // Generate every round instead of playing the songs: length steps (1-255) drawn from the buttons
+  // in buttonMask (bit i = button i), with at most maxRepeat equal steps in a row (0 = no limit).
+  // length 0 returns to the songs. Call before begin() or follow with reset().
+  void useProceduralSequences(uint8_t length, uint8_t buttonMask = 0x0F, uint8_t maxRepeat = 2) {
+    buttonMask &= 0x0F;
+    if (buttonMask == 0) buttonMask = 0x0F;
+    _procLength = length;
+    _procMask = buttonMask;
+    _procMaxRepeat = maxRepeat;
+  }
+
+  // Unconnected analog pin sampled for seed noise at the start of every procedural game
+  void setNoisePin(uint8_t pin) { _noisePin = pin; }
+
+  // Fold extra entropy (e.g. accelerometer jitter) into the next session seed
+  void addEntropy(uint32_t value) {
+    _entropy = (_entropy << 7 | _entropy >> 25) ^ value;
+  }
+
+  void printMode() {
+    if (_procLength == 0) {
+      Serial.println(F("Simon Says: songs"));
+      return;
+    }
+    Serial.print(F("Simon Says: procedural, length "));
+    Serial.print(_procLength);
+    Serial.print(F(", buttons 0x"));
+    Serial.print(_procMask, HEX);
+    Serial.print(F(", max repeat "));
+    Serial.print(_procMaxRepeat);
+    Serial.print(F(", seed 0x"));
+    Serial.println(_sessionSeed, HEX);
+  }
+
   // Test all Simon Says LEDs in sequence
   void testLEDs() {
     if (!_mcpInitialized) {
@@ -176,6 +221,8 @@ public:
   }
 
 private:
+  friend struct PuzzleFuzz;   // Host fuzzing checks the state invariants (test/shim/PuzzleFuzz.h)
+
   enum class State {
     WAITING_TO_START,
     IDLE,
@@ -224,12 +271,11 @@ private:
   uint8_t _currentLength = 1;       // Current build-up length (starts at 1, grows to full sequence)
   uint8_t _timeoutCount = 0;        // Number of consecutive timeouts (resets puzzle after 4)
   
-  // Button debouncing - simplified approach
-  bool _buttonState[4] = {false};           // Current debounced state
-  bool _lastRawState[4] = {false};          // Last raw read for change detection
-  bool _lastPressedState[4] = {false};      // Last state we checked for press
-  uint32_t _buttonChangeTime[4] = {0};      // Time of last state change
-  static const uint32_t DEBOUNCE_MS = 5;    // Very fast debounce - aggressive for responsiveness
+  // Button debouncing: presses pass immediately, releases are debounced (bit i = button i)
+  static const uint16_t DEBOUNCE_MS = 5;    // Very fast debounce - aggressive for responsiveness
+  static const uint8_t START_CHORD = 0x0B;  // Buttons 1, 2 and 4
+  Debouncer<FastPressDebounce, 4> _buttons;
+  uint8_t _handled = 0;                     // Presses already acted on, cleared on release
   
   // Timing
   static const uint32_t NOTE_DURATION = 400;  // How long each note/LED plays
@@ -237,33 +283,32 @@ private:
   static const uint32_t INPUT_TIMEOUT = 5000; // 5 seconds to make a move
   uint32_t _inputTimer = 0;
 
+  // Procedural mode
+  uint8_t _procLength = 0;          // Steps per round, 0 = play the songs
+  uint8_t _procMask = 0x0F;         // Buttons the generator may use
+  uint8_t _procMaxRepeat = 2;       // Longest run of one button, 0 = unlimited
+  uint8_t _noisePin = NO_PIN;
+  uint32_t _entropy = 0;            // Caller-supplied entropy pool
+  uint32_t _sessionSeed = 1;        // Drawn at the start of each game, rounds derive from it
+  
+  // Generator position in the current round: steps [0, index) have been produced
+  struct StepCursor {
+    uint32_t state;
+    uint8_t index;
+    uint8_t last;   // Step index - 1
+    uint8_t run;    // Consecutive steps equal to last
+  };
+  StepCursor _cursor = {1, 0, 0, 0};
+
   void _updateButtons(uint32_t now) {
-    for (int i = 0; i < 4; i++) {
-      bool rawState = !_mcp->digitalRead(i + 8); // B0-B3 are pins 8-11, Active low (pullup)
-      
-      // Detect state change
-      if (rawState != _lastRawState[i]) {
-        _lastRawState[i] = rawState;
-        _buttonChangeTime[i] = now;
-        
-        // Accept button PRESS immediately (rising edge) for max responsiveness
-        if (rawState && !_buttonState[i]) {
-          _buttonState[i] = true;
-        }
-      }
-      
-      // Use debounce only for releases to prevent false positives
-      if ((now - _buttonChangeTime[i]) >= DEBOUNCE_MS) {
-        bool oldState = _buttonState[i];
-        _buttonState[i] = rawState;
-        
-        // Clear the "pressed" flag when button is released
-        // This allows the same button to be pressed again
-        if (oldState && !rawState) {
-          _lastPressedState[i] = false;
-        }
-      }
+    // One port read for all four buttons: B0-B3, active low (pullup)
+    const uint8_t raw = (uint8_t)~_mcp->readGPIOB() & 0x0F;
+    _buttons.update(raw, now);
+    if (_buttons.pressed()) {
+      LatencyProbe::inputEdge();
     }
+    // A release allows the same button to be pressed again
+    _handled &= ~_buttons.released();
   }
 
   void _startRound() {
@@ -282,7 +327,6 @@ private:
   }
 
   void _playSequenceStep(uint32_t now) {
-    const uint8_t* sequence = _getCurrentSequence();
     // Use current build-up length instead of full sequence
     uint8_t sequenceLength = _currentLength;
     
@@ -292,7 +336,7 @@ private:
     if (elapsed < NOTE_DURATION) {
       // Play note and show LED
       if (_sequenceIndex < sequenceLength) {
-        uint8_t button = sequence[_sequenceIndex];
+        uint8_t button = _stepAt(_sequenceIndex);
         _playNote(button);
         _setLED(button, true);
       }
@@ -345,20 +389,21 @@ private:
   bool _buttonPressed(int button) {
     // Detect rising edge: button is pressed now AND wasn't pressed in last check
     // Only check the edge, don't update state here
-    return _buttonState[button] && !_lastPressedState[button];
+    return (_buttons.state() & ~_handled) & (1 << button);
   }
 
   void _handleButtonPress(int button, uint32_t now) {
-    const uint8_t* sequence = _getCurrentSequence();
     // Use current build-up length instead of full sequence
     uint8_t sequenceLength = _currentLength;
+    const uint8_t expected = _stepAt(_playerIndex);
     
     // Mark as handled FIRST to prevent double-triggering during feedback
-    _lastPressedState[button] = true;
+    _handled |= 1 << button;
     
     // Visual and audio feedback
     _playNote(button);
     _setLED(button, true);
+    LatencyProbe::feedback();
     
     // Continue updating buttons during feedback delay to catch releases
     uint32_t feedbackStart = millis();
@@ -370,7 +415,7 @@ private:
     _allLedsOff();
     noTone(_buzzerPin);
     
-    if (button == sequence[_playerIndex]) {
+    if (button == expected) {
       // Correct button
       _playerIndex++;
       _inputTimer = now; // Reset timeout
@@ -387,7 +432,7 @@ private:
       // Wrong button
       _timeoutCount = 0; // Reset timeout counter on any input (even wrong)
       Serial.print(F("Wrong! Expected button "));
-      Serial.print(sequence[_playerIndex]);
+      Serial.print(expected);
       Serial.print(F(", got "));
       Serial.print(button);
       Serial.println(F(" - repeating sequence..."));
@@ -451,6 +496,7 @@ private:
   void _nextRound() {
     _currentRound++;
     _currentLength = 1;  // Reset build-up length for new round
+    _cursor.index = 0;   // Next round has its own generated sequence
     
     if (_currentRound >= 3) {
       _solved = true;
@@ -480,6 +526,7 @@ private:
   }
 
   uint8_t _getCurrentSequenceLength() {
+    if (_procLength > 0) return _procLength;
     switch (_currentRound) {
       case 0: return _round1Length;
       case 1: return _round2Length;
@@ -488,6 +535,72 @@ private:
     }
   }
 
+  // Button expected at step i of the current round
+  uint8_t _stepAt(uint8_t i) {
+    if (_procLength == 0) return _getCurrentSequence()[i];
+    // Playback and input both walk forwards, so the cursor usually just advances;
+    // going back (replay, next build-up pass) regenerates from the round seed
+    if (_cursor.index == 0 || i + 1 < _cursor.index) {
+      _restartCursor();
+    }
+    while (_cursor.index <= i) {
+      _generateStep();
+    }
+    return _cursor.last;
+  }
+
+  void _restartCursor() {
+    // Spread the round number over the whole word so rounds don't start from correlated states
+    uint32_t s = _sessionSeed ^ (0x9E3779B9UL * (uint32_t)(_currentRound + 1));
+    if (s == 0) s = 1;  // xorshift never leaves zero
+    for (uint8_t i = 0; i < 4; i++) _xorshift(s);
+    _cursor.state = s;
+    _cursor.index = 0;
+    _cursor.run = 0;
+  }
+
+  void _generateStep() {
+    const uint32_t r = _xorshift(_cursor.state);
+    uint8_t allowed = _procMask;
+    if (_procMaxRepeat > 0 && _cursor.run >= _procMaxRepeat && (allowed & ~(1 << _cursor.last))) {
+      allowed &= ~(1 << _cursor.last);
+    }
+    uint8_t n = 0;
+    for (uint8_t b = 0; b < 4; b++) n += (allowed >> b) & 1;
+    // Scale the top byte to [0, n) with a multiply instead of a division
+    uint8_t k = (uint8_t)(((uint16_t)(r >> 24) * n) >> 8);
+    uint8_t button = 0;
+    for (; button < 4; button++) {
+      if ((allowed & (1 << button)) && k-- == 0) break;
+    }
+    _cursor.run = (_cursor.index > 0 && button == _cursor.last) ? _cursor.run + 1 : 1;
+    _cursor.last = button;
+    _cursor.index++;
+  }
+
+  static uint32_t _xorshift(uint32_t& s) {
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+  }
+
+  // New seed for a game: floating-pin ADC noise, the start chord's microsecond timing and the pool
+  void _newSession() {
+    uint32_t s = _entropy ^ micros();
+    if (_noisePin != NO_PIN) {
+      for (uint8_t i = 0; i < 16; i++) {
+        s = (s << 2 | s >> 30) ^ (uint32_t)analogRead(_noisePin);
+      }
+    }
+    if (s == 0) s = 1;
+    for (uint8_t i = 0; i < 8; i++) _xorshift(s);
+    _sessionSeed = s;
+    _cursor.index = 0;
+    Serial.print(F("Simon Says: session seed 0x"));
+    Serial.println(_sessionSeed, HEX);
+  }
+
   void _playNote(uint8_t button) {
     Note note;
     switch (_currentRound) {
@@ -528,6 +641,17 @@ private:
     noTone(_buzzerPin);
   }
 
+  // Configure pins B0-B3 as inputs (buttons), B4-B7 as outputs (LEDs)
+  void configurePins() {
+    for (int i = 8; i <= 11; i++) { // B0-B3 (pins 8-11)
+      _mcp->pinMode(i, INPUT_PULLUP);
+    }
+    for (int i = 12; i <= 15; i++) { // B4-B7 (pins 12-15)
+      _mcp->pinMode(i, OUTPUT);
+      _mcp->digitalWrite(i, HIGH);     // LEDs off (active low)
+    }
+  }
+
   void _setLED(uint8_t button, bool on) {
     if (button < 4) {
       _mcp->digitalWrite(button + 12, on ? LOW : HIGH); // B4-B7 are pins 12-15, Active low LEDs
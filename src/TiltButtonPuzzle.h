@@ -1,57 +1,106 @@
 #pragma once
 #include <Arduino.h>
 #include "Puzzle.h"
+#include "LatencyProbe.h"
+#include "SensorHub.h"
+#include "Debouncer.h"
 
 // Tilt sensor puzzle - solved when tilt sensor is triggered for 10 seconds.
 // LED: OFF when inactive, BLINKING during countdown, ON when solved.
 // Wiring: one leg -> GND, other -> pin (INPUT_PULLUP). activeLow=false means HIGH == active (right-side up).
-class TiltButtonPuzzle : public Puzzle {
+// Optional orientation mode: the ADXL345 (via SensorHub) replaces the switch with an angle threshold.
+// Optional pin-change mode (D0-D7): an ISR timestamps every edge and runs an integrating debouncer
+// on them, so chatter only delays activation by the time it spends inactive and the hold countdown
+// starts at the exact debounced activation time, independent of the loop rate.
+class TiltButtonPuzzle : public Puzzle, public AccelSubscriber {
 public:
   TiltButtonPuzzle(uint8_t pin, bool activeLow = true,
                    uint16_t debounceMs = 30, uint16_t holdMs = 10000)
   : _pin(pin), _activeLow(activeLow),
-    _debounceMs(debounceMs), _holdMs(holdMs) {}
+    _debounceMs(debounceMs), _holdMs(holdMs), _debounce(debounceMs) {}
 
   void begin() override {
-    pinMode(_pin, INPUT_PULLUP);
-    _solved = false;
-    uint32_t now = millis();
-    _last = digitalRead(_pin);
-    _stable = !_last;  // Force initial state evaluation by making stable different
-    _tEdge = now;
-    _tStartActive = now;
-    _lastCountdownOutput = 0;
-    _active = false;
+    if (_hub != nullptr) {
+      if (_hub->ready()) {
+        _hub->subscribe(this);
+      } else {
+        Serial.println(F("Tilt: accelerometer not available, using tilt switch"));
+        _hub = nullptr;
+      }
+    }
+    if (_hub == nullptr) pinMode(_pin, INPUT_PULLUP);
+    if (_hub != nullptr && _pcint) {
+      _pcint = false;  // Orientation mode has no pin to watch
+    }
+    if (_pcint) {
+      _inReg = portInputRegister(digitalPinToPort(_pin));
+      _bitMask = digitalPinToBitMask(_pin);
+      _isrInstance = this;
+    }
+    reset();
+    if (_pcint) {
+      *digitalPinToPCMSK(_pin) |= _BV(digitalPinToPCMSKbit(_pin));
+      PCIFR = _BV(PCIF2);   // Drop a change latched before we were ready
+      PCICR |= _BV(PCIE2);
+    }
+  }
+
+  // Watch the pin with the PCINT2 (D0-D7) interrupt instead of polling it. Call before begin().
+  // The sketch owns the vector: ISR(PCINT2_vect) { TiltButtonPuzzle::pinChangeISR(); }
+  void usePinChangeInterrupt() {
+    if (digitalPinToPCICRbit(_pin) != PCIE2) {
+      Serial.println(F("Tilt: pin-change mode needs a pin on D0-D7, polling instead"));
+      return;
+    }
+    _pcint = true;
+  }
+
+  // Called from ISR(PCINT2_vect): fold the elapsed time into the integrator, then take the edge
+  void onPinChange() {
+    const bool level = ((*_inReg & _bitMask) != 0) != _activeLow;
+    if (level == _edges.level) {
+      return;  // Another pin on the port changed
+    }
+    integrate(_edges, millis());
+    _edges.level = level;
+    if (level) _edges.count++;
+  }
+
+  static void pinChangeISR() {
+    if (_isrInstance != nullptr) _isrInstance->onPinChange();
   }
 
   void update(uint32_t now) override {
     if (!_solved) {
-      // Debounce + hold logic
-      int r = digitalRead(_pin);
-      if (r != _last) { 
-        _last = r; 
-        _tEdge = now;
-      }
-      
-      if ((now - _tEdge) >= _debounceMs && r != _stable) {
-        _stable = r;
-        bool wasActive = _active;
-        _active = isActive(_stable);
-        
-        if (_active && !wasActive) {
-          // Just became active - start countdown
-          _tStartActive = now;
-          _lastCountdownOutput = 0;
-          Serial.println(F("Tilt sensor activated! Hold for 10 seconds..."));
-        } else if (!_active && wasActive) {
-          // Just became inactive
-          Serial.println(F("Tilt sensor deactivated"));
+      if (_pcint) {
+        // Snapshot the ISR state (cli/sei are compiler barriers), then integrate up to now
+        EdgeState s;
+        noInterrupts();
+        s = _edges;
+        interrupts();
+        integrate(s, now);
+        if (s.count != _lastEdgeCount) {
+          _lastEdgeCount = s.count;
+          LatencyProbe::inputEdge();
+        }
+        setActive(s.stable, s.since);
+      } else {
+        // Debounce + hold logic
+        const bool r = isActive(readLevel());
+        if (r != _last) {
+          _last = r;
+          if (r) LatencyProbe::inputEdge();  // Only activation has feedback (the LED starts blinking)
+        }
+        _debounce.update(r, now);
+        if (_debounce.pressed() || _debounce.released()) {
+          setActive(_debounce.state(), now);
         }
       }
       
       // If active, show countdown and check completion
       if (_active) {
-        uint32_t elapsed = now - _tStartActive;
+        // An ISR running after now was sampled can date the activation later than now
+        uint32_t elapsed = (int32_t)(now - _tStartActive) > 0 ? now - _tStartActive : 0;
         uint32_t remaining = (_holdMs > elapsed) ? (_holdMs - elapsed) : 0;
         
         // Show countdown every second
@@ -77,16 +126,52 @@ public:
   void reset() override {
     _solved = false;
     uint32_t now = millis();
-    _last = digitalRead(_pin);
-    _stable = !_last;  // Force initial state evaluation
-    _tEdge = now;
+    _last = false;
+    _debounce.reset(0);  // Start inactive: an already active input activates after the debounce
     _tStartActive = now;
     _lastCountdownOutput = 0;
     _active = false;
+    if (_pcint) {
+      // Start inactive with an empty integrator; the current level integrates from now
+      noInterrupts();
+      _edges.level = isActive(digitalRead(_pin));
+      _edges.stable = false;
+      _edges.integ = 0;
+      _edges.edgeAt = now;
+      _edges.since = now;
+      interrupts();
+    }
   }
 
   const __FlashStringHelper* name() const override { return F("Tilt Sensor"); }
 
+  // Use the accelerometer instead of the tilt switch: active while upAxis points up within
+  // maxAngleDeg of vertical (released again beyond maxAngleDeg + 5). Call before begin().
+  void useOrientation(SensorHub* hub, AccelAxis upAxis, uint8_t maxAngleDeg = 30) {
+    _hub = hub;
+    _upAxis = upAxis;
+    // Angle thresholds become squared-cosine ratios (Q8) so the per-sample test is integer only
+    const float on = cos(maxAngleDeg * DEG_TO_RAD);
+    const float off = cos((maxAngleDeg + 5) * DEG_TO_RAD);
+    _cosSqOnQ8 = (uint16_t)(on * on * 256);
+    _cosSqOffQ8 = (uint16_t)(off > 0 ? off * off * 256 : 0);
+  }
+
+  // Low-pass the sample stream to a gravity vector and test its angle to the up axis
+  void onAccelSample(const AccelSample& s) override {
+    const int16_t raw[3] = {s.x, s.y, s.z};
+    int32_t magSq = 0;
+    for (uint8_t a = 0; a < 3; a++) {
+      _g[a] += (raw[a] - _g[a]) >> 3;
+      magSq += (int32_t)_g[a] * _g[a];
+    }
+    const uint8_t axis = (uint8_t)_upAxis;
+    const int32_t up = (axis & 1) ? -_g[axis >> 1] : _g[axis >> 1];
+    // angle <= limit  <=>  up > 0 && up^2 >= |g|^2 * cos^2(limit)
+    const uint16_t cosSq = _tiltUp ? _cosSqOffQ8 : _cosSqOnQ8;
+    _tiltUp = up > 0 && ((up * up) << 8) >= magSq * cosSq;
+  }
+
   // LED control: blink when active (countdown running), solid when solved, off when inactive
   int ledBrightness() const override {
     if (_solved) {
@@ -101,8 +186,65 @@ public:
   }
 
 private:
+  // Edge-driven debouncer state, written by the ISR
+  struct EdgeState {
+    bool level = false;    // Raw pin is active (polarity applied)
+    bool stable = false;   // Debounced state
+    uint16_t integ = 0;    // ms integrated towards active, 0.._debounceMs
+    uint32_t edgeAt = 0;   // millis() up to which integ is current
+    uint32_t since = 0;    // millis() at which stable last became active
+    uint16_t count = 0;    // Activating edges seen (latency probe)
+  };
+
+  // Integrate the current level from s.edgeAt to t: +dt while active, -dt while inactive.
+  // The ISR may have stamped an edge after the loop sampled t: nothing to integrate then.
+  void integrate(EdgeState& s, uint32_t t) const {
+    if ((int32_t)(t - s.edgeAt) <= 0) return;
+    const uint32_t dt = t - s.edgeAt;
+    if (s.level) {
+      if (s.integ + dt >= _debounceMs) {
+        if (!s.stable) {
+          s.stable = true;
+          s.since = s.edgeAt + (_debounceMs - s.integ);  // Exact moment the integrator filled
+        }
+        s.integ = _debounceMs;
+      } else {
+        s.integ += dt;
+      }
+    } else if (dt >= s.integ) {
+      s.integ = 0;
+      s.stable = false;
+    } else {
+      s.integ -= dt;
+    }
+    s.edgeAt = t;
+  }
+
+  void setActive(bool active, uint32_t since) {
+    if (active == _active) {
+      return;
+    }
+    _active = active;
+    if (_active) {
+      // Just became active - start countdown
+      _tStartActive = since;
+      _lastCountdownOutput = 0;
+      LatencyProbe::feedback();  // LED starts blinking on this tick
+      Serial.println(F("Tilt sensor activated! Hold for 10 seconds..."));
+    } else {
+      // Just became inactive
+      Serial.println(F("Tilt sensor deactivated"));
+    }
+  }
+
   bool isActive(int level) const { return _activeLow ? (level == LOW) : (level == HIGH); }
 
+  // Raw input level: the tilt switch, or the orientation test mapped onto the same polarity
+  int readLevel() const {
+    if (_hub == nullptr) return digitalRead(_pin);
+    return (_tiltUp != _activeLow) ? HIGH : LOW;
+  }
+
   // Configuration
   uint8_t  _pin;
   bool     _activeLow;
@@ -110,7 +252,25 @@ private:
 
   // Runtime state
   bool     _solved = false, _active = false;
-  int      _last = HIGH, _stable = HIGH;
-  uint32_t _tEdge = 0, _tStartActive = 0;
+  bool     _last = false;  // Raw active state, for the latency probe
+  Debouncer<SymmetricDebounce, 1> _debounce;
+  uint32_t _tStartActive = 0;
   uint32_t _lastCountdownOutput = 0;
-};
\ No newline at end of file
+
+  // Orientation mode
+  SensorHub* _hub = nullptr;
+  AccelAxis _upAxis = AccelAxis::Z_POS;
+  uint16_t _cosSqOnQ8 = 0, _cosSqOffQ8 = 0;
+  int16_t _g[3] = {0, 0, SensorHub::LSB_PER_G};  // Low-passed gravity (raw LSB)
+  bool _tiltUp = false;
+
+  // Pin-change mode
+  bool _pcint = false;
+  volatile uint8_t* _inReg = nullptr;
+  uint8_t _bitMask = 0;
+  EdgeState _edges;
+  uint16_t _lastEdgeCount = 0;
+  static TiltButtonPuzzle* _isrInstance;
+};
+
+TiltButtonPuzzle* TiltButtonPuzzle::_isrInstance = nullptr;
\ No newline at end of file
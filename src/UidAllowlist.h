@@ -0,0 +1,206 @@
+#pragma once
+#include <Arduino.h>
+#include <EEPROM.h>
+
+// What a tag does when presented to the NFC puzzle
+enum class NfcRole : uint8_t {
+  NONE = 0,
+  SOLVE = 1,         // Solves the NFC puzzle
+  HINT = 2,          // Prints the puzzles still open
+  ADMIN_RESET = 3    // Resets all puzzles (game master tag)
+};
+
+// EEPROM-backed NFC UID allowlist (4, 7 or 10 byte UIDs) with a role per entry.
+// Entries live in a fixed open-addressing hash table directly in EEPROM, so lookups cost one
+// or two slot reads however full the list is and no RAM is spent on a copy.
+// Layout at eepromBase: magic (2), version (1), reserved (1), then CAPACITY slots of
+// [len][role][uid x 10]. len 0 = empty slot, TOMBSTONE = deleted slot.
+class UidAllowlist {
+public:
+  static constexpr uint8_t CAPACITY = 16;              // Power of two (hash mask)
+  static constexpr uint8_t MAX_UID_LEN = 10;
+  static constexpr uint16_t EEPROM_SIZE = 4 + CAPACITY * (2 + MAX_UID_LEN);
+
+  explicit UidAllowlist(uint16_t eepromBase = 0) : _base(eepromBase) {}
+
+  // Validate the stored table; returns false if it was blank/foreign and has been formatted
+  bool begin() {
+    if (EEPROM.read(_base) == MAGIC0 && EEPROM.read(_base + 1) == MAGIC1 &&
+        EEPROM.read(_base + 2) == VERSION) {
+      return true;
+    }
+    Serial.println(F("[NFC] Allowlist not found in EEPROM, formatting"));
+    clear();
+    return false;
+  }
+
+  void clear() {
+    EEPROM.update(_base, MAGIC0);
+    EEPROM.update(_base + 1, MAGIC1);
+    EEPROM.update(_base + 2, VERSION);
+    EEPROM.update(_base + 3, 0);
+    for (uint8_t s = 0; s < CAPACITY; s++) EEPROM.update(slotAddr(s), EMPTY);
+  }
+
+  // Role of a UID, NfcRole::NONE if it is not on the list
+  NfcRole lookup(const uint8_t* uid, uint8_t len) const {
+    const int8_t s = find(uid, len);
+    return s < 0 ? NfcRole::NONE : (NfcRole)EEPROM.read(slotAddr(s) + 1);
+  }
+
+  // Insert a UID or change the role of an existing entry. Returns false if invalid or full.
+  bool add(const uint8_t* uid, uint8_t len, NfcRole role) {
+    if (!validLength(len) || role == NfcRole::NONE) return false;
+    int8_t s = find(uid, len);
+    if (s < 0) {
+      s = freeSlot(uid, len);
+      if (s < 0) return false;
+      const uint16_t addr = slotAddr(s);
+      for (uint8_t i = 0; i < len; i++) EEPROM.update(addr + 2 + i, uid[i]);
+      EEPROM.update(addr + 1, (uint8_t)role);
+      EEPROM.update(addr, len);  // Length last: a torn write leaves the slot unused
+    } else {
+      EEPROM.update(slotAddr(s) + 1, (uint8_t)role);
+    }
+    return true;
+  }
+
+  bool remove(const uint8_t* uid, uint8_t len) {
+    const int8_t s = find(uid, len);
+    if (s < 0) return false;
+    EEPROM.update(slotAddr(s), TOMBSTONE);  // Keeps probe chains through this slot intact
+    return true;
+  }
+
+  uint8_t count() const {
+    uint8_t n = 0;
+    for (uint8_t s = 0; s < CAPACITY; s++) {
+      if (validLength(EEPROM.read(slotAddr(s)))) n++;
+    }
+    return n;
+  }
+
+  // Whether any entry has this role
+  bool contains(NfcRole role) const {
+    for (uint8_t s = 0; s < CAPACITY; s++) {
+      const uint16_t addr = slotAddr(s);
+      if (validLength(EEPROM.read(addr)) && EEPROM.read(addr + 1) == (uint8_t)role) return true;
+    }
+    return false;
+  }
+
+  void print() const {
+    Serial.print(F("NFC allowlist: "));
+    Serial.print(count());
+    Serial.print('/');
+    Serial.println(CAPACITY);
+    uint8_t uid[MAX_UID_LEN];
+    for (uint8_t s = 0; s < CAPACITY; s++) {
+      const uint16_t addr = slotAddr(s);
+      const uint8_t len = EEPROM.read(addr);
+      if (!validLength(len)) continue;
+      for (uint8_t i = 0; i < len; i++) uid[i] = EEPROM.read(addr + 2 + i);
+      Serial.print(F("  "));
+      printUID(uid, len);
+      Serial.print(' ');
+      printRole((NfcRole)EEPROM.read(addr + 1));
+      Serial.println();
+    }
+  }
+
+  static bool validLength(uint8_t len) { return len == 4 || len == 7 || len == 10; }
+
+  static void printUID(const uint8_t* uid, uint8_t len) {
+    for (uint8_t i = 0; i < len; i++) {
+      if (uid[i] < 0x10) Serial.print('0');
+      Serial.print(uid[i], HEX);
+      if (i + 1 < len) Serial.print(':');
+    }
+  }
+
+  static void printRole(NfcRole role) {
+    switch (role) {
+      case NfcRole::SOLVE: Serial.print(F("SOLVE")); break;
+      case NfcRole::HINT: Serial.print(F("HINT")); break;
+      case NfcRole::ADMIN_RESET: Serial.print(F("ADMIN")); break;
+      default: Serial.print(F("NONE")); break;
+    }
+  }
+
+  // "SOLVE", "HINT" or "ADMIN"; anything else is NfcRole::NONE
+  static NfcRole parseRole(const String& s) {
+    if (s == "SOLVE") return NfcRole::SOLVE;
+    if (s == "HINT") return NfcRole::HINT;
+    if (s == "ADMIN") return NfcRole::ADMIN_RESET;
+    return NfcRole::NONE;
+  }
+
+  // Hex UID with optional ':' separators ("04:A6:89:72:3C:4D:80" or "04A689723C4D80").
+  // Returns the length, or 0 if the text is not a 4/7/10 byte UID.
+  static uint8_t parseUID(const String& s, uint8_t* out) {
+    uint8_t len = 0;
+    int8_t hi = -1;
+    for (unsigned int i = 0; i < s.length(); i++) {
+      const char c = s[i];
+      if (c == ':') continue;
+      int8_t v;
+      if (c >= '0' && c <= '9') v = c - '0';
+      else if (c >= 'A' && c <= 'F') v = c - 'A' + 10;
+      else if (c >= 'a' && c <= 'f') v = c - 'a' + 10;
+      else return 0;
+      if (hi < 0) {
+        hi = v;
+      } else {
+        if (len == MAX_UID_LEN) return 0;
+        out[len++] = (uint8_t)((hi << 4) | v);
+        hi = -1;
+      }
+    }
+    return (hi < 0 && validLength(len)) ? len : 0;
+  }
+
+private:
+  static constexpr uint8_t MAGIC0 = 'S', MAGIC1 = 'N', VERSION = 1;
+  static constexpr uint8_t EMPTY = 0x00, TOMBSTONE = 0xFE;
+  static constexpr uint8_t SLOT_SIZE = 2 + MAX_UID_LEN;
+
+  uint16_t slotAddr(uint8_t slot) const { return _base + 4 + (uint16_t)slot * SLOT_SIZE; }
+
+  // 8-bit FNV-1a style hash over the UID bytes, folded to a slot index
+  static uint8_t hash(const uint8_t* uid, uint8_t len) {
+    uint8_t h = 0xC5;
+    for (uint8_t i = 0; i < len; i++) h = (h ^ uid[i]) * 0x93;
+    return h & (CAPACITY - 1);
+  }
+
+  bool slotMatches(uint16_t addr, const uint8_t* uid, uint8_t len) const {
+    for (uint8_t i = 0; i < len; i++) {
+      if (EEPROM.read(addr + 2 + i) != uid[i]) return false;
+    }
+    return true;
+  }
+
+  // Linear probe from the hash slot until the UID or an empty slot is found
+  int8_t find(const uint8_t* uid, uint8_t len) const {
+    if (!validLength(len)) return -1;
+    uint8_t s = hash(uid, len);
+    for (uint8_t n = 0; n < CAPACITY; n++, s = (s + 1) & (CAPACITY - 1)) {
+      const uint16_t addr = slotAddr(s);
+      const uint8_t slotLen = EEPROM.read(addr);
+      if (slotLen == EMPTY) return -1;
+      if (slotLen == len && slotMatches(addr, uid, len)) return s;
+    }
+    return -1;
+  }
+
+  // First empty or deleted slot on the UID's probe chain
+  int8_t freeSlot(const uint8_t* uid, uint8_t len) const {
+    uint8_t s = hash(uid, len);
+    for (uint8_t n = 0; n < CAPACITY; n++, s = (s + 1) & (CAPACITY - 1)) {
+      if (!validLength(EEPROM.read(slotAddr(s)))) return s;
+    }
+    return -1;
+  }
+
+  uint16_t _base;
+};
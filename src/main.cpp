@@ -8,6 +8,10 @@
 #include "SimonSaysPuzzle.h"
 #include "NFCAmiiboPuzzle.h"
 #include "KnockDetectionPuzzle.h"
+#include "SensorHub.h"
+#include "ShakeAlarm.h"
+#include "LatencyProbe.h"
+#include "Debouncer.h"
 
 // ---- Hardware Configuration ----
 // 7-Segment Display (TM1637)
@@ -19,8 +23,13 @@ constexpr uint8_t PCF_ADDR = 0x25;      // PCF8574 for 7-segment switches (P0-P6
 constexpr uint8_t MCP_LED_ADDR = 0x20;  // MCP23017 for puzzle status LEDs (A3-A7) AND Simon Says (B0-B7)
 
 // Puzzle Configuration
-constexpr int SAFE_CODE = 9197;         // Correct code for 7-segment puzzle
+constexpr uint8_t SAFE_CODE_LENGTH = 4;  // Digits per code (up to the display width)
+constexpr uint16_t SAFE_CODES[] = {      // Accepted codes for 7-segment puzzle, packed BCD
+  0x9197,                                // Main code; add any extra accepted codes below it
+};
 constexpr size_t NUM_PUZZLES = 5;       // 7-segment + tilt + simon + NFC + knock
+constexpr uint16_t KNOCK_RHYTHM_MS[] = {300, 600, 300};  // Secret knock gaps: knock-knock . . knock-knock
+constexpr uint8_t KNOCK_RHYTHM_TOLERANCE = 15;           // Percent of total duration per gap
 
 // Servo Configuration
 const uint8_t SERVO_PIN = 9;
@@ -32,16 +41,47 @@ constexpr uint8_t TILT_PIN = 4;         // Tilt sensor digital input pin
 
 // Simon Says Configuration
 constexpr uint8_t BUZZER_PIN = 5;       // Passive buzzer for Simon Says
+constexpr uint8_t SIMON_NOISE_PIN = A0; // Unconnected analog input, seeds procedural sequences
+constexpr uint8_t SIMON_PROC_LENGTH = 0;  // Steps per generated round, 0 = play the songs
 
 // Key Switch Configuration
 constexpr uint8_t KEY_PIN = 12;         // Key switch (connected to GND, INPUT_PULLUP)
+constexpr uint16_t KEY_DEBOUNCE_MS = 40;
+
+// PN532 handshake lines. Default is I2C-only with status polling: an unwired, floating IRQ pin
+// would break detection. Boxes wired to D6/D8 enable them per build:
+//   build_flags = -DSINTBOX_NFC_IRQ_PIN=6 -DSINTBOX_NFC_RESET_PIN=8
+#ifndef SINTBOX_NFC_IRQ_PIN
+#define SINTBOX_NFC_IRQ_PIN NFCAmiiboPuzzle::NO_PIN
+#endif
+#ifndef SINTBOX_NFC_RESET_PIN
+#define SINTBOX_NFC_RESET_PIN NFCAmiiboPuzzle::NO_PIN
+#endif
+constexpr uint8_t NFC_IRQ_PIN = SINTBOX_NFC_IRQ_PIN;      // PN532 IRQ: LOW when a response is ready
+constexpr uint8_t NFC_RESET_PIN = SINTBOX_NFC_RESET_PIN;  // PN532 RSTPDN: pulsed LOW for a hard reset
+
+// NFC allowlist + required character storage (UidAllowlist::EEPROM_SIZE + 3 bytes)
+constexpr uint16_t NFC_EEPROM_ADDR = 0;
+
+// Latency probe (logic analyser channel, LATENCY command)
+constexpr uint8_t PROBE_PIN = 7;        // HIGH from input edge until feedback is issued
+
+// ADXL345 sample stream, shared by the knock puzzle and the shake/drop alarm
+SensorHub sensorHub;
+ShakeAlarm shakeAlarm;
 
 // Puzzle Instances
-SevenSegCodePuzzle sevenSegPuzzle(TM_CLK, TM_DIO, PCF_ADDR, SAFE_CODE);
+constexpr bool safeCodesValid(const uint16_t* codes, size_t n) {
+  return n == 0 || (SevenSegCodePuzzle::isValidCode(codes[0], SAFE_CODE_LENGTH) && safeCodesValid(codes + 1, n - 1));
+}
+static_assert(safeCodesValid(SAFE_CODES, sizeof(SAFE_CODES) / sizeof(SAFE_CODES[0])),
+              "SAFE_CODES must be packed BCD with at most SAFE_CODE_LENGTH digits");
+SevenSegCodePuzzle sevenSegPuzzle(TM_CLK, TM_DIO, PCF_ADDR, SAFE_CODES,
+                                  sizeof(SAFE_CODES) / sizeof(SAFE_CODES[0]), SAFE_CODE_LENGTH);
 TiltButtonPuzzle tiltPuzzle(TILT_PIN, false, 100, 10000);  // activeLow=false, debounce=100ms, hold=10s
 SimonSaysPuzzle simonPuzzle(nullptr, BUZZER_PIN);          // MCP will be provided after manager initialization
-NFCAmiiboPuzzle nfcPuzzle;                                 // Goomba amiibo recognition (I2C only)
-KnockDetectionPuzzle knockPuzzle(4, 3.5, 3000, 50);       // 4 knocks, threshold=3.5 m/s^2, 3s window, 50ms quiet period
+NFCAmiiboPuzzle nfcPuzzle(NFC_EEPROM_ADDR, NFC_IRQ_PIN, NFC_RESET_PIN);  // Amiibo recognition, EEPROM allowlist
+KnockDetectionPuzzle knockPuzzle(sensorHub, 4, 3.5, 3000, 50);  // 4 knocks, threshold=3.5 m/s^2, 3s window, 50ms quiet period
 
 // Puzzle Array (order determines LED assignment on MCP23017: A3, A4, A5, A6, A7...)
 Puzzle* puzzles[NUM_PUZZLES] = { &sevenSegPuzzle, &tiltPuzzle, &simonPuzzle, &nfcPuzzle, &knockPuzzle };
@@ -49,6 +89,9 @@ Puzzle* puzzles[NUM_PUZZLES] = { &sevenSegPuzzle, &tiltPuzzle, &simonPuzzle, &nf
 // Puzzle Manager with MCP23017-based LED control and servo
 PuzzleManager<NUM_PUZZLES> manager(MCP_LED_ADDR, SERVO_PIN, LOCK_ANGLE, UNLOCK_ANGLE, true);
 
+// Key switch debounce (bit 0 = key on)
+Debouncer<SymmetricDebounce, 1> keySwitch(KEY_DEBOUNCE_MS);
+
 
 
 
@@ -79,6 +122,102 @@ void playStartupJingle() {
   }
 }
 
+// Parse one space-separated unsigned field of a command (no sign, at most maxValue) and advance p
+bool parseField(const char*& p, uint8_t base, uint32_t maxValue, uint32_t& value) {
+  while (*p == ' ') p++;
+  if (!isxdigit(*p)) return false;
+  char* end = nullptr;
+  value = strtoul(p, &end, base);
+  if (end == p || (*end != ' ' && *end != '\0') || value > maxValue) return false;
+  p = end;
+  return true;
+}
+
+// Parse one space-separated decimal field of a command and advance p (toFloat() reads "abc" as 0)
+bool parseFloatField(const char*& p, float& value) {
+  while (*p == ' ') p++;
+  char* end = nullptr;
+  value = (float)strtod(p, &end);
+  if (end == p || (*end != ' ' && *end != '\0')) return false;
+  p = end;
+  return true;
+}
+
+// ---- BENCH: timed microbenchmarks of primitive hardware operations ----
+typedef bool (*BenchOp)();
+static uint8_t benchPortA = 0xFF;  // Port A latch captured before timing writes
+
+void benchOp(const __FlashStringHelper* label, BenchOp op, BenchOp cleanup = nullptr) {
+  const uint8_t iterations = 20;
+  uint32_t minUs = 0xFFFFFFFF, maxUs = 0, sumUs = 0;
+  uint8_t ok = 0;
+  for (uint8_t i = 0; i < iterations; i++) {
+    const uint32_t t0 = micros();
+    const bool success = op();
+    const uint32_t dt = micros() - t0;
+    if (cleanup) cleanup();
+    if (!success) continue;
+    ok++;
+    sumUs += dt;
+    if (dt < minUs) minUs = dt;
+    if (dt > maxUs) maxUs = dt;
+    delay(2);
+  }
+
+  Serial.print(F("  "));
+  Serial.print(label);
+  Serial.print(F(": "));
+  if (ok == 0) {
+    Serial.println(F("FAILED"));
+    return;
+  }
+  Serial.print(minUs);
+  Serial.print('/');
+  Serial.print(sumUs / ok);
+  Serial.print('/');
+  Serial.print(maxUs);
+  Serial.print(F(" us"));
+  if (ok < iterations) {
+    Serial.print(F(" ("));
+    Serial.print(iterations - ok);
+    Serial.print(F(" failed)"));
+  }
+  Serial.println();
+}
+
+void runBenchmarks() {
+  Serial.println(F("Benchmarking hardware operations (min/avg/max, 20 runs each)"));
+  Serial.println(F("Nothing needs to be unplugged. Keep figures off the NFC reader; expect short beeps."));
+
+  benchOp(F("MCP23017 register read"), []() -> bool { manager.getMCP()->readGPIOA(); return true; });
+  benchPortA = manager.getMCP()->readGPIOA();
+  benchOp(F("MCP23017 register write"), []() -> bool { manager.getMCP()->writeGPIOA(benchPortA); return true; });
+  benchOp(F("MCP23017 GPIOAB read"), []() -> bool { manager.getMCP()->readGPIOAB(); return true; });
+  benchOp(F("PCF8574 read"), []() -> bool {
+    Wire.requestFrom((int)PCF_ADDR, 1);
+    if (!Wire.available()) return false;
+    Wire.read();
+    return true;
+  });
+  benchOp(F("ADXL345 6-byte read"), []() -> bool { int16_t x, y, z; return sensorHub.readAcceleration(x, y, z); });
+  benchOp(F("TM1637 4-digit write"), []() -> bool { sevenSegPuzzle.rewriteDisplay(); return true; });
+  benchOp(F("PN532 no-card poll"), []() -> bool { return nfcPuzzle.benchPoll(); });
+  benchOp(F("tone() start"), []() -> bool { tone(BUZZER_PIN, 2000); return true; },
+          []() -> bool { noTone(BUZZER_PIN); return true; });
+  benchOp(F("Servo::write"), []() -> bool {
+    Servo* servo = manager.getServo();
+    servo->write(servo->read());  // Same angle: no movement
+    return true;
+  });
+
+  Serial.println(F("Benchmark complete"));
+}
+
+// Tilt switch edges (setup() enables pin-change mode on D4 = PCINT20)
+ISR(PCINT2_vect) {
+  TiltButtonPuzzle::pinChangeISR();
+}
+
 void setup() {
   Serial.begin(115200);
   delay(1000);
@@ -112,14 +251,33 @@ void setup() {
     delay(50);
   }
   Serial.println(F("Key detected! Initializing system..."));
+  keySwitch.reset(1);
   digitalWrite(LED_BUILTIN, LOW);
  
+  // Accelerometer first: puzzles subscribe to the hub in their begin()
+  sensorHub.begin();
+  sensorHub.subscribe(&shakeAlarm);
+
+  // Accelerometer noise LSBs and their read timing as extra seed material for Simon Says
+  for (uint8_t i = 0; i < 8; i++) {
+    int16_t x, y, z;
+    if (sensorHub.readAcceleration(x, y, z)) {
+      simonPuzzle.addEntropy(((uint32_t)(x ^ y) << 16) ^ (uint16_t)z ^ micros());
+    }
+  }
+
+  tiltPuzzle.usePinChangeInterrupt();  // D4 = PCINT20: timestamped edges instead of per-tick polling
+  knockPuzzle.setPattern(KNOCK_RHYTHM_MS, sizeof(KNOCK_RHYTHM_MS) / sizeof(KNOCK_RHYTHM_MS[0]),
+                         KNOCK_RHYTHM_TOLERANCE);
+
   manager.attach(puzzles);
   manager.begin();
   
   // Provide MCP reference to Simon Says puzzle after manager initializes it
   Adafruit_MCP23X17* mcpPtr = manager.getMCP();
   simonPuzzle.setMCP(mcpPtr);
+  simonPuzzle.setNoisePin(SIMON_NOISE_PIN);
+  simonPuzzle.useProceduralSequences(SIMON_PROC_LENGTH);
   simonPuzzle.begin();
   
   // Play startup jingle
@@ -131,7 +289,8 @@ void loop() {
   uint32_t now = millis();
   
   // Check key switch state and handle OFF state
-  bool keyOn = (digitalRead(KEY_PIN) == LOW);
+  keySwitch.update(digitalRead(KEY_PIN) == LOW, now);
+  bool keyOn = keySwitch.state();
   static bool wasKeyOn = true;  // Assume key was ON after setup completes
   
   if (!keyOn) {
@@ -139,6 +298,7 @@ void loop() {
     if (wasKeyOn) {
       Serial.println(F("Key turned OFF - resetting all state"));
       manager.resetAll();
+      shakeAlarm.reset();
       sevenSegPuzzle.clearDisplay();
       noTone(BUZZER_PIN);
       wasKeyOn = false;
@@ -151,6 +311,7 @@ void loop() {
     // Key is ON - check for OFF->ON transition and play jingle
     if (!wasKeyOn) {
       playStartupJingle();
+      manager.startSession();
       wasKeyOn = true;
     }
     digitalWrite(LED_BUILTIN, LOW);
@@ -170,6 +331,7 @@ void loop() {
     if (command == "RESET") {
       Serial.println(F("*** Manual reset triggered ***"));
       manager.resetAll();
+      shakeAlarm.reset();
     } else if (command == "UNLOCK") {
       Serial.println(F("*** Manual unlock triggered ***"));
       manager.unlock();
@@ -191,19 +353,135 @@ void loop() {
           Serial.println(puzzles[i]->isSolved() ? F("SOLVED") : F("Active"));
         }
       }
+      shakeAlarm.printStatus();
+      nfcPuzzle.printPollStats();
+    } else if (command == "KNOCKREC") {
+      Serial.println(F("*** Recording accelerometer, send any key to stop ***"));
+      sensorHub.recordSamples();
+    } else if (command == "KNOCKCFG") {
+      knockPuzzle.printConfig();
+    } else if (command.startsWith("KNOCKCFG ")) {
+      // KNOCKCFG <threshold m/s^2> <hysteresis 0..1> <quiet ms>
+      const String arg = command.substring(9);
+      const char* p = arg.c_str();
+      float threshold = 0, hysteresis = 0;
+      uint32_t quietMs = 0;
+      const bool ok = parseFloatField(p, threshold) && parseFloatField(p, hysteresis) &&
+                      parseField(p, 10, 0xFFFF, quietMs) && *p == '\0' &&
+                      knockPuzzle.configure(threshold, hysteresis, quietMs);
+      if (!ok) {
+        Serial.println(F("Usage: KNOCKCFG <threshold 0-156.9> <hysteresis 0-1> <quietMs up to the window>"));
+      }
+    } else if (command == "LATENCY ON") {
+      LatencyProbe::enable(PROBE_PIN);
+      Serial.println(F("*** Latency probe enabled on D7 ***"));
+    } else if (command == "LATENCY OFF") {
+      LatencyProbe::disable();
+      Serial.println(F("*** Latency probe disabled ***"));
+    } else if (command == "LATENCY") {
+      LatencyProbe::report();
+    } else if (command == "BENCH") {
+      Serial.println(F("*** Running hardware benchmarks ***"));
+      runBenchmarks();
+    } else if (command == "NFCLIST") {
+      nfcPuzzle.allowlist().print();
+      nfcPuzzle.printRequiredCharacter();
+    } else if (command == "NFCCHAR") {
+      nfcPuzzle.printRequiredCharacter();
+    } else if (command.startsWith("NFCCHAR ")) {
+      // NFCCHAR <hex game/character ID> | NFCCHAR CLEAR (relearn from the next SOLVE tag)
+      const String arg = command.substring(8);
+      char* end = nullptr;
+      const uint32_t id = strtoul(arg.c_str(), &end, 16);
+      if (arg == "CLEAR") {
+        nfcPuzzle.setRequiredCharacter(NFCAmiiboPuzzle::NO_CHARACTER);
+      } else if (arg.length() == 0 || *end != '\0' || id >= NFCAmiiboPuzzle::NO_CHARACTER) {
+        Serial.println(F("Usage: NFCCHAR [<hex id 0000-FFFE>|CLEAR]"));
+      } else {
+        nfcPuzzle.setRequiredCharacter((uint16_t)id);
+      }
+    } else if (command.startsWith("NFCADD ") || command.startsWith("NFCDEL ")) {
+      // NFCADD <uid> [SOLVE|HINT|ADMIN], NFCDEL <uid>
+      const int a = command.indexOf(' ');
+      const int b = command.indexOf(' ', a + 1);
+      uint8_t uid[UidAllowlist::MAX_UID_LEN];
+      const uint8_t len = UidAllowlist::parseUID(command.substring(a + 1, b < 0 ? command.length() : b), uid);
+      const NfcRole role = b < 0 ? NfcRole::SOLVE : UidAllowlist::parseRole(command.substring(b + 1));
+      if (len == 0 || role == NfcRole::NONE) {
+        Serial.println(F("Usage: NFCADD <uid hex> [SOLVE|HINT|ADMIN], NFCDEL <uid hex>"));
+      } else if (command.startsWith("NFCADD")) {
+        Serial.println(nfcPuzzle.allowlist().add(uid, len, role) ? F("Added") : F("Allowlist full"));
+        nfcPuzzle.allowlistChanged(now);
+      } else {
+        Serial.println(nfcPuzzle.allowlist().remove(uid, len) ? F("Removed") : F("Not on allowlist"));
+      }
+    } else if (command == "NFCLEARN" || command.startsWith("NFCLEARN ")) {
+      // NFCLEARN [SOLVE|HINT|ADMIN]: enroll the next presented tag
+      const NfcRole role = command.length() > 9 ? UidAllowlist::parseRole(command.substring(9)) : NfcRole::SOLVE;
+      if (role == NfcRole::NONE) {
+        Serial.println(F("Usage: NFCLEARN [SOLVE|HINT|ADMIN]"));
+      } else {
+        nfcPuzzle.startLearning(role, now);
+      }
+    } else if (command == "STATS") {
+      manager.printStats();
     } else if (command == "LEDTEST") {
       Serial.println(F("*** Testing puzzle status LEDs ***"));
       manager.testLEDs();
     } else if (command == "SIMONTEST") {
       Serial.println(F("*** Testing Simon Says LEDs ***"));
       simonPuzzle.testLEDs();
+    } else if (command == "SIMONGEN") {
+      simonPuzzle.printMode();
+    } else if (command.startsWith("SIMONGEN ")) {
+      // SIMONGEN <length 1-255> [<hex button mask 1-F> [<max repeat>]] | SIMONGEN OFF (back to the songs)
+      const String arg = command.substring(9);
+      const char* p = arg.c_str();
+      uint32_t length = 0, mask = 0x0F, maxRepeat = 2;
+      const bool ok = arg == "OFF" ||
+          (parseField(p, 10, 255, length) && length > 0 &&
+           (*p == '\0' || (parseField(p, 16, 0x0F, mask) && mask > 0)) &&
+           (*p == '\0' || parseField(p, 10, 255, maxRepeat)) && *p == '\0');
+      if (!ok) {
+        Serial.println(F("Usage: SIMONGEN <length 1-255> [<hex mask 1-F> [<max repeat>]] | SIMONGEN OFF"));
+      } else {
+        simonPuzzle.useProceduralSequences((uint8_t)length, (uint8_t)mask, (uint8_t)maxRepeat);
+        if (!simonPuzzle.isSolved()) {
+          simonPuzzle.reset();  // Restart the game in the new mode; a solved Simon stays solved
+        }
+        simonPuzzle.printMode();
+      }
     } else if (command.length() > 0) {
       Serial.print(F("Unknown command: "));
       Serial.println(command);
-      Serial.println(F("Available: RESET, UNLOCK, LOCK, STATUS, LEDTEST, SIMONTEST"));
+      Serial.println(F("Available: RESET, UNLOCK, LOCK, STATUS, STATS, LEDTEST, SIMONTEST, SIMONGEN, KNOCKREC, KNOCKCFG, LATENCY [ON|OFF], BENCH, NFCLIST, NFCADD, NFCDEL, NFCLEARN, NFCCHAR"));
     }
   }
   
-  // Update puzzle manager
+  // Drain the accelerometer FIFO to its subscribers, then update puzzle manager
+  sensorHub.update(now);
+  if (sensorHub.active()) {
+    nfcPuzzle.pollBurst(now);  // Box is being handled, a figure may be on its way
+  }
   manager.update(now);
+
+  // Hint and admin NFC tags act on the whole box
+  switch (nfcPuzzle.takeAction()) {
+    case NfcRole::HINT:
+      Serial.print(F("Hint: still open:"));
+      for (size_t i = 0; i < NUM_PUZZLES; i++) {
+        if (puzzles[i]->isSolved()) continue;
+        Serial.print(' ');
+        Serial.print(puzzles[i]->name());
+      }
+      Serial.println();
+      break;
+    case NfcRole::ADMIN_RESET:
+      Serial.println(F("*** Admin tag reset ***"));
+      manager.resetAll();
+      shakeAlarm.reset();
+      break;
+    default:
+      break;
+  }
 }
\ No newline at end of file
@@ -0,0 +1,19 @@
+// libFuzzer target for the safe dial (checks in test/shim/PuzzleFuzz.h). Build and run from the
+// project root with clang:
+//
+//   clang++ -std=gnu++11 -O1 -fsanitize=fuzzer,address -Isrc -Itest/shim -DUNIT_TEST test/fuzz/fuzz_seven_seg.cpp -o fuzz_seven_seg
+//   mkdir -p corpus_seven_seg && ./fuzz_seven_seg -max_len=1025 corpus_seven_seg
+//
+// A violation prints the step it happened at and aborts, leaving the input in crash-*.
+#include <stdio.h>
+#include <stdlib.h>
+#include "PuzzleFuzz.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  const char* violation = PuzzleFuzz::sevenSeg(data, size);
+  if (violation != nullptr) {
+    fprintf(stderr, "the safe dial: %s\n", violation);
+    abort();
+  }
+  return 0;
+}
@@ -0,0 +1,19 @@
+// libFuzzer target for Simon Says (checks in test/shim/PuzzleFuzz.h). Build and run from the
+// project root with clang:
+//
+//   clang++ -std=gnu++11 -O1 -fsanitize=fuzzer,address -Isrc -Itest/shim -DUNIT_TEST test/fuzz/fuzz_simon.cpp -o fuzz_simon
+//   mkdir -p corpus_simon && ./fuzz_simon -max_len=1025 corpus_simon
+//
+// A violation prints the step it happened at and aborts, leaving the input in crash-*.
+#include <stdio.h>
+#include <stdlib.h>
+#include "PuzzleFuzz.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  const char* violation = PuzzleFuzz::simon(data, size);
+  if (violation != nullptr) {
+    fprintf(stderr, "Simon Says: %s\n", violation);
+    abort();
+  }
+  return 0;
+}
@@ -0,0 +1,140 @@
+#pragma once
+// ADXL345 register model with a sample generator and a 32-entry FIFO.
+// While measuring (POWER_CTL bit 3), one sample per output data period (BW_RATE) is taken as
+// the fake clock passes: the next scripted sample if any, otherwise the resting vector.
+// In stream mode the FIFO keeps the newest 32; a 6-byte read from DATAX0 pops the oldest.
+// INT_SOURCE returns the latched events and clears them.
+#include <deque>
+#include <vector>
+#include <Wire.h>
+
+class ADXL345Model : public I2CDevice {
+public:
+  struct Sample { int16_t x, y, z; };
+
+  static constexpr uint8_t DEVID = 0xE5;
+  static constexpr uint8_t FIFO_DEPTH = 32;
+
+  explicit ADXL345Model(uint8_t address = 0x53) : I2CDevice(address) {
+    reset();
+  }
+
+  void reset() {
+    memset(regs, 0, sizeof(regs));
+    memset(regWrites, 0, sizeof(regWrites));
+    regs[0x00] = DEVID;
+    regs[0x2C] = 0x0A;   // BW_RATE: 100 Hz
+    _fifo.clear();
+    _script.clear();
+    scriptedAt.clear();
+    _latest = rest;
+    _pointer = 0;
+    _lastTickUs = shim::clockUs();
+    events = 0;
+    samplesTaken = 0;
+  }
+
+  void onWrite(const uint8_t* data, uint8_t len) override {
+    catchUp();
+    if (len == 0) return;
+    _pointer = data[0] & 0x3F;
+    for (uint8_t i = 1; i < len; i++) {
+      writeReg(_pointer, data[i]);
+      _pointer = (_pointer + 1) & 0x3F;
+    }
+  }
+
+  void onRead(uint8_t* data, uint8_t len) override {
+    catchUp();
+    if (_pointer == 0x32 && len == 6) {
+      Sample s = _latest;
+      if (fifoMode() != 0 && !_fifo.empty()) {
+        s = _fifo.front();
+        _fifo.pop_front();
+      }
+      const int16_t v[3] = {s.x, s.y, s.z};
+      for (uint8_t a = 0; a < 3; a++) {
+        data[2 * a] = (uint8_t)v[a];
+        data[2 * a + 1] = (uint8_t)((uint16_t)v[a] >> 8);
+      }
+      return;
+    }
+    for (uint8_t i = 0; i < len; i++) {
+      data[i] = readReg(_pointer);
+      _pointer = (_pointer + 1) & 0x3F;
+    }
+  }
+
+  // Test side: samples to emit, in order, ahead of the resting vector
+  void script(int16_t x, int16_t y, int16_t z, uint16_t count = 1) {
+    for (uint16_t i = 0; i < count; i++) _script.push_back(Sample{x, y, z});
+  }
+  void latchEvents(uint8_t bits) { events |= bits; }   // 0x10 activity, 0x08 inactivity
+
+  uint32_t periodUs() const {
+    const uint8_t code = regs[0x2C] & 0x0F;
+    return 1000000UL / (3200UL >> (0x0F - code));
+  }
+  uint8_t fifoCount() {
+    catchUp();
+    return (uint8_t)_fifo.size();
+  }
+  bool lowPower() const { return (regs[0x2C] & 0x10) != 0; }
+
+  uint8_t regs[64];
+  uint16_t regWrites[64];
+  uint8_t events = 0;
+  Sample rest = {0, 0, 256};
+  uint32_t samplesTaken = 0;
+  std::vector<uint32_t> scriptedAt;   // Time each scripted sample was taken, in order
+
+private:
+  uint8_t fifoMode() const { return regs[0x38] >> 6; }
+
+  void writeReg(uint8_t reg, uint8_t value) {
+    if (reg == 0x00 || reg == 0x30 || reg == 0x39) return;  // Read-only
+    regs[reg] = value;
+    regWrites[reg]++;
+    if (reg == 0x38 && fifoMode() == 0) _fifo.clear();       // Bypass empties the FIFO
+    if (reg == 0x2D || reg == 0x2C) _lastTickUs = shim::clockUs();
+  }
+
+  uint8_t readReg(uint8_t reg) {
+    if (reg == 0x30) {
+      const uint8_t v = events;
+      events = 0;
+      return v;
+    }
+    if (reg == 0x39) return (uint8_t)_fifo.size();
+    return regs[reg];
+  }
+
+  void catchUp() {
+    if (!(regs[0x2D] & 0x08)) {
+      _lastTickUs = shim::clockUs();
+      return;
+    }
+    const uint32_t period = periodUs();
+    while (shim::clockUs() - _lastTickUs >= period) {
+      _lastTickUs += period;
+      Sample s = rest;
+      if (!_script.empty()) {
+        s = _script.front();
+        _script.pop_front();
+        scriptedAt.push_back(_lastTickUs);
+      }
+      _latest = s;
+      samplesTaken++;
+      if (fifoMode() != 0) {
+        if (_fifo.size() >= FIFO_DEPTH) _fifo.pop_front();
+        _fifo.push_back(s);
+      }
+    }
+  }
+
+  std::deque<Sample> _fifo;
+  std::deque<Sample> _script;
+  Sample _latest = {0, 0, 256};
+  uint8_t _pointer = 0;
+  uint32_t _lastTickUs = 0;
+};
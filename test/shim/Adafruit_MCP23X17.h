@@ -0,0 +1,115 @@
+#pragma once
+// Host stand-in for Adafruit_MCP23X17 that talks to the bus the way the real library does
+// (BusIO register access, BANK = 0 addressing), so transfer counts match the hardware:
+//   register read  = pointer write + 1-byte read (2 transfers)
+//   register write = pointer + value (1 transfer)
+//   pinMode        = IODIR then GPPU read-modify-write (6 transfers)
+//   digitalWrite   = GPIO read-modify-write (3 transfers)
+//   16-bit access  = pointer + 2 bytes, sequential (readGPIOAB, getCapturedInterrupt)
+//   setupInterrupts / setupInterruptPin = one read-modify-write per register bit (9 transfers)
+#include <Wire.h>
+
+#define MCP23XXX_INT_ERR 255
+
+class Adafruit_MCP23X17 {
+public:
+  bool begin_I2C(uint8_t address = 0x20, TwoWire* wire = &Wire) {
+    _address = address;
+    _wire = wire;
+    _wire->begin();
+    _wire->beginTransmission(_address);   // Adafruit_I2CDevice::detected()
+    return _wire->endTransmission() == 0;
+  }
+
+  void pinMode(uint8_t pin, uint8_t mode) {
+    writeBit(reg(IODIR, pin >> 3), pin & 7, mode != OUTPUT);
+    writeBit(reg(GPPU, pin >> 3), pin & 7, mode == INPUT_PULLUP);
+  }
+
+  uint8_t digitalRead(uint8_t pin) { return (readReg(reg(GPIO, pin >> 3)) >> (pin & 7)) & 1; }
+  void digitalWrite(uint8_t pin, uint8_t value) { writeBit(reg(GPIO, pin >> 3), pin & 7, value != LOW); }
+
+  uint8_t readGPIOA() { return readReg(reg(GPIO, 0)); }
+  uint8_t readGPIOB() { return readReg(reg(GPIO, 1)); }
+  void writeGPIOA(uint8_t value) { writeReg(reg(GPIO, 0), value); }
+  void writeGPIOB(uint8_t value) { writeReg(reg(GPIO, 1), value); }
+  uint16_t readGPIOAB() { return readReg16(reg(GPIO, 0)); }
+  void writeGPIOAB(uint16_t value) {
+    _wire->beginTransmission(_address);
+    _wire->write(reg(GPIO, 0));
+    _wire->write((uint8_t)value);
+    _wire->write((uint8_t)(value >> 8));
+    _wire->endTransmission();
+  }
+
+  void setupInterrupts(bool mirroring, bool openDrain, uint8_t polarity) {
+    writeBit(reg(IOCON, 0), 6, mirroring);
+    writeBit(reg(IOCON, 0), 2, openDrain);
+    writeBit(reg(IOCON, 0), 1, polarity == HIGH);
+  }
+
+  // CHANGE, or LOW/HIGH compared against DEFVAL
+  void setupInterruptPin(uint8_t pin, uint8_t mode = CHANGE) {
+    writeBit(reg(GPINTEN, pin >> 3), pin & 7, true);
+    writeBit(reg(INTCON, pin >> 3), pin & 7, mode != CHANGE);
+    writeBit(reg(DEFVAL, pin >> 3), pin & 7, mode == LOW);
+  }
+
+  void disableInterruptPin(uint8_t pin) { writeBit(reg(GPINTEN, pin >> 3), pin & 7, false); }
+
+  // Lowest pin flagged in INTF, MCP23XXX_INT_ERR if none
+  uint8_t getLastInterruptPin() {
+    for (uint8_t port = 0; port < 2; port++) {
+      const uint8_t intf = readReg(reg(INTF, port));
+      for (uint8_t bit = 0; bit < 8; bit++) {
+        if (intf & (1 << bit)) return (uint8_t)(port * 8 + bit);
+      }
+    }
+    return MCP23XXX_INT_ERR;
+  }
+
+  // Both ports as captured at the interrupt; reading INTCAP clears it
+  uint16_t getCapturedInterrupt() { return readReg16(reg(INTCAP, 0)); }
+  void clearInterrupts() { getCapturedInterrupt(); }
+
+private:
+  // MCP23x08 register numbers; the 16-bit part doubles them (BANK = 0), port B is +1
+  enum : uint8_t { IODIR = 0x00, IPOL = 0x01, GPINTEN = 0x02, DEFVAL = 0x03, INTCON = 0x04,
+                   IOCON = 0x05, GPPU = 0x06, INTF = 0x07, INTCAP = 0x08, GPIO = 0x09, OLAT = 0x0A };
+
+  static uint8_t reg(uint8_t base, uint8_t port) { return (uint8_t)(base * 2 + port); }
+
+  uint8_t readReg(uint8_t r) {
+    _wire->beginTransmission(_address);
+    _wire->write(r);
+    _wire->endTransmission(false);
+    _wire->requestFrom(_address, 1);
+    return _wire->available() ? (uint8_t)_wire->read() : 0;
+  }
+
+  uint16_t readReg16(uint8_t r) {
+    _wire->beginTransmission(_address);
+    _wire->write(r);
+    _wire->endTransmission(false);
+    _wire->requestFrom(_address, 2);
+    const uint8_t lo = _wire->available() ? (uint8_t)_wire->read() : 0;
+    const uint8_t hi = _wire->available() ? (uint8_t)_wire->read() : 0;
+    return (uint16_t)(lo | (hi << 8));
+  }
+
+  void writeReg(uint8_t r, uint8_t value) {
+    _wire->beginTransmission(_address);
+    _wire->write(r);
+    _wire->write(value);
+    _wire->endTransmission();
+  }
+
+  void writeBit(uint8_t r, uint8_t bit, bool set) {
+    uint8_t v = readReg(r);
+    v = set ? (uint8_t)(v | (1 << bit)) : (uint8_t)(v & ~(1 << bit));
+    writeReg(r, v);
+  }
+
+  TwoWire* _wire = &Wire;
+  uint8_t _address = 0x20;
+};
@@ -0,0 +1,485 @@
+#pragma once
+// Host stand-in for Adafruit_PN532 over I2C, in two halves:
+// - shim::PN532Model, a frame-level emulator of the chip on the Wire bus at 0x24. It takes normal
+//   information frames (00 00 FF LEN LCS D4 CMD ... DCS 00), checks both checksums and answers
+//   with an ACK frame, then the response frame, each ready after its own delay. Every read starts
+//   with the status byte (bit 0 = ready); a read past it returns the ready frame and consumes it.
+//   A host ACK frame aborts the command in progress, a host NACK has the last response sent again,
+//   and a frame with a bad checksum is dropped without an ACK. With an IRQ pin wired the line is
+//   low while a frame is ready. Cards enter and leave on a timeline (at()); tag is the card in
+//   the field before the first event. PowerDown takes effect once its response has been read;
+//   the next frame wakes the chip, which answers wakeUs later.
+// - Adafruit_PN532, the library's I2C transport on top of it: build the frame, wait for the
+//   status byte (or IRQ) in 10 ms steps up to the timeout, check the ACK, read the response.
+// The chip is one global model (shim::pn532()), so tests can reach the reader a puzzle owns.
+#include <Wire.h>
+
+#define PN532_PREAMBLE 0x00
+#define PN532_STARTCODE1 0x00
+#define PN532_STARTCODE2 0xFF
+#define PN532_POSTAMBLE 0x00
+#define PN532_HOSTTOPN532 0xD4
+#define PN532_PN532TOHOST 0xD5
+#define PN532_COMMAND_GETFIRMWAREVERSION 0x02
+#define PN532_COMMAND_SAMCONFIGURATION 0x14
+#define PN532_COMMAND_POWERDOWN 0x16
+#define PN532_COMMAND_RFCONFIGURATION 0x32
+#define PN532_COMMAND_INDATAEXCHANGE 0x40
+#define PN532_COMMAND_INLISTPASSIVETARGET 0x4A
+#define PN532_MIFARE_ISO14443A 0x00
+#define MIFARE_CMD_READ 0x30
+#define PN532_I2C_ADDRESS (0x48 >> 1)
+#define PN532_I2C_READY 0x01
+
+namespace shim {
+
+// NTAG215 contents as far as the puzzle reads them
+struct NfcTag {
+  uint8_t uid[10];
+  uint8_t uidLen;
+  uint8_t pages[135][4];
+};
+
+// 7-byte UID tag carrying an amiibo ID with the given game/character field
+inline NfcTag amiiboTag(const uint8_t (&uid)[7], uint16_t character) {
+  NfcTag t;
+  memset(&t, 0, sizeof(t));
+  memcpy(t.uid, uid, 7);
+  t.uidLen = 7;
+  const uint8_t id[8] = {(uint8_t)(character >> 8), (uint8_t)character, 0x00, 0x00,
+                         0x00, 0x34, 0x03, 0x02};
+  memcpy(t.pages[21], id, 4);
+  memcpy(t.pages[22], id + 4, 4);
+  return t;
+}
+
+class PN532Model : public I2CDevice {
+public:
+  static constexpr uint8_t NO_PIN = 0xFF;
+  static constexpr uint8_t MAX_FRAME = 32;
+  static constexpr uint8_t MAX_EVENTS = 16;
+  static constexpr uint8_t FIRMWARE[4] = {0x32, 0x01, 0x06, 0x07};   // IC, Ver, Rev, Support
+  static constexpr uint8_t ACK[6] = {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00};
+  static constexpr uint8_t NACK[6] = {0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00};
+
+  PN532Model() : I2CDevice(PN532_I2C_ADDRESS) { reset(); }
+
+  // Power-on state, default timing and no cards; test settings and counters cleared
+  void reset() {
+    present = true;
+    transactions = 0;
+    irqPin = NO_PIN;
+    ignoreCommand = -1;
+    tag = nullptr;
+    ackUs = 500;
+    responseUs = 1000;
+    detectUs = 2500;
+    missUs = 3000;
+    wakeUs = 2000;
+    polls = firmwareQueries = 0;
+    badFrames = hostAcks = hostNacks = wakeups = 0;
+    memset(commands, 0, sizeof(commands));
+    _events = 0;
+    hardReset();
+  }
+
+  // RSTPD_N pulse: chip state back to power-on, test settings kept
+  void hardReset() {
+    _out[0].len = _out[1].len = 0;
+    _last.len = 0;
+    _selected = nullptr;
+    fieldOn = poweredDown = _powerDownArmed = false;
+    retries = 0xFF;
+  }
+
+  // Timeline: a card enters (t) or leaves (nullptr) the field at the given fake-clock time
+  void at(uint32_t ms, const NfcTag* t) {
+    if (_events >= MAX_EVENTS) return;
+    uint8_t i = _events++;
+    for (; i > 0 && _timeline[i - 1].us > ms * 1000UL; i--) _timeline[i] = _timeline[i - 1];
+    _timeline[i].us = ms * 1000UL;
+    _timeline[i].tag = t;
+  }
+
+  // Card in the field at a fake-clock time
+  const NfcTag* tagAt(uint32_t us) const {
+    const NfcTag* t = tag;
+    for (uint8_t i = 0; i < _events && (int32_t)(us - _timeline[i].us) >= 0; i++) t = _timeline[i].tag;
+    return t;
+  }
+
+  void onWrite(const uint8_t* data, uint8_t len) override {
+    if (len == 0) return;   // Address probe
+    const uint32_t now = micros();
+    uint32_t start = now;
+    if (poweredDown) {      // Any frame wakes the chip; it answers once the oscillator runs
+      poweredDown = false;
+      wakeups++;
+      start = now + wakeUs;
+    }
+    if (len == 6 && memcmp(data, ACK, 6) == 0) {   // Host ACK: abort the command in progress
+      hostAcks++;
+      _out[0].len = _out[1].len = 0;
+      driveIrq();
+      return;
+    }
+    if (len == 6 && memcmp(data, NACK, 6) == 0) {  // Host NACK: send the last response again
+      hostNacks++;
+      _out[0] = _last;
+      _out[0].readyAt = start + ackUs;
+      _out[1].len = 0;
+      driveIrq();
+      return;
+    }
+    if (!validFrame(data, len)) {
+      badFrames++;
+      return;
+    }
+    const uint8_t* cmd = data + 6;
+    const uint8_t cmdLen = (uint8_t)(data[3] - 1);
+    commands[cmd[0]]++;
+    _out[0].len = _out[1].len = 0;   // A new command replaces whatever was pending
+    _powerDownArmed = false;
+    if (ignoreCommand == cmd[0]) {
+      driveIrq();
+      return;
+    }
+    memcpy(_out[0].bytes, ACK, 6);
+    _out[0].len = 6;
+    _out[0].readyAt = start + ackUs;
+    execute(cmd, cmdLen, start);
+    driveIrq();
+  }
+
+  void onRead(uint8_t* data, uint8_t len) override {
+    memset(data, 0, len);
+    if (!ready()) {
+      driveIrq();
+      return;               // Status 0x00: busy
+    }
+    data[0] = PN532_I2C_READY;
+    if (len > 1) {
+      Frame& f = _out[0];
+      memcpy(data + 1, f.bytes, min<uint8_t>(len - 1, f.len));
+      if (_out[1].len == 0) {      // The response (not the ACK) went out
+        _last = f;
+        if (_powerDownArmed) {
+          _powerDownArmed = false;
+          poweredDown = true;
+          fieldOn = false;
+        }
+      }
+      _out[0] = _out[1];
+      _out[1].len = 0;
+    }
+    driveIrq();
+  }
+
+  // IRQ is low while a frame is ready
+  void driveIrq() const {
+    if (irqPin != NO_PIN) setPin(irqPin, ready() ? LOW : HIGH);
+  }
+  static void refreshIrq();
+
+  // Chip behaviour, set by tests
+  uint8_t irqPin;           // Wired by Adafruit_PN532::begin()
+  int16_t ignoreCommand;    // Command code the chip leaves unacknowledged, -1 = none
+  const NfcTag* tag;        // Card in the field (before any timeline event)
+  uint32_t ackUs;           // Frame received -> ACK ready
+  uint32_t responseUs;      // ACK -> response ready, most commands
+  uint32_t detectUs;        // InListPassiveTarget: card in the field -> target listed
+  uint32_t missUs;          // InListPassiveTarget: bounded retries without a card
+  uint32_t wakeUs;          // Frame that wakes the chip -> it starts processing
+
+  // Chip state and counters
+  bool fieldOn, poweredDown;
+  uint8_t retries;          // MxRtyPassiveActivation (RFConfiguration item 5)
+  uint32_t polls;           // InListPassiveTarget frames
+  uint32_t firmwareQueries; // GetFirmwareVersion frames
+  uint32_t badFrames, hostAcks, hostNacks, wakeups;
+  uint16_t commands[256];   // Valid command frames per command code
+
+private:
+  struct Frame {
+    uint8_t bytes[MAX_FRAME];
+    uint8_t len;            // 0 = none
+    uint32_t readyAt;
+  };
+
+  struct Event {
+    uint32_t us;
+    const NfcTag* tag;
+  };
+
+  bool ready() const {
+    return _out[0].len > 0 && (int32_t)(micros() - _out[0].readyAt) >= 0;
+  }
+
+  static bool validFrame(const uint8_t* d, uint8_t len) {
+    if (len < 9 || d[0] != PN532_PREAMBLE || d[1] != PN532_STARTCODE1 || d[2] != PN532_STARTCODE2) {
+      return false;
+    }
+    const uint8_t n = d[3];
+    if ((uint8_t)(n + d[4]) != 0 || n < 2 || len < n + 7 || d[5] != PN532_HOSTTOPN532) return false;
+    uint8_t sum = 0;
+    for (uint8_t i = 0; i <= n; i++) sum += d[5 + i];   // TFI, data and DCS add up to 0
+    return sum == 0 && d[6 + n] == PN532_POSTAMBLE;
+  }
+
+  // Response frame D5 <cmd + 1> <data>, ready at the given time
+  void respond(uint8_t cmd, const uint8_t* data, uint8_t len, uint32_t readyAt) {
+    Frame& f = _out[1];
+    const uint8_t n = len + 2;
+    f.bytes[0] = PN532_PREAMBLE;
+    f.bytes[1] = PN532_STARTCODE1;
+    f.bytes[2] = PN532_STARTCODE2;
+    f.bytes[3] = n;
+    f.bytes[4] = (uint8_t)(~n + 1);
+    f.bytes[5] = PN532_PN532TOHOST;
+    f.bytes[6] = cmd + 1;
+    memcpy(f.bytes + 7, data, len);
+    uint8_t sum = PN532_PN532TOHOST + cmd + 1;
+    for (uint8_t i = 0; i < len; i++) sum += data[i];
+    f.bytes[7 + len] = (uint8_t)(~sum + 1);
+    f.bytes[8 + len] = PN532_POSTAMBLE;
+    f.len = len + 9;
+    // Ready no earlier than the ACK it follows
+    f.readyAt = (int32_t)(readyAt - _out[0].readyAt) > 0 ? readyAt : _out[0].readyAt;
+  }
+
+  void execute(const uint8_t* cmd, uint8_t len, uint32_t start) {
+    const uint32_t done = start + ackUs + responseUs;
+    switch (cmd[0]) {
+      case PN532_COMMAND_GETFIRMWAREVERSION:
+        firmwareQueries++;
+        respond(cmd[0], FIRMWARE, sizeof(FIRMWARE), done);
+        break;
+      case PN532_COMMAND_SAMCONFIGURATION:
+      case PN532_COMMAND_POWERDOWN: {
+        const uint8_t status = 0x00;
+        respond(cmd[0], &status, cmd[0] == PN532_COMMAND_POWERDOWN ? 1 : 0, done);
+        _powerDownArmed = cmd[0] == PN532_COMMAND_POWERDOWN;
+        break;
+      }
+      case PN532_COMMAND_RFCONFIGURATION:
+        if (len >= 3 && cmd[1] == 0x01) fieldOn = (cmd[2] & 0x01) != 0;
+        if (len >= 5 && cmd[1] == 0x05) retries = cmd[4];
+        respond(cmd[0], nullptr, 0, done);
+        break;
+      case PN532_COMMAND_INLISTPASSIVETARGET:
+        polls++;
+        fieldOn = true;
+        inListPassiveTarget(start + ackUs);
+        break;
+      case PN532_COMMAND_INDATAEXCHANGE:
+        inDataExchange(cmd, len, done);
+        break;
+      default: {
+        const uint8_t syntaxError = 0x27;
+        respond(cmd[0], &syntaxError, 1, done);
+        break;
+      }
+    }
+  }
+
+  // First card in the field within the retry window is listed as target 1
+  void inListPassiveTarget(uint32_t start) {
+    _selected = tagAt(start);
+    uint32_t seenAt = start;
+    for (uint8_t i = 0; i < _events && _selected == nullptr; i++) {
+      const uint32_t t = _timeline[i].us;
+      if ((int32_t)(t - start) > 0 && (int32_t)(t - (start + missUs)) < 0 && _timeline[i].tag != nullptr) {
+        _selected = _timeline[i].tag;
+        seenAt = t;
+      }
+    }
+    if (_selected == nullptr) {
+      const uint8_t none = 0;
+      respond(PN532_COMMAND_INLISTPASSIVETARGET, &none, 1, start + missUs);
+      return;
+    }
+    uint8_t data[6 + 10] = {1, 1, 0x00, 0x44, 0x00, _selected->uidLen};   // NbTg, Tg, SENS_RES, SEL_RES
+    memcpy(data + 6, _selected->uid, _selected->uidLen);
+    respond(PN532_COMMAND_INLISTPASSIVETARGET, data, (uint8_t)(6 + _selected->uidLen), seenAt + detectUs);
+  }
+
+  // MIFARE READ of four pages from the listed target; status 0x01 (timeout) once it has left
+  void inDataExchange(const uint8_t* cmd, uint8_t len, uint32_t done) {
+    uint8_t data[1 + 16] = {0x01};
+    const NfcTag* t = _selected;
+    if (len >= 4 && cmd[1] == 1 && cmd[2] == MIFARE_CMD_READ && t != nullptr && tagAt(micros()) == t) {
+      data[0] = 0x00;
+      for (uint8_t i = 0; i < 4; i++) {
+        const uint8_t page = cmd[3] + i;
+        if (page < 135) memcpy(data + 1 + 4 * i, t->pages[page], 4);
+      }
+      respond(PN532_COMMAND_INDATAEXCHANGE, data, sizeof(data), done);
+    } else {
+      respond(PN532_COMMAND_INDATAEXCHANGE, data, 1, done);
+    }
+  }
+
+  Frame _out[2];            // Pending ACK and response, in order
+  Frame _last;              // Last response read, for a host NACK
+  bool _powerDownArmed;
+  const NfcTag* _selected;
+  Event _timeline[MAX_EVENTS];
+  uint8_t _events;
+};
+
+constexpr uint8_t PN532Model::FIRMWARE[4];
+constexpr uint8_t PN532Model::ACK[6];
+constexpr uint8_t PN532Model::NACK[6];
+
+inline PN532Model& pn532() { static PN532Model m; return m; }
+inline void PN532Model::refreshIrq() { pn532().driveIrq(); }
+
+}  // namespace shim
+
+class Adafruit_PN532 {
+public:
+  Adafruit_PN532(uint8_t irq, uint8_t reset, TwoWire* wire = &Wire)
+    : _irq(irq), _reset(reset), _wire(wire) {}
+
+  bool begin() {
+    shim::pn532().irqPin = _irq;
+    if (_irq != NO_PIN) shim::pinDriver() = &shim::PN532Model::refreshIrq;
+    reset();
+    return true;
+  }
+
+  void reset() {
+    if (_reset == NO_PIN) return;
+    digitalWrite(_reset, HIGH);
+    digitalWrite(_reset, LOW);
+    delay(400);
+    shim::pn532().hardReset();
+    digitalWrite(_reset, HIGH);
+    delay(10);
+  }
+  void wakeup() {}
+
+  uint32_t getFirmwareVersion() {
+    uint8_t cmd[] = {PN532_COMMAND_GETFIRMWAREVERSION};
+    if (!sendCommandCheckAck(cmd, sizeof(cmd))) return 0;
+    uint8_t buf[13];
+    if (!readResponse(buf, sizeof(buf), 100)) return 0;
+    static const uint8_t HEADER[6] = {0x00, 0x00, 0xFF, 0x06, 0xFA, PN532_PN532TOHOST};
+    if (memcmp(buf, HEADER, sizeof(HEADER)) != 0) return 0;
+    return ((uint32_t)buf[7] << 24) | ((uint32_t)buf[8] << 16) | ((uint32_t)buf[9] << 8) | buf[10];
+  }
+
+  bool SAMConfig() {
+    uint8_t cmd[] = {PN532_COMMAND_SAMCONFIGURATION, 0x01, 0x14, 0x01};   // Normal mode, 1 s, IRQ
+    if (!sendCommandCheckAck(cmd, sizeof(cmd))) return false;
+    uint8_t buf[9];
+    return readResponse(buf, sizeof(buf), 100) && buf[6] == PN532_COMMAND_SAMCONFIGURATION + 1;
+  }
+
+  // Like the library, the response is left unread
+  bool setPassiveActivationRetries(uint8_t maxRetries) {
+    uint8_t cmd[] = {PN532_COMMAND_RFCONFIGURATION, 0x05, 0xFF, 0x01, maxRetries};
+    return sendCommandCheckAck(cmd, sizeof(cmd));
+  }
+
+  bool sendCommandCheckAck(uint8_t* cmd, uint8_t len, uint16_t timeout = 100) {
+    writeCommand(cmd, len);
+    if (!waitReady(timeout)) return false;
+    return readAck();
+  }
+
+  bool readPassiveTargetID(uint8_t baud, uint8_t* uid, uint8_t* uidLen, uint16_t timeout = 0) {
+    uint8_t cmd[] = {PN532_COMMAND_INLISTPASSIVETARGET, 1, baud};
+    if (!sendCommandCheckAck(cmd, sizeof(cmd), timeout)) return false;
+    if (!waitReady(timeout)) return false;
+    return readDetectedPassiveTargetID(uid, uidLen);
+  }
+
+  bool startPassiveTargetIDDetection(uint8_t baud) {
+    uint8_t cmd[] = {PN532_COMMAND_INLISTPASSIVETARGET, 1, baud};
+    return sendCommandCheckAck(cmd, sizeof(cmd));
+  }
+
+  // D5 4B NbTg Tg SENS_RES(2) SEL_RES NFCIDLength NFCID
+  bool readDetectedPassiveTargetID(uint8_t* uid, uint8_t* uidLen) {
+    uint8_t buf[20];
+    readData(buf, sizeof(buf));
+    if (buf[7] != 1 || buf[12] > 7) return false;
+    *uidLen = buf[12];
+    memcpy(uid, buf + 13, buf[12]);
+    return true;
+  }
+
+  uint8_t ntag2xx_ReadPage(uint8_t page, uint8_t* buffer) {
+    if (page >= 231) return 0;
+    uint8_t cmd[] = {PN532_COMMAND_INDATAEXCHANGE, 1, MIFARE_CMD_READ, page};
+    if (!sendCommandCheckAck(cmd, sizeof(cmd))) return 0;
+    uint8_t buf[26];
+    if (!readResponse(buf, sizeof(buf), 100) || buf[7] != 0x00) return 0;
+    memcpy(buffer, buf + 8, 4);   // READ returns four pages; the first is the one asked for
+    return 1;
+  }
+
+private:
+  static constexpr uint8_t NO_PIN = 0xFF;
+
+  void writeCommand(const uint8_t* cmd, uint8_t len) {
+    const uint8_t n = len + 1;
+    uint8_t sum = PN532_HOSTTOPN532;
+    _wire->beginTransmission((uint8_t)PN532_I2C_ADDRESS);
+    _wire->write(PN532_PREAMBLE);
+    _wire->write(PN532_STARTCODE1);
+    _wire->write(PN532_STARTCODE2);
+    _wire->write(n);
+    _wire->write((uint8_t)(~n + 1));
+    _wire->write(PN532_HOSTTOPN532);
+    for (uint8_t i = 0; i < len; i++) {
+      _wire->write(cmd[i]);
+      sum += cmd[i];
+    }
+    _wire->write((uint8_t)(~sum + 1));
+    _wire->write(PN532_POSTAMBLE);
+    _wire->endTransmission();
+  }
+
+  bool isReady() {
+    if (_irq != NO_PIN) return digitalRead(_irq) == LOW;
+    _wire->requestFrom((uint8_t)PN532_I2C_ADDRESS, (uint8_t)1);
+    return _wire->read() == PN532_I2C_READY;
+  }
+
+  // timeout in ms, 0 = forever
+  bool waitReady(uint16_t timeout) {
+    uint16_t timer = 0;
+    while (!isReady()) {
+      if (timeout != 0) {
+        timer += 10;
+        if (timer > timeout) return false;
+      }
+      delay(10);
+    }
+    return true;
+  }
+
+  // n bytes after the status byte
+  void readData(uint8_t* buf, uint8_t n) {
+    _wire->requestFrom((uint8_t)PN532_I2C_ADDRESS, (uint8_t)(n + 1));
+    _wire->read();
+    for (uint8_t i = 0; i < n; i++) buf[i] = (uint8_t)_wire->read();
+  }
+
+  bool readResponse(uint8_t* buf, uint8_t n, uint16_t timeout) {
+    if (!waitReady(timeout)) return false;
+    readData(buf, n);
+    return true;
+  }
+
+  bool readAck() {
+    uint8_t buf[6];
+    readData(buf, sizeof(buf));
+    return memcmp(buf, shim::PN532Model::ACK, sizeof(buf)) == 0;
+  }
+
+  uint8_t _irq, _reset;
+  TwoWire* _wire;
+};
@@ -0,0 +1,245 @@
+#pragma once
+// Host (native env) stand-in for the Arduino core: a fake clock, pin levels, tone and Serial
+// capture. Header-only; every test suite is a single translation unit.
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <math.h>
+#include <string>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW  0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+#define CHANGE 1
+#define DEC 10
+#define HEX 16
+#define BIN 2
+#define LED_BUILTIN 13
+#define A0 14
+#define PI 3.1415926535897932384626433832795
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define _BV(bit) (1 << (bit))
+
+template <class T> T min(T a, T b) { return a < b ? a : b; }
+template <class T> T max(T a, T b) { return a > b ? a : b; }
+template <class T> T constrain(T x, T lo, T hi) { return x < lo ? lo : (x > hi ? hi : x); }
+
+namespace shim {
+
+// ---- Clock: only delay() and bus traffic move time ----
+inline uint32_t& clockUs() { static uint32_t us = 0; return us; }
+inline void advanceUs(uint32_t us) { clockUs() += us; }
+inline void advanceMs(uint32_t ms) { clockUs() += ms * 1000UL; }
+
+// ---- Pins: D0-D7 = port D, D8-D13 = port B, A0-A5 (14-19) = port C ----
+enum Port : uint8_t { PORT_B = 2, PORT_C = 3, PORT_D = 4 };
+inline volatile uint8_t* portRegs() { static volatile uint8_t regs[5] = {0, 0, 0xFF, 0xFF, 0xFF}; return regs; }
+inline uint8_t pinPort(uint8_t pin) { return pin < 8 ? PORT_D : (pin < 14 ? PORT_B : PORT_C); }
+inline uint8_t pinMask(uint8_t pin) { return (uint8_t)(1 << (pin < 8 ? pin : (pin < 14 ? pin - 8 : pin - 14))); }
+inline uint8_t* pinModes() { static uint8_t modes[20] = {}; return modes; }
+inline uint8_t* pinOutputs() { static uint8_t out[20] = {}; return out; }
+
+// Drive an input pin from the outside world (switch, sensor)
+inline void setPin(uint8_t pin, uint8_t level) {
+  if (level) portRegs()[pinPort(pin)] |= pinMask(pin);
+  else       portRegs()[pinPort(pin)] &= (uint8_t)~pinMask(pin);
+}
+
+// Outside part that drives pins from its own state (a module's IRQ line): refreshed before every
+// digitalRead(), so the line follows the part's timeline without the test stepping it
+inline void (*&pinDriver())() { static void (*driver)() = nullptr; return driver; }
+
+// Pin-change interrupt registers
+inline volatile uint8_t& pcicr() { static volatile uint8_t r = 0; return r; }
+inline volatile uint8_t& pcifr() { static volatile uint8_t r = 0; return r; }
+inline volatile uint8_t* pcmsk() { static volatile uint8_t r[3] = {}; return r; }
+
+// ---- Buzzer ----
+inline unsigned int& toneHz() { static unsigned int hz = 0; return hz; }
+
+// ---- ADC: floating-input noise ----
+inline uint32_t& adcState() { static uint32_t s = 12345; return s; }
+
+inline void resetArduino() {
+  clockUs() = 0;
+  pinDriver() = nullptr;
+  for (uint8_t i = 0; i < 5; i++) portRegs()[i] = 0xFF;  // Inputs idle high (pull-ups)
+  memset(pinModes(), 0, 20);
+  memset(pinOutputs(), 0, 20);
+  pcicr() = 0;
+  pcifr() = 0;
+  memset((void*)pcmsk(), 0, 3);
+  toneHz() = 0;
+  adcState() = 12345;
+}
+
+}  // namespace shim
+
+inline unsigned long micros() { return shim::clockUs(); }
+inline unsigned long millis() { return shim::clockUs() / 1000UL; }
+inline void delay(unsigned long ms) { shim::advanceMs(ms); }
+inline void delayMicroseconds(unsigned int us) { shim::advanceUs(us); }
+
+static constexpr uint32_t DIGITAL_READ_US = 4;   // Arduino digitalRead() at 16 MHz
+
+inline void pinMode(uint8_t pin, uint8_t mode) { shim::pinModes()[pin] = mode; }
+inline int digitalRead(uint8_t pin) {
+  if (shim::pinDriver() != nullptr) shim::pinDriver()();
+  shim::advanceUs(DIGITAL_READ_US);
+  return (shim::portRegs()[shim::pinPort(pin)] & shim::pinMask(pin)) ? HIGH : LOW;
+}
+inline void digitalWrite(uint8_t pin, uint8_t value) { shim::pinOutputs()[pin] = value; }
+inline int analogRead(uint8_t) {
+  uint32_t& s = shim::adcState();
+  s = s * 1103515245UL + 12345UL;
+  return 512 + (int)((s >> 16) & 0x07) - 4;
+}
+
+inline void tone(uint8_t, unsigned int frequency, unsigned long = 0) { shim::toneHz() = frequency; }
+inline void noTone(uint8_t) { shim::toneHz() = 0; }
+
+inline void randomSeed(unsigned long seed) { srand((unsigned)seed); }
+inline long random(long howbig) { return howbig <= 0 ? 0 : rand() % howbig; }
+inline long random(long lo, long hi) { return hi <= lo ? lo : lo + rand() % (hi - lo); }
+
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+#define digitalPinToPort(p) (shim::pinPort(p))
+#define digitalPinToBitMask(p) (shim::pinMask(p))
+#define portInputRegister(port) (&shim::portRegs()[(port)])
+#define digitalPinToPCICRbit(p) (((p) <= 7) ? 2 : (((p) <= 13) ? 0 : 1))
+#define digitalPinToPCMSK(p) (&shim::pcmsk()[digitalPinToPCICRbit(p)])
+#define digitalPinToPCMSKbit(p) (((p) <= 7) ? (p) : (((p) <= 13) ? ((p) - 8) : ((p) - 14)))
+#define ISR(vector) void vector()
+#define PCICR (shim::pcicr())
+#define PCIFR (shim::pcifr())
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define PCIF2 2
+
+// ---- Flash strings and String ----
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+
+class String {
+public:
+  String(const char* s = "") : _s(s) {}
+  String(const std::string& s) : _s(s) {}
+  unsigned int length() const { return (unsigned int)_s.size(); }
+  char operator[](unsigned int i) const { return _s[i]; }
+  const char* c_str() const { return _s.c_str(); }
+  bool operator==(const char* s) const { return _s == s; }
+  bool operator!=(const char* s) const { return _s != s; }
+  String substring(unsigned int from) const { return String(_s.substr(from)); }
+  String substring(unsigned int from, unsigned int to) const { return String(_s.substr(from, to - from)); }
+  bool startsWith(const char* prefix) const { return _s.compare(0, strlen(prefix), prefix) == 0; }
+  int indexOf(char c, unsigned int from = 0) const {
+    const size_t at = _s.find(c, from);
+    return at == std::string::npos ? -1 : (int)at;
+  }
+  void trim() {
+    const size_t first = _s.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) { _s.clear(); return; }
+    _s = _s.substr(first, _s.find_last_not_of(" \t\r\n") - first + 1);
+  }
+  void toUpperCase() {
+    for (size_t i = 0; i < _s.size(); i++) _s[i] = (char)toupper((unsigned char)_s[i]);
+  }
+private:
+  std::string _s;
+};
+
+// ---- Serial: output is captured for assertions, input is queued by the test ----
+class HardwareSerial {
+public:
+  void begin(unsigned long) {}
+
+  size_t write(uint8_t c) { _out += (char)c; return 1; }
+  size_t write(const uint8_t* buf, size_t len) { _out.append((const char*)buf, len); return len; }
+
+  size_t print(const char* s) { _out += s; return strlen(s); }
+  size_t print(const __FlashStringHelper* s) { return print(reinterpret_cast<const char*>(s)); }
+  size_t print(const String& s) { return print(s.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n, base); }
+  size_t print(int n, int base = DEC) { return print((long)n, base); }
+  size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+  size_t print(long n, int base = DEC) {
+    if (n < 0 && base == DEC) { write('-'); return 1 + print((unsigned long)-n, base); }
+    return print((unsigned long)n, base);
+  }
+  size_t print(unsigned long n, int base = DEC) {
+    char buf[8 * sizeof(long) + 1];
+    char* p = buf + sizeof(buf) - 1;
+    *p = '\0';
+    do {
+      const unsigned digit = (unsigned)(n % base);
+      *--p = (char)(digit < 10 ? '0' + digit : 'A' + digit - 10);
+      n /= base;
+    } while (n);
+    return print(p);
+  }
+  size_t print(double d, int digits = 2) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.*f", digits, d);
+    return print(buf);
+  }
+
+  template <class T> size_t println(T v) { const size_t n = print(v); return n + println(); }
+  template <class T> size_t println(T v, int fmt) { const size_t n = print(v, fmt); return n + println(); }
+  size_t println() { _out += "\r\n"; return 2; }
+
+  int available() { release(); return (int)(_in.size() - _inPos); }
+  int read() { release(); return _inPos < _in.size() ? (uint8_t)_in[_inPos++] : -1; }
+  // Up to the terminator (consumed, not returned) or the end of the queued input
+  String readStringUntil(char terminator) {
+    release();
+    std::string line;
+    while (_inPos < _in.size() && _in[_inPos] != terminator) line += _in[_inPos++];
+    if (_inPos < _in.size()) _inPos++;
+    return String(line);
+  }
+
+  // Test side
+  const std::string& output() const { return _out; }
+  bool printed(const char* text) const { return _out.find(text) != std::string::npos; }
+  size_t count(const char* text) const {
+    size_t n = 0;
+    for (size_t at = _out.find(text); at != std::string::npos; at = _out.find(text, at + 1)) n++;
+    return n;
+  }
+  void clearOutput() { _out.clear(); }
+  void input(const char* text) { _in += text; }
+  // Input that arrives once the fake clock reaches atUs (e.g. the host stopping a stream)
+  void inputAt(uint32_t atUs, const char* text) {
+    _later = text;
+    _laterUs = atUs;
+  }
+  void reset() { _out.clear(); _in.clear(); _inPos = 0; _later.clear(); }
+
+private:
+  void release() {
+    if (!_later.empty() && (int32_t)(shim::clockUs() - _laterUs) >= 0) {
+      _in += _later;
+      _later.clear();
+    }
+  }
+
+  std::string _out;
+  std::string _in;
+  size_t _inPos = 0;
+  std::string _later;
+  uint32_t _laterUs = 0;
+};
+
+static HardwareSerial Serial;
@@ -0,0 +1,30 @@
+#pragma once
+// Host stand-in for the AVR EEPROM library: 1 KiB, erased to 0xFF, writes counted
+#include <Arduino.h>
+
+class EEPROMClass {
+public:
+  static constexpr uint16_t SIZE = 1024;
+
+  uint8_t read(int addr) const { return _data[addr]; }
+  void write(int addr, uint8_t value) {
+    _data[addr] = value;
+    writes++;
+  }
+  void update(int addr, uint8_t value) {
+    if (_data[addr] != value) write(addr, value);
+  }
+  uint16_t length() const { return SIZE; }
+
+  // Test side
+  void erase() {
+    memset(_data, 0xFF, SIZE);
+    writes = 0;
+  }
+  uint32_t writes = 0;
+
+private:
+  uint8_t _data[SIZE];
+};
+
+static EEPROMClass EEPROM;
@@ -0,0 +1,160 @@
+#pragma once
+// Offline replay of KNOCKREC captures (SensorHub::recordSamples) through the unmodified
+// KnockDetectionPuzzle, for tuning against recordings from real tables and rooms.
+// The capture is the raw serial stream: text around it is skipped, from the
+// "KNOCKREC BEGIN <periodUs>" line through the frames to "KNOCKREC END <frames>".
+// A replay resets the shim, calibrates a SensorHub on an ADXL345 model resting at the capture's
+// opening vector, then hands every frame to the detector at its recorded time, as the hub would.
+#include <string>
+#include <vector>
+#include <Arduino.h>
+#include "ADXL345Model.h"
+#include "KnockDetectionPuzzle.h"
+
+struct KnockRecording {
+  struct Frame {
+    uint32_t us;        // Since the recording started
+    int16_t x, y, z;    // Raw LSB (3.9 mg)
+  };
+
+  static constexpr uint8_t SYNC = 0xA5;
+  static constexpr uint8_t FRAME_SIZE = 9;
+  static constexpr uint16_t DT_OVERFLOW = 0xFFFF;   // FIFO was full: samples may be missing
+
+  uint32_t periodUs = 0;
+  std::vector<Frame> frames;
+  uint32_t overflows = 0;   // Frames after a full FIFO, each counted as one period late
+
+  // Parse the first recording in a serial capture; false with error set if it is damaged
+  bool parse(const std::string& capture, std::string& error) {
+    frames.clear();
+    overflows = 0;
+    static const char BEGIN[] = "KNOCKREC BEGIN ";
+    static const char END[] = "\r\nKNOCKREC END ";
+    const size_t begin = capture.find(BEGIN);
+    if (begin == std::string::npos) {
+      error = "no KNOCKREC BEGIN line";
+      return false;
+    }
+    size_t at = begin + sizeof(BEGIN) - 1;
+    periodUs = (uint32_t)strtoul(capture.c_str() + at, nullptr, 10);
+    at = capture.find("\r\n", at);
+    if (periodUs == 0 || at == std::string::npos) {
+      error = "bad KNOCKREC BEGIN line";
+      return false;
+    }
+    at += 2;
+
+    uint32_t us = 0;
+    while (capture.compare(at, sizeof(END) - 1, END) != 0) {
+      if (at + FRAME_SIZE > capture.size()) {
+        error = "capture ends after " + std::to_string(frames.size()) + " frames";
+        return false;
+      }
+      const uint8_t* f = (const uint8_t*)capture.data() + at;
+      if (f[0] != SYNC) {
+        error = "lost sync at byte " + std::to_string(at) + " after " + std::to_string(frames.size()) + " frames";
+        return false;
+      }
+      const uint16_t dt = (uint16_t)(f[1] | (f[2] << 8));
+      if (dt == DT_OVERFLOW) overflows++;
+      us += dt == DT_OVERFLOW ? periodUs : dt;
+      frames.push_back(Frame{us, (int16_t)(f[3] | (f[4] << 8)), (int16_t)(f[5] | (f[6] << 8)),
+                             (int16_t)(f[7] | (f[8] << 8))});
+      at += FRAME_SIZE;
+    }
+
+    const uint32_t count = (uint32_t)strtoul(capture.c_str() + at + sizeof(END) - 1, nullptr, 10);
+    if (count != frames.size()) {
+      error = "KNOCKREC END says " + std::to_string(count) + " frames, found " + std::to_string(frames.size());
+      return false;
+    }
+    return true;
+  }
+
+  uint32_t durationUs() const { return frames.empty() ? 0 : frames.back().us; }
+};
+
+// Detector settings to replay with; the defaults are the box's (src/main.cpp)
+struct KnockVariant {
+  float threshold = 3.5;             // m/s^2
+  float hysteresis = 0.5;
+  uint32_t quietMs = 50;
+  uint32_t windowMs = 3000;
+  uint8_t knocks = 4;                // Knocks to solve when counting only
+  uint16_t rhythm[7] = {300, 600, 300};
+  uint8_t rhythmLen = 3;             // 0 = count knocks only
+  uint8_t tolerancePct = 15;
+};
+
+struct KnockReplayResult {
+  bool valid = false;                // false: the variant is out of range (configure() refused it)
+  std::vector<uint32_t> hitsMs;      // Recording time of every detected knock
+  int32_t solvedMs = -1;             // Recording time the puzzle solved, -1 if it did not
+  std::string log;                   // The detector's serial lines, each prefixed with its time
+};
+
+inline KnockReplayResult replayKnocks(const KnockRecording& recording, const KnockVariant& variant) {
+  KnockReplayResult result;
+  shim::resetArduino();
+  Serial.reset();
+  Wire.detachAll();
+
+  // Rest at the mean of the opening frames, so the detector's gravity seed matches the table
+  static ADXL345Model adxl;
+  adxl.reset();
+  const size_t opening = recording.frames.size() < 32 ? recording.frames.size() : 32;
+  int32_t sum[3] = {0, 0, 0};
+  for (size_t i = 0; i < opening; i++) {
+    sum[0] += recording.frames[i].x;
+    sum[1] += recording.frames[i].y;
+    sum[2] += recording.frames[i].z;
+  }
+  if (opening > 0) {
+    adxl.rest = ADXL345Model::Sample{(int16_t)(sum[0] / (int32_t)opening), (int16_t)(sum[1] / (int32_t)opening),
+                                     (int16_t)(sum[2] / (int32_t)opening)};
+  }
+  Wire.attach(&adxl);
+
+  SensorHub hub;
+  hub.begin();
+  KnockDetectionPuzzle knock(hub, variant.knocks, variant.threshold, variant.windowMs);
+  if (!knock.configure(variant.threshold, variant.hysteresis, variant.quietMs)) return result;
+  knock.setPattern(variant.rhythm, variant.rhythmLen, variant.tolerancePct);
+  knock.begin();
+  result.valid = true;
+  Serial.clearOutput();
+
+  const uint32_t startUs = micros();
+  for (size_t i = 0; i < recording.frames.size(); i++) {
+    const KnockRecording::Frame& f = recording.frames[i];
+    if ((int32_t)(startUs + f.us - micros()) > 0) shim::advanceUs(startUs + f.us - micros());
+    knock.update(millis());
+    AccelSample sample;
+    sample.x = f.x;
+    sample.y = f.y;
+    sample.z = f.z;
+    sample.us = startUs + f.us;
+    sample.ms = millis();
+    const bool wasSolved = knock.isSolved();
+    const size_t hits = Serial.count("[Knock] hit");
+    knock.onAccelSample(sample);
+    if (Serial.count("[Knock] hit") > hits) result.hitsMs.push_back(f.us / 1000);
+    if (!wasSolved && knock.isSolved()) result.solvedMs = (int32_t)(f.us / 1000);
+
+    // Move the new lines to the log with their recording time
+    const std::string& out = Serial.output();
+    for (size_t line = 0; line < out.size();) {
+      size_t end = out.find('\n', line);
+      if (end == std::string::npos) end = out.size();
+      std::string text = out.substr(line, end - line);
+      if (!text.empty() && text[text.size() - 1] == '\r') text.erase(text.size() - 1);
+      char stamp[16];
+      snprintf(stamp, sizeof(stamp), "%8.3f s ", f.us / 1e6);
+      result.log += stamp + text + "\n";
+      line = end + 1;
+    }
+    Serial.clearOutput();
+  }
+  return result;
+}
@@ -0,0 +1,166 @@
+#pragma once
+// MCP23017 register model. regs[] is kept in the IOCON.BANK = 0 layout whatever the bank setting;
+// the bus side follows IOCON:
+//   BANK    1: port A registers at 0x00-0x0A, port B at 0x10-0x1A (others read 0, ignore writes)
+//   SEQOP   0: the pointer increments after each byte and wraps; 1 (byte mode): it stays put,
+//           except that with BANK = 0 it toggles between the A and B register of a pair
+//   MIRROR  INTA and INTB are both driven by either port's interrupt
+//   ODR, INTPOL  INT pin drive: open drain (active low) or push-pull of the given polarity
+// IOCON is one register visible at both addresses. GPIO reads return output pins from OLAT and
+// input pins from the outside world (inverted by IPOL); GPIO writes go to OLAT.
+// Interrupt-on-change: an enabled input pin that differs from DEFVAL (INTCON = 1) or from its
+// previous level (INTCON = 0) sets its INTF bit and captures the port in INTCAP, if no interrupt
+// is pending on that port yet. Reading GPIO or INTCAP clears the port's interrupt; a pin still
+// differing from DEFVAL raises it again at once. Power-on: IODIR = 0xFF, everything else 0.
+#include <Wire.h>
+
+class MCP23017Model : public I2CDevice {
+public:
+  // Register index in the BANK = 0 map (port A; port B is +1)
+  enum Reg : uint8_t {
+    IODIR = 0x00, IPOL = 0x02, GPINTEN = 0x04, DEFVAL = 0x06, INTCON = 0x08,
+    IOCON = 0x0A, GPPU = 0x0C, INTF = 0x0E, INTCAP = 0x10, GPIO = 0x12, OLAT = 0x14
+  };
+  static constexpr uint8_t NUM_REGS = 0x16;
+
+  // IOCON bits
+  static constexpr uint8_t BANK = 0x80, MIRROR = 0x40, SEQOP = 0x20, ODR = 0x04, INTPOL = 0x02;
+
+  explicit MCP23017Model(uint8_t address = 0x20) : I2CDevice(address) {
+    reset();
+  }
+
+  // Power-on reset (also what a brown-out or a RESET pulse does to the chip)
+  void reset() {
+    memset(regs, 0, sizeof(regs));
+    regs[IODIR] = regs[IODIR + 1] = 0xFF;
+    _pointer = 0;
+    _previous[0] = pinLevels(0);
+    _previous[1] = pinLevels(1);
+  }
+
+  void onWrite(const uint8_t* data, uint8_t len) override {
+    if (len == 0) return;
+    _pointer = data[0];
+    for (uint8_t i = 1; i < len; i++) {
+      const int8_t reg = regIndex(_pointer);
+      if (reg >= 0) writeReg((uint8_t)reg, data[i]);
+      advance();
+    }
+  }
+
+  void onRead(uint8_t* data, uint8_t len) override {
+    for (uint8_t i = 0; i < len; i++) {
+      const int8_t reg = regIndex(_pointer);
+      data[i] = reg >= 0 ? readReg((uint8_t)reg) : 0;
+      advance();
+    }
+  }
+
+  // Test side: drive input pin 0-15 (A0-A7 = 0-7, B0-B7 = 8-15); undriven inputs float high
+  void setInput(uint8_t pin, bool level) {
+    if (level) external |= (uint16_t)(1 << pin);
+    else       external &= (uint16_t)~(1 << pin);
+    checkInterrupt(pin >> 3);
+  }
+
+  // Level on an output pin (OLAT where IODIR is 0); true for pins configured as inputs
+  bool outputLevel(uint8_t pin) const {
+    const uint8_t port = pin >> 3, bit = 1 << (pin & 7);
+    return (regs[IODIR + port] & bit) ? true : (regs[OLAT + port] & bit) != 0;
+  }
+
+  // Interrupt pending on a port, and the electrical level of its INT pin (port 0 = INTA)
+  bool interruptPending(uint8_t port) const {
+    return regs[INTF + port] != 0 || ((regs[IOCON] & MIRROR) && regs[INTF + (port ^ 1)] != 0);
+  }
+  bool intPin(uint8_t port) const {
+    const bool active = interruptPending(port);
+    if (regs[IOCON] & ODR) return !active;   // Open drain, pulled up
+    return (regs[IOCON] & INTPOL) ? active : !active;
+  }
+
+  uint8_t regs[NUM_REGS];
+  uint16_t external = 0xFFFF;
+
+private:
+  // Bus address to BANK = 0 register index, -1 if unimplemented
+  int8_t regIndex(uint8_t address) const {
+    if (regs[IOCON] & BANK) {
+      const uint8_t base = address & 0x0F;
+      if (address > 0x1A || base > 0x0A) return -1;
+      return (int8_t)(base * 2 + (address >> 4));
+    }
+    return address < NUM_REGS ? (int8_t)address : -1;
+  }
+
+  void advance() {
+    const uint8_t iocon = regs[IOCON];
+    if (iocon & SEQOP) {
+      if (!(iocon & BANK)) _pointer ^= 1;     // Byte mode: toggle within the A/B pair
+      return;
+    }
+    const uint8_t last = (iocon & BANK) ? 0x1A : NUM_REGS - 1;
+    _pointer = _pointer >= last ? 0 : _pointer + 1;
+  }
+
+  uint8_t pinLevels(uint8_t port) const {
+    const uint8_t ext = (uint8_t)(external >> (8 * port));
+    const uint8_t dir = regs[IODIR + port];
+    return (uint8_t)((regs[OLAT + port] & ~dir) | (ext & dir));
+  }
+
+  uint8_t portValue(uint8_t port) const {
+    return pinLevels(port) ^ (regs[IPOL + port] & regs[IODIR + port]);
+  }
+
+  void writeReg(uint8_t reg, uint8_t value) {
+    const uint8_t port = reg & 1;
+    switch (reg & ~1) {
+      case GPIO: regs[OLAT + port] = value; break;
+      case IOCON: regs[IOCON] = regs[IOCON + 1] = value & 0xFE; break;   // One register, bit 0 unused
+      case INTF: break;                       // Read-only
+      case INTCAP: break;                     // Read-only
+      default: regs[reg] = value; break;
+    }
+    checkInterrupt(port);
+  }
+
+  uint8_t readReg(uint8_t reg) {
+    const uint8_t port = reg & 1;
+    switch (reg & ~1) {
+      case GPIO: {
+        const uint8_t value = portValue(port);
+        clearInterrupt(port);
+        return value;
+      }
+      case INTCAP: {
+        const uint8_t value = regs[reg];
+        clearInterrupt(port);
+        return value;
+      }
+      default:
+        return regs[reg];
+    }
+  }
+
+  void checkInterrupt(uint8_t port) {
+    const uint8_t levels = pinLevels(port);
+    const uint8_t enabled = regs[GPINTEN + port] & regs[IODIR + port];
+    const uint8_t reference = (regs[DEFVAL + port] & regs[INTCON + port]) |
+                              (_previous[port] & ~regs[INTCON + port]);
+    const uint8_t fired = (levels ^ reference) & enabled;
+    _previous[port] = levels;
+    if (fired == 0 || regs[INTF + port] != 0) return;
+    regs[INTF + port] = fired;
+    regs[INTCAP + port] = portValue(port);
+  }
+
+  void clearInterrupt(uint8_t port) {
+    regs[INTF + port] = 0;
+    checkInterrupt(port);   // A DEFVAL mismatch that is still there fires again
+  }
+
+  uint8_t _pointer = 0;
+  uint8_t _previous[2] = {0xFF, 0xFF};   // Pin levels at the last check, for INTCON = 0
+};
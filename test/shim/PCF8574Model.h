@@ -0,0 +1,26 @@
+#pragma once
+// PCF8574 quasi-bidirectional port: a write sets the latch (1 = weak pull-up), a read returns
+// the latch with every pin pulled low by an external switch cleared.
+#include <Wire.h>
+
+class PCF8574Model : public I2CDevice {
+public:
+  explicit PCF8574Model(uint8_t address) : I2CDevice(address) {}
+
+  void onWrite(const uint8_t* data, uint8_t len) override {
+    if (len > 0) latch = data[len - 1];
+  }
+
+  void onRead(uint8_t* data, uint8_t len) override {
+    for (uint8_t i = 0; i < len; i++) data[i] = latch & (uint8_t)~pulledLow;
+  }
+
+  // Close (true) or open a switch to GND on pin P0..P7
+  void setSwitch(uint8_t pin, bool closed) {
+    if (closed) pulledLow |= (uint8_t)(1 << pin);
+    else        pulledLow &= (uint8_t)~(1 << pin);
+  }
+
+  uint8_t latch = 0xFF;      // Power-on: all pins high
+  uint8_t pulledLow = 0;
+};
@@ -0,0 +1,296 @@
+#pragma once
+// Fuzzing the safe dial and Simon Says with arbitrary input and timing. An input is a series of
+// two-byte steps: set, flip or bounce switches and buttons, press what the puzzle expects next,
+// let time pass at some loop rate, or reset() as the manager's key cycle does. After every
+// update() the puzzle's invariants hold and the call stayed within its time budget (the longest
+// blocking animation the puzzle has by design). After the last step everything is released and
+// the puzzle is left alone: it must come to rest waiting for the player, and played properly from
+// there it must get solved, so no state is without a way out.
+// Each fuzzer returns nullptr, or the first violation and the step it happened at.
+// libFuzzer entry points are in test/fuzz/; test_puzzle_fuzz runs fixed pseudo-random inputs.
+#include <stdio.h>
+#include <Arduino.h>
+#include "MCP23017Model.h"
+#include "PCF8574Model.h"
+#include "SevenSegCodePuzzle.h"
+#include "SimonSaysPuzzle.h"
+
+struct PuzzleFuzz {
+  static constexpr size_t MAX_STEPS = 512;
+  static constexpr uint32_t SEVEN_SEG_BUDGET_US = 5000000UL;   // Failure ritual: up to 4.2 s
+  static constexpr uint32_t SIMON_BUDGET_US = 3000000UL;       // Last press of a song and its fanfare: 2.3 s
+
+  // How far an input got, for judging what the fuzzing reaches
+  struct Stats {
+    size_t steps = 0;
+    bool solvedByInput = false;   // Solved during the steps, before the idle check played it through
+    uint32_t maxUpdateUs = 0;
+  };
+
+  // First byte: code length 1-4
+  static const char* sevenSeg(const uint8_t* data, size_t size, Stats* stats = nullptr) {
+    static const uint16_t CODES[4] = {0x7, 0x42, 0x197, 0x9197};
+    static const uint8_t DIGIT_SEGMENTS[10] = {0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F};
+    static const uint8_t BUTTON = 7;
+    static PCF8574Model pcf(0x25);
+    shim::resetArduino();
+    Serial.reset();
+    Wire.detachAll();
+    pcf = PCF8574Model(0x25);
+    Wire.attach(&pcf);
+
+    const uint8_t length = size > 0 ? 1 + data[0] % 4 : 4;
+    const uint16_t code = CODES[length - 1];
+    SevenSegCodePuzzle p(10, 11, 0x25, &code, 1, length);
+    p.begin();
+    bool solved = false;
+    size_t step = 0;
+    Stats local;
+    Stats& st = stats != nullptr ? *stats : local;
+    st = Stats();
+
+    auto tick = [&](uint32_t ms) -> const char* {
+      shim::advanceMs(ms);
+      const uint32_t start = micros();
+      p.update(millis());
+      if (micros() - start > st.maxUpdateUs) st.maxUpdateUs = micros() - start;
+      if (st.maxUpdateUs > SEVEN_SEG_BUDGET_US) return "update() over its time budget";
+      return check(p, solved);
+    };
+    auto run = [&](uint32_t ms, uint32_t tickMs) -> const char* {
+      for (const uint32_t end = millis() + ms; (int32_t)(millis() - end) < 0;) {
+        if (const char* v = tick(tickMs)) return v;
+      }
+      return nullptr;
+    };
+    auto setSwitches = [&](uint8_t segments) {
+      for (uint8_t pin = 0; pin < 7; pin++) pcf.setSwitch(pin, (segments >> pin) & 1);
+    };
+    auto dial = [&](uint8_t digit) -> const char* {
+      setSwitches(DIGIT_SEGMENTS[digit]);
+      if (const char* v = run(60, 5)) return v;
+      pcf.setSwitch(BUTTON, true);
+      if (const char* v = run(60, 5)) return v;
+      pcf.setSwitch(BUTTON, false);
+      setSwitches(0);
+      return run(60, 5);
+    };
+
+    for (size_t i = 1; i + 1 < size && step < MAX_STEPS; i += 2, step++) {
+      const uint8_t op = data[i], arg = data[i + 1];
+      const char* v = nullptr;
+      switch (op & 7) {
+        case 0:   // Any switch mask
+          setSwitches(arg);
+          v = tick(1);
+          break;
+        case 1:   // A digit's pattern
+          setSwitches(DIGIT_SEGMENTS[arg % 10]);
+          v = tick(1);
+          break;
+        case 2:
+          pcf.setSwitch(BUTTON, arg & 1);
+          v = tick(1);
+          break;
+        case 3:   // Time passes at a 1-32 ms loop
+          v = run(arg, 1 + (op >> 3));
+          break;
+        case 4:   // Button bounce: 1-16 edges 1-16 ms apart, then a settled level
+          for (uint8_t edge = 0; edge <= (arg & 15) && v == nullptr; edge++) {
+            pcf.setSwitch(BUTTON, !(pcf.pulledLow & (1 << BUTTON)));
+            v = tick(1 + (arg >> 4));
+          }
+          pcf.setSwitch(BUTTON, op & 8);
+          break;
+        case 5:   // The next digit of the code
+          if (p._state != SevenSegCodePuzzle::State::LOCKED) v = dial(codeDigit(code, length, p._nStored));
+          break;
+        case 6:   // One switch flips
+          pcf.setSwitch(arg & 7, !(pcf.pulledLow & (1 << (arg & 7))));
+          v = tick(1);
+          break;
+        case 7:
+          if (arg < 8) {
+            p.reset();
+            solved = false;
+            v = p.isSolved() ? "isSolved() after reset()" : nullptr;
+          } else {
+            v = tick(0);   // Same millisecond
+          }
+          break;
+      }
+      if (v != nullptr) return fail(step, v);
+    }
+    st.steps = step;
+    st.solvedByInput = solved;
+
+    // Let go and leave it alone: back to the preview, then the code still opens it
+    pcf.pulledLow = 0;
+    if (const char* v = run(1000, 5)) return fail(step, v);
+    if (p._state != SevenSegCodePuzzle::State::PREVIEW && p._state != SevenSegCodePuzzle::State::LOCKED) {
+      return fail(step, "not back in the preview after 1 s idle");
+    }
+    for (uint8_t n = 0; n < length && p._nStored != 0; n++) {
+      if (const char* v = dial(0)) return fail(step, v);   // Finish the entry in progress
+    }
+    for (uint8_t n = 0; n < length && !p.isSolved(); n++) {
+      if (const char* v = dial(codeDigit(code, length, n))) return fail(step, v);
+    }
+    return p.isSolved() ? nullptr : fail(step, "the code no longer opens it");
+  }
+
+  // First byte: bit 7 set for procedural rounds, length 1-8 (bits 0-2) from buttons in bits 3-6
+  static const char* simon(const uint8_t* data, size_t size, Stats* stats = nullptr) {
+    static MCP23017Model mcp(0x20);
+    static Adafruit_MCP23X17 driver;
+    shim::resetArduino();
+    Serial.reset();
+    Wire.detachAll();
+    mcp = MCP23017Model(0x20);
+    Wire.attach(&mcp);
+    driver.begin_I2C(0x20);
+
+    SimonSaysPuzzle s(&driver, 5);
+    if (size > 0 && (data[0] & 0x80)) s.useProceduralSequences(1 + (data[0] & 7), (data[0] >> 3) & 0x0F);
+    s.begin();
+    bool solved = false;
+    size_t step = 0;
+    Stats local;
+    Stats& st = stats != nullptr ? *stats : local;
+    st = Stats();
+
+    auto tick = [&](uint32_t ms) -> const char* {
+      shim::advanceMs(ms);
+      const uint32_t start = micros();
+      s.update(millis());
+      if (micros() - start > st.maxUpdateUs) st.maxUpdateUs = micros() - start;
+      if (st.maxUpdateUs > SIMON_BUDGET_US) return "update() over its time budget";
+      return check(s, solved);
+    };
+    auto run = [&](uint32_t ms, uint32_t tickMs) -> const char* {
+      for (const uint32_t end = millis() + ms; (int32_t)(millis() - end) < 0;) {
+        if (const char* v = tick(tickMs)) return v;
+      }
+      return nullptr;
+    };
+    auto setButtons = [&](uint8_t mask) {
+      for (uint8_t b = 0; b < 4; b++) mcp.setInput(8 + b, !((mask >> b) & 1));   // Active low
+    };
+    auto press = [&](uint8_t mask) -> const char* {
+      setButtons(0);
+      if (const char* v = run(50, 10)) return v;
+      setButtons(mask);
+      if (const char* v = run(20, 10)) return v;
+      setButtons(0);
+      return run(20, 10);
+    };
+    auto pressExpected = [&]() -> const char* {
+      return press(1 << s._stepAt(s._playerIndex));
+    };
+
+    for (size_t i = 1; i + 1 < size && step < MAX_STEPS; i += 2, step++) {
+      const uint8_t op = data[i], arg = data[i + 1];
+      const char* v = nullptr;
+      switch (op & 7) {
+        case 0:   // Any button mask, chords included
+          setButtons(arg);
+          v = tick(1);
+          break;
+        case 1:   // The button it waits for, or any
+          v = s._state == SimonSaysPuzzle::State::WAITING_INPUT ? pressExpected() : press(1 << (arg & 3));
+          break;
+        case 2:
+          v = press(SimonSaysPuzzle::START_CHORD);
+          break;
+        case 3:   // Time passes at a 1-32 ms loop
+          v = run(arg, 1 + (op >> 3));
+          break;
+        case 4:   // Bounce: 1-16 edges 1-16 ms apart on one button, then released
+          for (uint8_t edge = 0; edge <= (arg >> 4) && v == nullptr; edge++) {
+            mcp.setInput(8 + (arg & 3), edge & 1);
+            v = tick(1 + (op >> 4));
+          }
+          setButtons(0);
+          break;
+        case 5:   // Walk away for up to 25 s: input timeouts
+          v = run(arg * 100UL, 50);
+          break;
+        case 6:
+          v = tick(0);   // Same millisecond
+          break;
+        case 7:
+          if (arg < 8) {
+            s.reset();
+            solved = false;
+            v = s.isSolved() ? "isSolved() after reset()" : nullptr;
+          } else {
+            v = press(1 << (arg & 3));
+          }
+          break;
+      }
+      if (v != nullptr) return fail(step, v);
+    }
+    st.steps = step;
+    st.solvedByInput = solved;
+
+    // Let go and leave it alone: four input timeouts, each followed by a replay, end in a reset
+    setButtons(0);
+    if (const char* v = run(90000, 10)) return fail(step, v);
+    if (!s.isSolved() && s._state != SimonSaysPuzzle::State::WAITING_TO_START) {
+      return fail(step, "not waiting for the start chord after 90 s idle");
+    }
+    // Then every song (or generated round) can still be played through
+    for (const uint32_t start = millis(); !s.isSolved() && millis() - start < 600000UL;) {
+      const char* v = nullptr;
+      if (s._state == SimonSaysPuzzle::State::WAITING_TO_START) {
+        v = press(SimonSaysPuzzle::START_CHORD);
+      } else if (s._state == SimonSaysPuzzle::State::WAITING_INPUT) {
+        v = pressExpected();
+      } else {
+        v = tick(10);
+      }
+      if (v != nullptr) return fail(step, v);
+    }
+    return s.isSolved() ? nullptr : fail(step, "not solved after 10 min of correct play");
+  }
+
+private:
+  static uint8_t codeDigit(uint16_t code, uint8_t length, uint8_t index) {
+    return (code >> (4 * (length - 1 - index))) & 0x0F;
+  }
+
+  static const char* fail(size_t step, const char* what) {
+    static char message[96];
+    snprintf(message, sizeof(message), "step %u: %s", (unsigned)step, what);
+    return message;
+  }
+
+  static const char* check(const SevenSegCodePuzzle& p, bool& solved) {
+    typedef SevenSegCodePuzzle::State State;
+    if (p._state == State::VALIDATE) return "update() returned with a snapshot unvalidated";
+    if (p._nStored >= p._codeLength && p._state != State::LOCKED) return "stored digit count out of range";
+    if (p._entry & ~p.codeMask()) return "entry wider than the code";
+    for (uint8_t i = 0; i < p._nStored && i < p._codeLength; i++) {
+      if (((p._entry >> (4 * i)) & 0x0F) > 9) return "stored digit not BCD";
+    }
+    if (p._solved != (p._state == State::LOCKED)) return "solved and LOCKED disagree";
+    if (solved && !p.isSolved()) return "isSolved() went back to false";
+    solved = p.isSolved();
+    return nullptr;
+  }
+
+  static const char* check(SimonSaysPuzzle& s, bool& solved) {
+    if (s._currentRound >= 3 && !s._solved) return "round past the last song";
+    if (s._currentLength < 1 || s._currentLength > s._getCurrentSequenceLength()) return "build-up length out of range";
+    if (s._state == SimonSaysPuzzle::State::PLAYING_SEQUENCE && s._sequenceIndex >= s._currentLength) {
+      return "playback past the build-up length";
+    }
+    if (s._state == SimonSaysPuzzle::State::WAITING_INPUT && s._playerIndex >= s._currentLength) {
+      return "input position past the build-up length";
+    }
+    if (s._timeoutCount >= 4) return "timeout count past the reset";
+    if (solved && !s.isSolved()) return "isSolved() went back to false";
+    solved = s.isSolved();
+    return nullptr;
+  }
+};
@@ -0,0 +1,263 @@
+#pragma once
+// Scripted escape sessions against the sketch (include after main.cpp, like SketchSession.h).
+// A scenario is a list of statements separated by ';' or new lines; '#' starts a comment.
+// A statement may start with t=<time>, which first runs loop() until that time after the start.
+// Times are a number with an optional unit: 300, 300ms, 1.2s (default ms).
+//
+//   key on|off                 key switch, then 200 ms
+//   tilt up|down               tilt switch
+//   dial 9197                  set each digit's segments and press enter
+//   knock x4 @300ms            four knocks, 300 ms apart
+//   knock 300,600,300          knocks at these gaps (ms)
+//   nfc 04:A6:89:72:3C:4D:80 [char 1914] [for 300ms]
+//                              amiibo in the field (default character 1914, 300 ms), then away
+//   simon chord                start chord (buttons 1, 2, 4)
+//   simon press 0,1,1          press buttons by index 0-3
+//   simon play                 watch the LEDs and play every pass back until solved
+//   serial STATUS              serial command, then 100 ms
+//   wait 2s                    run loop() for a while
+//   expect "text"              serial output contains text after the previous expect's match
+//   expect solved 3            puzzle 3 is solved (unsolved 3: not solved)
+//   expect unlocked            all puzzles solved and the box opened (locked: not)
+//
+// report() prints the session's solve times and loop statistics (the STATS command) plus the
+// simulated time spent in loop() and the I2C bytes.
+#include <string>
+#include "SketchSession.h"
+
+namespace session {
+
+class Scenario {
+public:
+  // Run a script from the current state; false with error() set on a bad statement or a failed
+  // expectation, which stops the script
+  bool run(const char* script) {
+    _error.clear();
+    _start = millis();
+    _expectFrom = Serial.output().size();
+    _line = 1;
+    std::string statement;
+    bool quoted = false;
+    for (const char* c = script;; c++) {
+      if (*c == '"') quoted = !quoted;
+      if (*c == '#' && !quoted) {
+        while (*c != '\n' && *c != '\0') c++;
+      }
+      if (*c == '\0' || *c == '\n' || (*c == ';' && !quoted)) {
+        if (!execute(trim(statement))) return false;
+        statement.clear();
+        quoted = false;
+        if (*c == '\0') return true;
+        if (*c == '\n') _line++;
+        continue;
+      }
+      statement += *c;
+    }
+  }
+
+  const std::string& error() const { return _error; }
+
+  void report() {
+    const size_t from = Serial.output().size();
+    command("STATS");
+    printf("%s", Serial.output().c_str() + from);
+    printf("Simulated time in loop(): %lu us, I2C bytes: %lu\n", (unsigned long)cpuUs, (unsigned long)Wire.bytes);
+  }
+
+private:
+  bool execute(const std::string& statement) {
+    std::string rest = statement;
+    if (rest.compare(0, 2, "t=") == 0) {
+      uint32_t at;
+      if (!parseTime(word(rest.erase(0, 2)), at)) return fail("bad time in " + statement);
+      const uint32_t elapsed = millis() - _start;
+      if (at < elapsed) return fail(statement + ": already " + std::to_string(elapsed) + " ms in");
+      session::run(at - elapsed);
+    }
+    const std::string action = word(rest);
+    if (action.empty()) return true;
+
+    if (action == "key" || action == "tilt") {
+      const std::string state = word(rest);
+      const bool on = state == (action == "key" ? "on" : "up");
+      if (!on && state != (action == "key" ? "off" : "down")) return fail("bad " + action + " state " + state);
+      if (action == "key") {
+        key(on);
+      } else {
+        tilt(on);
+      }
+    } else if (action == "dial") {
+      const std::string digits = word(rest);
+      if (digits.empty() || digits.find_first_not_of("0123456789") != std::string::npos) {
+        return fail("bad code " + digits);
+      }
+      dial(digits.c_str());
+    } else if (action == "knock") {
+      return knocks(rest);
+    } else if (action == "nfc") {
+      return nfc(rest);
+    } else if (action == "simon") {
+      return simon(rest);
+    } else if (action == "serial") {
+      if (rest.empty()) return fail("serial needs a command");
+      command(rest.c_str());
+      rest.clear();
+    } else if (action == "wait") {
+      uint32_t ms;
+      if (!parseTime(word(rest), ms)) return fail("bad time in " + statement);
+      session::run(ms);
+    } else if (action == "expect") {
+      return expect(rest);
+    } else {
+      return fail("unknown action " + action);
+    }
+    return rest.empty() || fail("unexpected " + rest);
+  }
+
+  bool knocks(std::string& rest) {
+    uint16_t gaps[16];
+    uint8_t n = 0;
+    const std::string first = word(rest);
+    if (!first.empty() && first[0] == 'x') {
+      // xN @gap: N knocks, N-1 equal gaps
+      const long count = strtol(first.c_str() + 1, nullptr, 10);
+      const std::string at = word(rest);
+      uint32_t gap;
+      if (count < 1 || count > 17 || at.empty() || at[0] != '@' || !parseTime(at.substr(1), gap)) {
+        return fail("knock xN @gap");
+      }
+      for (n = 0; n < count - 1; n++) gaps[n] = (uint16_t)gap;
+    } else {
+      for (size_t i = 0; i < first.size() && n < 16;) {
+        const size_t comma = first.find(',', i);
+        uint32_t gap;
+        if (!parseTime(first.substr(i, comma - i), gap)) return fail("bad knock gaps " + first);
+        gaps[n++] = (uint16_t)gap;
+        i = comma == std::string::npos ? first.size() : comma + 1;
+      }
+      if (n == 0) return fail("knock needs gaps");
+    }
+    knock(gaps, n);
+    return rest.empty() || fail("unexpected " + rest);
+  }
+
+  bool nfc(std::string& rest) {
+    const std::string uidText = word(rest);
+    uint8_t uid[7];
+    uint8_t len = 0;
+    for (size_t i = 0; i < uidText.size() && len < 7; i += 3) {
+      char* end = nullptr;
+      uid[len++] = (uint8_t)strtoul(uidText.substr(i, 2).c_str(), &end, 16);
+      if (*end != '\0' || (i + 2 < uidText.size() && uidText[i + 2] != ':')) return fail("bad UID " + uidText);
+    }
+    if (len != 7 || uidText.size() != 20) return fail("nfc needs a 7-byte UID, got " + uidText);
+
+    uint32_t character = 0x1914, ms = 300;   // Goomba, the box's original figure
+    while (!rest.empty()) {
+      const std::string option = word(rest);
+      const std::string value = word(rest);
+      char* end = nullptr;
+      if (option == "char") {
+        character = strtoul(value.c_str(), &end, 16);
+        if (value.empty() || *end != '\0' || character > 0xFFFF) return fail("bad character " + value);
+      } else if (option != "for" || !parseTime(value, ms)) {
+        return fail("unexpected " + option + " " + value);
+      }
+    }
+    _tag = shim::amiiboTag(uid, (uint16_t)character);
+    present(&_tag, ms);
+    return true;
+  }
+
+  bool simon(std::string& rest) {
+    const std::string what = word(rest);
+    if (what == "chord") {
+      simonChord();
+    } else if (what == "play") {
+      playSimon();
+    } else if (what == "press") {
+      const std::string buttons = word(rest);
+      if (buttons.empty()) return fail("simon press needs buttons");
+      for (size_t i = 0; i < buttons.size(); i += 2) {
+        if (buttons[i] < '0' || buttons[i] > '3' || (i + 1 < buttons.size() && buttons[i + 1] != ',')) {
+          return fail("bad buttons " + buttons);
+        }
+      }
+      for (size_t i = 0; i < buttons.size(); i += 2) press(buttons[i] - '0');
+    } else {
+      return fail("simon chord|press|play, got " + what);
+    }
+    return rest.empty() || fail("unexpected " + rest);
+  }
+
+  bool expect(std::string& rest) {
+    if (!rest.empty() && rest[0] == '"') {
+      const size_t close = rest.find('"', 1);
+      if (close == std::string::npos || close + 1 != rest.size()) return fail("unterminated text");
+      const std::string text = rest.substr(1, close - 1);
+      const size_t at = Serial.output().find(text, _expectFrom);
+      if (at == std::string::npos) return fail("expected \"" + text + "\" in the serial output");
+      _expectFrom = at + text.size();
+      return true;
+    }
+    const std::string what = word(rest);
+    if (what == "unlocked" || what == "locked") {
+      if (manager.allSolved() != (what == "unlocked")) return fail("expected the box " + what);
+    } else if (what == "solved" || what == "unsolved") {
+      const std::string index = word(rest);
+      if (index.size() != 1 || index[0] < '0' || index[0] >= (char)('0' + NUM_PUZZLES)) {
+        return fail("bad puzzle " + index);
+      }
+      if (puzzles[index[0] - '0']->isSolved() != (what == "solved")) {
+        const char* name = reinterpret_cast<const char*>(puzzles[index[0] - '0']->name());   // F() is a plain string here
+        return fail("expected puzzle " + index + " (" + name + ") " + what);
+      }
+    } else {
+      return fail("expect \"text\"|solved N|unsolved N|unlocked|locked, got " + what);
+    }
+    return rest.empty() || fail("unexpected " + rest);
+  }
+
+  bool fail(const std::string& message) {
+    _error = "line " + std::to_string(_line) + ": " + message;
+    return false;
+  }
+
+  static std::string trim(const std::string& s) {
+    const size_t first = s.find_first_not_of(" \t\r");
+    if (first == std::string::npos) return std::string();
+    return s.substr(first, s.find_last_not_of(" \t\r") - first + 1);
+  }
+
+  // Take the first space-separated word off s
+  static std::string word(std::string& s) {
+    s = trim(s);
+    const size_t end = s.find_first_of(" \t");
+    const std::string w = s.substr(0, end);
+    s = end == std::string::npos ? std::string() : trim(s.substr(end));
+    return w;
+  }
+
+  static bool parseTime(const std::string& text, uint32_t& ms) {
+    char* end = nullptr;
+    const double value = strtod(text.c_str(), &end);
+    if (end == text.c_str() || value < 0) return false;
+    const std::string unit = end;
+    if (unit == "s") {
+      ms = (uint32_t)(value * 1000 + 0.5);
+    } else if (unit == "ms" || unit.empty()) {
+      ms = (uint32_t)(value + 0.5);
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  std::string _error;
+  uint32_t _start = 0;
+  size_t _expectFrom = 0;
+  uint16_t _line = 1;
+  shim::NfcTag _tag;
+};
+
+}  // namespace session
@@ -0,0 +1,24 @@
+#pragma once
+// Host stand-in for the Servo library: remembers the pin and the last angle
+#include <Arduino.h>
+
+class Servo {
+public:
+  uint8_t attach(int pin) {
+    _pin = pin;
+    return 0;
+  }
+  void detach() { _pin = -1; }
+  bool attached() const { return _pin >= 0; }
+  void write(int angle) {
+    _angle = angle;
+    writes++;
+  }
+  int read() const { return _angle; }
+
+  uint32_t writes = 0;
+
+private:
+  int _pin = -1;
+  int _angle = 90;
+};
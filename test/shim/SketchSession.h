@@ -0,0 +1,155 @@
+#pragma once
+// The outside world around the sketch's loop(), for suites that build src/main.cpp itself.
+// Include after main.cpp: the helpers use its pins, addresses and puzzle instances.
+// loop() runs every simulated millisecond; cpuUs accumulates the fake time spent inside it.
+#include <Arduino.h>
+#include <Wire.h>
+#include "MCP23017Model.h"
+#include "PCF8574Model.h"
+#include "ADXL345Model.h"
+
+namespace session {
+
+static MCP23017Model mcp(MCP_LED_ADDR);
+static PCF8574Model pcf(PCF_ADDR);
+static ADXL345Model adxl;
+static uint32_t cpuUs = 0;
+
+// Segment patterns a..g (= PCF P0..P6) per digit; P7 is the enter button
+static const uint8_t DIGIT_SEGMENTS[10] = {0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F};
+
+// Fresh clock, bus, serial and EEPROM with every device of the box attached
+inline void attach() {
+  shim::resetArduino();
+  Serial.reset();
+  Wire.detachAll();
+  EEPROM.erase();
+  shim::pn532().reset();
+  Wire.attach(&mcp);
+  Wire.attach(&pcf);
+  Wire.attach(&adxl);
+  Wire.attach(&shim::pn532());
+}
+
+// Loop every millisecond for ms milliseconds, accounting the time spent inside loop()
+inline void run(uint32_t ms) {
+  const uint32_t end = millis() + ms;
+  while ((int32_t)(millis() - end) < 0) {
+    shim::advanceMs(1);
+    const uint32_t t0 = micros();
+    loop();
+    cpuUs += micros() - t0;
+  }
+}
+
+// Power on with the key turned and wait for the jingle to finish
+inline void boot() {
+  shim::setPin(KEY_PIN, LOW);
+  shim::setPin(TILT_PIN, LOW);
+  setup();
+  run(1000);
+}
+
+inline void command(const char* text) {
+  Serial.input(text);
+  Serial.input("\n");
+  run(100);
+}
+
+inline void key(bool on) {
+  shim::setPin(KEY_PIN, on ? LOW : HIGH);
+  run(200);
+}
+
+// Tilt switch on D4 (active high); in pin-change mode the PCINT2 vector fires like on the AVR
+inline void tilt(bool up) {
+  shim::setPin(TILT_PIN, up ? HIGH : LOW);
+  if ((PCICR & _BV(PCIE2)) && (*digitalPinToPCMSK(TILT_PIN) & _BV(digitalPinToPCMSKbit(TILT_PIN)))) {
+    PCINT2_vect();
+  }
+}
+
+inline void dial(const char* digits) {
+  for (const char* c = digits; *c; c++) {
+    for (uint8_t pin = 0; pin < 7; pin++) pcf.setSwitch(pin, (DIGIT_SEGMENTS[*c - '0'] >> pin) & 1);
+    run(100);
+    pcf.setSwitch(7, true);
+    run(100);
+    pcf.setSwitch(7, false);
+    for (uint8_t pin = 0; pin < 7; pin++) pcf.setSwitch(pin, false);
+    run(100);
+  }
+}
+
+// Knocks on the lid at the given gaps (ms)
+inline void knock(const uint16_t* gaps, uint8_t n) {
+  for (uint8_t i = 0; i <= n; i++) {
+    adxl.script(0, 0, 256 + 300);
+    run(i < n ? gaps[i] : 200);
+  }
+}
+
+inline void present(const shim::NfcTag* tag, uint32_t ms) {
+  shim::pn532().tag = tag;
+  run(ms);
+  shim::pn532().tag = nullptr;
+  run(1000);   // Away long enough to count again
+}
+
+// Simon buttons B0-B3 (active low), each held 30 ms after a 100 ms gap
+inline void press(uint8_t button) {
+  run(100);
+  mcp.setInput(8 + button, false);
+  run(30);
+  mcp.setInput(8 + button, true);
+}
+
+// Start chord: buttons 1, 2 and 4 together
+inline void simonChord() {
+  run(100);
+  mcp.setInput(8, false);
+  mcp.setInput(9, false);
+  mcp.setInput(11, false);
+  run(30);
+  mcp.setInput(8, true);
+  mcp.setInput(9, true);
+  mcp.setInput(11, true);
+}
+
+inline uint8_t litSimonLeds() {
+  uint8_t lit = 0;
+  for (uint8_t b = 0; b < 4; b++) {
+    if (!mcp.outputLevel(12 + b)) lit |= 1 << b;
+  }
+  return lit;
+}
+
+// Watch Simon's LEDs (B4-B7, active low) and play back each pass, starting every song with the
+// chord, until it is solved or maxMs have passed
+inline void playSimon(uint32_t maxMs = 600000) {
+  uint8_t seq[64], len = 0, lit = litSimonLeds();
+  size_t from = Serial.output().size();
+  const uint32_t start = millis();
+  simonChord();
+  while (!simonPuzzle.isSolved() && millis() - start < maxMs) {
+    run(1);
+    const uint8_t now = litSimonLeds();
+    for (uint8_t b = 0; b < 4; b++) {
+      if ((now & ~lit & (1 << b)) && len < sizeof(seq)) seq[len++] = b;
+    }
+    lit = now;
+    const size_t turn = Serial.output().find("Your turn!", from);
+    const size_t ready = Serial.output().find("simultaneously to start", from);
+    if (turn != std::string::npos) {
+      from = turn + 1;
+      for (uint8_t i = 0; i < len; i++) press(seq[i]);
+      len = 0;
+      lit = litSimonLeds();
+    } else if (ready != std::string::npos) {
+      from = ready + 1;
+      simonChord();
+    }
+  }
+}
+
+}  // namespace session
@@ -0,0 +1,60 @@
+#pragma once
+// Host stand-in for TM1637Display: keeps the segments and brightness last sent.
+// Each setSegments() is one bit-banged transfer (~1.3 ms on the real module).
+// Puzzles own their display, so the most recently constructed one is reachable as last().
+#include <Arduino.h>
+
+#define SEG_A 0x01
+#define SEG_B 0x02
+#define SEG_C 0x04
+#define SEG_D 0x08
+#define SEG_E 0x10
+#define SEG_F 0x20
+#define SEG_G 0x40
+#define SEG_DP 0x80
+
+class TM1637Display {
+public:
+  static constexpr uint32_t TRANSFER_US = 1300;
+
+  TM1637Display(uint8_t pinClk, uint8_t pinDIO, unsigned int bitDelay = 100) {
+    (void)pinClk; (void)pinDIO; (void)bitDelay;
+    lastRef() = this;
+  }
+
+  static TM1637Display* last() { return lastRef(); }
+
+  void setBrightness(uint8_t brightness, bool on = true) {
+    _pendingBrightness = (brightness & 0x07) | (on ? 0x08 : 0x00);
+  }
+
+  void setSegments(const uint8_t segments[], uint8_t length = 4, uint8_t pos = 0) {
+    for (uint8_t i = 0; i < length && pos + i < 4; i++) shown[pos + i] = segments[i];
+    brightness = _pendingBrightness;
+    transfers++;
+    shim::advanceUs(TRANSFER_US);
+  }
+
+  void clear() {
+    const uint8_t blank[4] = {0, 0, 0, 0};
+    setSegments(blank);
+  }
+
+  uint8_t encodeDigit(uint8_t digit) { return DIGITS[digit & 0x0F]; }
+
+  // Test side
+  uint8_t shown[4] = {0, 0, 0, 0};
+  uint8_t brightness = 0;
+  uint32_t transfers = 0;
+
+private:
+  static TM1637Display*& lastRef() { static TM1637Display* d = nullptr; return d; }
+
+  static constexpr uint8_t DIGITS[16] = {
+    0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07,
+    0x7F, 0x6F, 0x77, 0x7C, 0x39, 0x5E, 0x79, 0x71
+  };
+  uint8_t _pendingBrightness = 0x0F;
+};
+
+constexpr uint8_t TM1637Display::DIGITS[16];
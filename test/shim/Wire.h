@@ -0,0 +1,119 @@
+#pragma once
+// Host stand-in for the Wire library: a bus of I2CDevice models, one per address.
+// Every transfer advances the fake clock by its time on a 100 kHz bus (9 bit times per byte,
+// address byte included), so micros() around an update() measures its I2C cost.
+// Transfers are counted per device; endTransmission() and requestFrom() are one each.
+// bytes totals every byte clocked on the bus, address bytes included.
+#include <Arduino.h>
+
+class I2CDevice {
+public:
+  explicit I2CDevice(uint8_t address) : _address(address) {}
+  virtual ~I2CDevice() {}
+
+  uint8_t address() const { return _address; }
+
+  // Master write: register pointer and/or data bytes (len may be 0, a probe)
+  virtual void onWrite(const uint8_t* data, uint8_t len) = 0;
+  // Master read of len bytes
+  virtual void onRead(uint8_t* data, uint8_t len) = 0;
+
+  // false: the device does not acknowledge its address
+  bool present = true;
+  uint32_t transactions = 0;
+
+private:
+  uint8_t _address;
+};
+
+class TwoWire {
+public:
+  static constexpr uint8_t BUFFER_LENGTH = 32;
+  static constexpr uint8_t MAX_DEVICES = 8;
+  static constexpr uint32_t BYTE_US = 90;   // 9 bits at 100 kHz
+
+  void begin() {}
+  void setClock(uint32_t) {}
+
+  void beginTransmission(uint8_t address) {
+    _txAddress = address;
+    _txLen = 0;
+  }
+  void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+
+  size_t write(uint8_t b) {
+    if (_txLen >= BUFFER_LENGTH) return 0;
+    _tx[_txLen++] = b;
+    return 1;
+  }
+  size_t write(const uint8_t* data, size_t len) {
+    size_t n = 0;
+    while (n < len && write(data[n])) n++;
+    return n;
+  }
+
+  // 0 = ok, 2 = address NACK (Arduino codes)
+  uint8_t endTransmission(bool stop = true) {
+    (void)stop;
+    shim::advanceUs((1 + _txLen) * BYTE_US);
+    bytes += 1 + _txLen;
+    I2CDevice* dev = find(_txAddress);
+    if (dev == nullptr) return 2;
+    dev->transactions++;
+    dev->onWrite(_tx, _txLen);
+    return 0;
+  }
+
+  uint8_t requestFrom(int address, int quantity) {
+    _rxLen = _rxPos = 0;
+    if (quantity > BUFFER_LENGTH) quantity = BUFFER_LENGTH;
+    I2CDevice* dev = find((uint8_t)address);
+    if (dev == nullptr) {
+      shim::advanceUs(BYTE_US);
+      bytes++;
+      return 0;
+    }
+    shim::advanceUs((1 + quantity) * BYTE_US);
+    bytes += 1 + quantity;
+    dev->transactions++;
+    dev->onRead(_rx, (uint8_t)quantity);
+    _rxLen = (uint8_t)quantity;
+    return _rxLen;
+  }
+
+  int available() { return _rxLen - _rxPos; }
+  int read() { return _rxPos < _rxLen ? _rx[_rxPos++] : -1; }
+
+  // Test side
+  void attach(I2CDevice* dev) {
+    for (uint8_t i = 0; i < MAX_DEVICES; i++) {
+      if (_devices[i] == nullptr) { _devices[i] = dev; return; }
+    }
+  }
+  void detachAll() {
+    for (uint8_t i = 0; i < MAX_DEVICES; i++) _devices[i] = nullptr;
+    _rxLen = _rxPos = 0;
+    bytes = 0;
+  }
+
+  uint32_t bytes = 0;
+
+private:
+  I2CDevice* find(uint8_t address) const {
+    for (uint8_t i = 0; i < MAX_DEVICES; i++) {
+      if (_devices[i] != nullptr && _devices[i]->present && _devices[i]->address() == address) {
+        return _devices[i];
+      }
+    }
+    return nullptr;
+  }
+
+  I2CDevice* _devices[MAX_DEVICES] = {};
+  uint8_t _txAddress = 0;
+  uint8_t _tx[BUFFER_LENGTH];
+  uint8_t _txLen = 0;
+  uint8_t _rx[BUFFER_LENGTH];
+  uint8_t _rxLen = 0, _rxPos = 0;
+};
+
+static TwoWire Wire;
@@ -0,0 +1,93 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "Debouncer.h"
+
+// 20 ms debounce: one sample every 5 ms, a change needs 4 disagreeing samples
+
+void setUp() {}
+void tearDown() {}
+
+// Feed a constant raw value for samples consecutive sample slots; returns the time after them
+template <class D>
+static uint32_t feed(D& d, typename D::Bits raw, uint8_t samples, uint32_t t) {
+  for (uint8_t i = 0; i < samples; i++, t += 5) d.update(raw, t);
+  return t;
+}
+
+void test_samples_at_most_every_quarter_debounce() {
+  Debouncer<SymmetricDebounce, 1> d(20);
+  d.reset(0);
+  TEST_ASSERT_TRUE(d.update(1, 5));
+  TEST_ASSERT_FALSE(d.update(1, 9));
+  TEST_ASSERT_TRUE(d.update(1, 10));
+}
+
+void test_symmetric_press_needs_four_samples() {
+  Debouncer<SymmetricDebounce, 1> d(20);
+  d.reset(0);
+  uint32_t t = feed(d, 1, 3, 5);
+  TEST_ASSERT_EQUAL_UINT8(0, d.state());
+  d.update(1, t);
+  TEST_ASSERT_EQUAL_UINT8(1, d.state());
+  TEST_ASSERT_EQUAL_UINT8(1, d.pressed());
+  TEST_ASSERT_EQUAL_UINT8(0, d.released());
+  // Edges last for one update only
+  d.update(1, t + 5);
+  TEST_ASSERT_EQUAL_UINT8(0, d.pressed());
+}
+
+void test_chatter_restarts_the_count() {
+  Debouncer<SymmetricDebounce, 1> d(20);
+  d.reset(0);
+  uint32_t t = feed(d, 1, 3, 5);
+  t = feed(d, 0, 1, t);          // Bounce back: counter cleared
+  t = feed(d, 1, 3, t);
+  TEST_ASSERT_EQUAL_UINT8(0, d.state());
+  feed(d, 1, 1, t);
+  TEST_ASSERT_EQUAL_UINT8(1, d.state());
+}
+
+void test_fast_press_passes_presses_and_debounces_releases() {
+  Debouncer<FastPressDebounce, 4> d(20);
+  d.reset(0);
+  d.update(0x05, 5);
+  TEST_ASSERT_EQUAL_UINT8(0x05, d.state());
+  TEST_ASSERT_EQUAL_UINT8(0x05, d.pressed());
+  // Releasing button 0 takes four samples, button 2 stays down
+  uint32_t t = feed(d, 0x04, 3, 10);
+  TEST_ASSERT_EQUAL_UINT8(0x05, d.state());
+  d.update(0x04, t);
+  TEST_ASSERT_EQUAL_UINT8(0x04, d.state());
+  TEST_ASSERT_EQUAL_UINT8(0x01, d.released());
+}
+
+void test_bits_are_independent() {
+  Debouncer<SymmetricDebounce, 8> d(20);
+  d.reset(0x80);
+  uint32_t t = feed(d, 0x81, 2, 5);   // Bit 0 starts counting
+  t = feed(d, 0x01, 2, t);            // Bit 7 starts counting two samples later
+  TEST_ASSERT_EQUAL_HEX8(0x81, d.state());
+  TEST_ASSERT_EQUAL_HEX8(0x01, d.pressed());
+  t = feed(d, 0x01, 1, t);
+  TEST_ASSERT_EQUAL_HEX8(0x81, d.state());
+  feed(d, 0x01, 1, t);
+  TEST_ASSERT_EQUAL_HEX8(0x01, d.state());
+  TEST_ASSERT_EQUAL_HEX8(0x80, d.released());
+}
+
+void test_word_width_follows_input_count() {
+  TEST_ASSERT_EQUAL(1, (int)sizeof(Debouncer<SymmetricDebounce, 8>::Bits));
+  TEST_ASSERT_EQUAL(2, (int)sizeof(Debouncer<SymmetricDebounce, 9>::Bits));
+  TEST_ASSERT_EQUAL(4, (int)sizeof(Debouncer<SymmetricDebounce, 17>::Bits));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_samples_at_most_every_quarter_debounce);
+  RUN_TEST(test_symmetric_press_needs_four_samples);
+  RUN_TEST(test_chatter_restarts_the_count);
+  RUN_TEST(test_fast_press_passes_presses_and_debounces_releases);
+  RUN_TEST(test_bits_are_independent);
+  RUN_TEST(test_word_width_follows_input_count);
+  return UNITY_END();
+}
@@ -0,0 +1,61 @@
+static const Golden GOLDEN_boot = {
+  "boot",
+  R"golden(
+=== SintBox Puzzle System Starting ===
+Waiting for key to be turned on...
+Key detected! Initializing system...
+[Accel] ADXL345 initialized
+[Accel] Gravity calibrated: 0,0,256 LSB
+PuzzleManager: Initializing...
+  MCP23017 at address 0x20
+  LEDs configured
+  P0: TM1637 Safe Dial
+7Seg init
+7Seg OK
+  P1: Tilt Sensor
+  P2: Simon Says
+Simon Says puzzle reset
+  P3: Amiibo
+NFCAmiiboPuzzle: Initializing...
+[NFC] Allowlist not found in EEPROM, formatting
+NFCAmiiboPuzzle: PN532 firmware 0x1
+NFCAmiiboPuzzle: Ready! 1 tag(s) on the allowlist
+  P4: Knock Detection
+[Knock] Requires 4 rhythm knocks within # ms, threshold 3.50 m/s^2
+  Servo: 9
+Locking box (servo angle 0)
+PuzzleManager: Ready!
+Simon Says puzzle reset
+Press buttons 1, 2, and 4 simultaneously to start the game!
+Simon Says B pins configured
+Simon Says puzzle initialized
+Round 1: Zie ginds komt de stoomboot
+Round 2: Sinterklaas kapoentje
+Round 3: O, kom er eens kijken
+System ready!
+> STATUS
+System status: Puzzles in progress...
+  Puzzle 0 (TM1637 Safe Dial): Active
+  Puzzle 1 (Tilt Sensor): Active
+  Puzzle 2 (Simon Says): Active
+  Puzzle 3 (Amiibo): Active
+  Puzzle 4 (Knock Detection): Active
+  Alarms: 0 drop(s), 0 shake(s)
+  NFC: 10 polls, interval # ms, 0 recoveries
+  NFC power: RF on 21%, off 78%, powerdown 0%; est. 24 mA avg vs 60 mA always-on
+> NFCLIST
+NFC allowlist: 1/16
+  04:A6:89:72:3C:4D:80 SOLVE
+NFCAmiiboPuzzle: Required character not set
+> KNOCKCFG
+[Knock] threshold=3.50 m/s^2 hysteresis=0.50 quiet=# ms window=# ms
+> KNOCKCFG 3.5 ABC 50
+Usage: KNOCKCFG <threshold 0-156.9> <hysteresis 0-1> <quietMs up to the window>
+> SIMONGEN
+Simon Says: songs
+> FOO
+Unknown command: FOO
+Available: RESET, UNLOCK, LOCK, STATUS, STATS, LEDTEST, SIMONTEST, SIMONGEN, KNOCKREC, KNOCKCFG, LATENCY [ON|OFF], BENCH, NFCLIST, NFCADD, NFCDEL, NFCLEARN, NFCCHAR
+)golden",
+  1124208, 11434
+};
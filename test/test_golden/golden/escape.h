@@ -0,0 +1,127 @@
+static const Golden GOLDEN_escape = {
+  "escape",
+  R"golden(
+WARNING: P0 (TM1637 Safe Dial) update() took # us
+Puzzle 0 (TM1637 Safe Dial): SOLVED!
+Tilt sensor activated! Hold for 10 seconds...
+Tilt countdown: 10 seconds remaining
+Tilt countdown: 9 seconds remaining
+Tilt countdown: 8 seconds remaining
+Tilt countdown: 7 seconds remaining
+Tilt countdown: 6 seconds remaining
+Tilt countdown: 5 seconds remaining
+Tilt countdown: 4 seconds remaining
+Tilt countdown: 3 seconds remaining
+Tilt countdown: 2 seconds remaining
+Tilt countdown: 1 seconds remaining
+*** Tilt sensor puzzle SOLVED! ***
+Puzzle 1 (Tilt Sensor): SOLVED!
+Buttons 1, 2, 4 pressed simultaneously - Simon Says starting! Get ready...
+WARNING: P2 (Simon Says) update() took # us
+Round 1 - Length 1/6 - Watch and listen...
+Your turn! Repeat the sequence...
+Correct! Length 1 completed.
+Building up to length 2
+Round 1 - Length 2/6 - Watch and listen...
+WARNING: P2 (Simon Says) update() took # us
+Your turn! Repeat the sequence...
+Correct! Length 2 completed.
+Building up to length 3
+Round 1 - Length 3/6 - Watch and listen...
+Your turn! Repeat the sequence...
+Correct! Length 3 completed.
+Building up to length 4
+Round 1 - Length 4/6 - Watch and listen...
+Your turn! Repeat the sequence...
+Correct! Length 4 completed.
+Building up to length 5
+Round 1 - Length 5/6 - Watch and listen...
+Your turn! Repeat the sequence...
+Correct! Length 5 completed.
+Building up to length 6
+Round 1 - Length 6/6 - Watch and listen...
+Your turn! Repeat the sequence...
+Correct! Length 6 completed.
+Song 1 completed!
+Round 2 ready - press buttons 1, 2, and 4 simultaneously to start!
+WARNING: P2 (Simon Says) update() took # us
+Buttons 1, 2, 4 pressed simultaneously - Simon Says starting! Get ready...
+Round 2 - Length 1/6 - Watch and listen...
+Your turn! Repeat the sequence...
+Correct! Length 1 completed.
+Building up to length 2
+Round 2 - Length 2/6 - Watch and listen...
+Your turn! Repeat the sequence...
+Correct! Length 2 completed.
+Building up to length 3
+Round 2 - Length 3/6 - Watch and listen...
+Your turn! Repeat the sequence...
+Correct! Length 3 completed.
+Building up to length 4
+Round 2 - Length 4/6 - Watch and listen...
+Your turn! Repeat the sequence...
+Correct! Length 4 completed.
+Building up to length 5
+Round 2 - Length 5/6 - Watch and listen...
+Your turn! Repeat the sequence...
+Correct! Length 5 completed.
+Building up to length 6
+Round 2 - Length 6/6 - Watch and listen...
+Your turn! Repeat the sequence...
+Correct! Length 6 completed.
+Song 2 completed!
+Round 3 ready - press buttons 1, 2, and 4 simultaneously to start!
+Buttons 1, 2, 4 pressed simultaneously - Simon Says starting! Get ready...
+Round 3 - Length 1/6 - Watch and listen...
+Your turn! Repeat the sequence...
+Correct! Length 1 completed.
+Building up to length 2
+Round 3 - Length 2/6 - Watch and listen...
+Your turn! Repeat the sequence...
+Correct! Length 2 completed.
+Building up to length 3
+Round 3 - Length 3/6 - Watch and listen...
+Your turn! Repeat the sequence...
+Correct! Length 3 completed.
+Building up to length 4
+Round 3 - Length 4/6 - Watch and listen...
+Your turn! Repeat the sequence...
+Correct! Length 4 completed.
+Building up to length 5
+Round 3 - Length 5/6 - Watch and listen...
+Your turn! Repeat the sequence...
+Correct! Length 5 completed.
+Building up to length 6
+Round 3 - Length 6/6 - Watch and listen...
+Your turn! Repeat the sequence...
+Correct! Length 6 completed.
+Song 3 completed!
+*** Simon Says puzzle SOLVED! All rounds completed! ***
+Puzzle 2 (Simon Says): SOLVED!
+NFCAmiiboPuzzle: Detected UID[7]: 04:A6:89:72:3C:4D:80
+NFCAmiiboPuzzle: AMIIBO ACCEPTED! PUZZLE SOLVED!
+NFCAmiiboPuzzle: Character 1914
+NFCAmiiboPuzzle: Required character 1914
+WARNING: P3 (Amiibo) update() took # us
+Puzzle 3 (Amiibo): SOLVED!
+[Knock] hit dyn^2=90000 thresh^2=8364 face=Z- gap=# ms
+[Knock] Sequence started (1/4)
+[Knock] hit dyn^2=89401 thresh^2=8364 face=Z- gap=# ms
+[Knock] Knock detected (2/4)
+NFCAmiiboPuzzle: PN532 powered down
+[Knock] hit dyn^2=90000 thresh^2=8364 face=Z- gap=# ms
+[Knock] Knock detected (3/4)
+[Knock] hit dyn^2=88804 thresh^2=8364 face=Z- gap=# ms
+[Knock] Knock detected (4/4)
+[Knock] ✓ SOLVED! Correct knock sequence detected
+Puzzle 4 (Knock Detection): SOLVED!
+*** ALL PUZZLES SOLVED - UNLOCKING BOX! ***
+Unlocking box (servo angle 140)
+> STATUS
+System status: ALL SOLVED! Box unlocked.
+  Alarms: 0 drop(s), 0 shake(s)
+  NFC: 677 polls, interval # ms, 0 recoveries
+  NFC power: RF on 92%, off 3%, powerdown 3%; est. 56 mA avg vs 60 mA always-on
+)golden",
+  84561038, 484219
+};
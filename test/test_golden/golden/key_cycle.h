@@ -0,0 +1,48 @@
+static const Golden GOLDEN_key_cycle = {
+  "key_cycle",
+  R"golden(
+Key turned OFF - resetting all state
+*** Resetting all puzzles ***
+Simon Says puzzle reset
+Press buttons 1, 2, and 4 simultaneously to start the game!
+NFCAmiiboPuzzle: Reset
+NFCAmiiboPuzzle: PN532 firmware 0x1
+[Knock] Reset
+Locking box (servo angle 0)
+All puzzles reset, box locked
+Puzzle 0 (TM1637 Safe Dial): Reset
+Puzzle 1 (Tilt Sensor): Reset
+Puzzle 2 (Simon Says): Reset
+Puzzle 3 (Amiibo): Reset
+Puzzle 4 (Knock Detection): Reset
+> NFCADD 04:11:22:33:44:55:66 HINT
+Added
+> NFCADD 04:77:88:99:AA:BB:CC ADMIN
+Added
+Puzzle 0 (TM1637 Safe Dial): SOLVED!
+NFCAmiiboPuzzle: Detected UID[7]: 04:11:22:33:44:55:66
+NFCAmiiboPuzzle: Hint tag
+Hint: still open: Tilt Sensor Simon Says Amiibo Knock Detection
+NFCAmiiboPuzzle: Detected UID[7]: 04:77:88:99:AA:BB:CC
+NFCAmiiboPuzzle: Admin tag, reset requested
+*** Admin tag reset ***
+*** Resetting all puzzles ***
+Simon Says puzzle reset
+Press buttons 1, 2, and 4 simultaneously to start the game!
+NFCAmiiboPuzzle: Reset
+[Knock] Reset
+All puzzles reset, box locked
+Puzzle 0 (TM1637 Safe Dial): Reset
+> STATUS
+System status: Puzzles in progress...
+  Puzzle 0 (TM1637 Safe Dial): Active
+  Puzzle 1 (Tilt Sensor): Active
+  Puzzle 2 (Simon Says): Active
+  Puzzle 3 (Amiibo): Active
+  Puzzle 4 (Knock Detection): Active
+  Alarms: 0 drop(s), 0 shake(s)
+  NFC: 13 polls, interval # ms, 0 recoveries
+  NFC power: RF on 93%, off 3%, powerdown 3%; est. 56 mA avg vs 60 mA always-on
+)golden",
+  9314436, 46704
+};
@@ -0,0 +1,152 @@
+// Golden serial-trace regression: the real sketch (src/main.cpp) runs canonical sessions against
+// the shim's device models, and each scenario's serial transcript is compared with its golden
+// file in golden/. Timestamps and durations (a number followed by ms or us) are masked, so only
+// log content and format count. Each scenario also has a budget for the simulated time spent
+// inside loop() and the bytes moved on the I2C bus; going more than TOLERANCE_PERCENT over
+// either fails. On a mismatch the run writes golden_<name>.actual to the working directory, in
+// the golden file format, for review and copying over.
+// The scenarios run in order in one boot of the sketch, each ending where the next starts.
+#include <Arduino.h>
+#include <unity.h>
+#include "main.cpp"
+#include "SketchSession.h"
+
+using namespace session;
+
+struct Golden {
+  const char* name;
+  const char* transcript;   // Masked, "\n" line ends, leading newline ignored
+  uint32_t cpuUs;           // Budget: simulated time inside loop()
+  uint32_t i2cBytes;        // Budget: bytes on the bus
+};
+
+#include "golden/boot.h"
+#include "golden/escape.h"
+#include "golden/key_cycle.h"
+
+static const uint8_t TOLERANCE_PERCENT = 10;
+
+static const uint8_t GOOMBA_UID[7] = {0x04, 0xA6, 0x89, 0x72, 0x3C, 0x4D, 0x80};
+static const uint8_t HINT_UID[7] = {0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+static const uint8_t ADMIN_UID[7] = {0x04, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC};
+static const shim::NfcTag goomba = shim::amiiboTag(GOOMBA_UID, 0x1914);
+static const shim::NfcTag hintTag = shim::amiiboTag(HINT_UID, 0x0000);
+static const shim::NfcTag adminTag = shim::amiiboTag(ADMIN_UID, 0x0001);
+
+// ---- Comparison ----
+
+// "\r\n" to "\n"; a number followed by ms or us (optionally after a space) to "#"
+static std::string mask(const std::string& text) {
+  std::string out;
+  for (size_t i = 0; i < text.size();) {
+    if (text[i] == '\r') {
+      i++;
+      continue;
+    }
+    if (isdigit((unsigned char)text[i]) && (i == 0 || !isalnum((unsigned char)text[i - 1]))) {
+      size_t j = i;
+      while (j < text.size() && isdigit((unsigned char)text[j])) j++;
+      const size_t unit = j < text.size() && text[j] == ' ' ? j + 1 : j;
+      if (text.compare(unit, 2, "ms") == 0 || text.compare(unit, 2, "us") == 0) {
+        out += '#';
+        i = j;
+        continue;
+      }
+    }
+    out += text[i++];
+  }
+  return out;
+}
+
+static void writeActual(const Golden& g, const std::string& transcript, uint32_t bytes) {
+  const std::string path = std::string("golden_") + g.name + ".actual";
+  FILE* f = fopen(path.c_str(), "w");
+  if (f == nullptr) return;
+  fprintf(f, "static const Golden GOLDEN_%s = {\n  \"%s\",\n  R\"golden(\n%s)golden\",\n  %lu, %lu\n};\n",
+          g.name, g.name, transcript.c_str(), (unsigned long)cpuUs, (unsigned long)bytes);
+  fclose(f);
+  printf("  %s: wrote %s\n", g.name, path.c_str());
+}
+
+// Compare the transcript and costs since the last check with the golden file, then start afresh
+static void check(const Golden& g) {
+  const std::string actual = mask(Serial.output());
+  std::string expected = g.transcript;
+  if (!expected.empty() && expected[0] == '\n') expected.erase(0, 1);
+  const uint32_t bytes = Wire.bytes;
+  printf("  %s: %lu us in loop(), %lu I2C bytes (budget %lu us, %lu bytes)\n", g.name,
+         (unsigned long)cpuUs, (unsigned long)bytes, (unsigned long)g.cpuUs, (unsigned long)g.i2cBytes);
+
+  const bool sameText = actual == expected;
+  const bool cpuOk = cpuUs <= g.cpuUs + g.cpuUs / 100 * TOLERANCE_PERCENT;
+  const bool busOk = bytes <= g.i2cBytes + g.i2cBytes / 100 * TOLERANCE_PERCENT;
+  if (!sameText) {
+    // First differing line, for the failure message
+    size_t at = 0;
+    while (at < actual.size() && at < expected.size() && actual[at] == expected[at]) at++;
+    const size_t line = actual.rfind('\n', at) == std::string::npos ? 0 : actual.rfind('\n', at) + 1;
+    printf("  %s: transcript differs at \"%s\"\n", g.name, actual.substr(line, actual.find('\n', at) - line).c_str());
+  }
+  if (!sameText || !cpuOk || !busOk) writeActual(g, actual, bytes);
+  Serial.clearOutput();
+  cpuUs = 0;
+  Wire.bytes = 0;
+  TEST_ASSERT_TRUE_MESSAGE(sameText, "serial transcript differs from the golden file");
+  TEST_ASSERT_TRUE_MESSAGE(cpuOk, "time inside loop() over budget");
+  TEST_ASSERT_TRUE_MESSAGE(busOk, "I2C bytes over budget");
+}
+
+void setUp() {}
+void tearDown() {}
+
+// ---- Scenarios ----
+
+// Power on with the key turned, boot, service commands
+void test_boot() {
+  boot();
+  command("status");
+  command("NFCLIST");
+  command("KNOCKCFG");
+  command("KNOCKCFG 3.5 abc 50");
+  command("SIMONGEN");
+  command("FOO");
+  check(GOLDEN_boot);
+}
+
+// Every puzzle solved in turn until the box opens
+void test_escape() {
+  dial("9197");
+  tilt(true);
+  run(10500);
+  tilt(false);
+  playSimon();
+  present(&goomba, 300);
+  static const uint16_t rhythm[] = {300, 600, 300};
+  knock(rhythm, 3);
+  run(3000);
+  command("STATUS");
+  check(GOLDEN_escape);
+}
+
+// Key off and on again; hint and admin tags act on the new session
+void test_key_cycle() {
+  key(false);
+  key(true);
+  run(3000);
+  command("NFCADD 04:11:22:33:44:55:66 HINT");
+  command("NFCADD 04:77:88:99:AA:BB:CC ADMIN");
+  dial("9197");
+  present(&hintTag, 300);
+  present(&adminTag, 300);
+  command("STATUS");
+  check(GOLDEN_key_cycle);
+}
+
+int main(int argc, char** argv) {
+  session::attach();
+  UNITY_BEGIN();
+  RUN_TEST(test_boot);
+  RUN_TEST(test_escape);
+  RUN_TEST(test_key_cycle);
+  return UNITY_END();
+}
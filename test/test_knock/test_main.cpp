@@ -0,0 +1,215 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "ADXL345Model.h"
+#include "KnockDetectionPuzzle.h"
+
+static ADXL345Model adxl;
+
+// An impulse of one sample on top of gravity, scheduled relative to the start of run()
+struct Hit {
+  uint32_t atMs;
+  int16_t x, y, z;
+};
+
+struct Rig {
+  SensorHub hub;
+  KnockDetectionPuzzle knock;
+  Rig() : knock(hub) {}
+
+  void begin() {
+    hub.begin();
+    knock.begin();
+  }
+
+  // 10 ms loop for ms milliseconds, injecting the hits on schedule
+  void run(uint32_t ms, const Hit* hits = nullptr, uint8_t n = 0) {
+    const uint32_t start = millis();
+    uint8_t next = 0;
+    while (millis() - start < ms) {
+      while (next < n && millis() - start >= hits[next].atMs) {
+        adxl.script(hits[next].x, hits[next].y, (int16_t)(256 + hits[next].z));
+        next++;
+      }
+      shim::advanceMs(10);
+      hub.update(millis());
+      knock.update(millis());
+    }
+  }
+};
+
+// Knock from above: a +Z impulse, classified as the Z- face
+static Hit lid(uint32_t atMs) { return Hit{atMs, 0, 0, 300}; }
+// Knock on the X+ face: the impulse points away from it
+static Hit sideXPos(uint32_t atMs) { return Hit{atMs, -300, 0, 0}; }
+
+void setUp() {
+  shim::resetArduino();
+  Serial.reset();
+  Wire.detachAll();
+  adxl.reset();
+  Wire.attach(&adxl);
+}
+void tearDown() {}
+
+void test_needs_the_accelerometer() {
+  Wire.detachAll();
+  Rig rig;
+  rig.begin();
+  TEST_ASSERT_TRUE(Serial.printed("[Knock] ERROR"));
+  rig.run(100);
+  TEST_ASSERT_FALSE(rig.knock.isSolved());
+}
+
+void test_four_knocks_solve() {
+  Rig rig;
+  rig.begin();
+  rig.run(500);
+  const Hit three[] = {lid(0), lid(250), lid(500)};
+  rig.run(600, three, 3);
+  TEST_ASSERT_FALSE(rig.knock.isSolved());
+  const Hit fourth[] = {lid(150)};
+  rig.run(300, fourth, 1);
+  TEST_ASSERT_TRUE(rig.knock.isSolved());
+}
+
+void test_sequence_times_out() {
+  Rig rig;
+  rig.begin();
+  const Hit two[] = {lid(0), lid(250)};
+  rig.run(2600, two, 2);
+  TEST_ASSERT_TRUE(Serial.printed("Sequence timed out with 2/4"));
+  const Hit hits[] = {lid(0), lid(250), lid(500)};
+  rig.run(800, hits, 3);
+  TEST_ASSERT_FALSE(rig.knock.isSolved());   // 3 of a fresh sequence, not 2 + 3
+}
+
+void test_quiet_period_merges_close_impulses() {
+  Rig rig;
+  rig.begin();
+  // Rebounds 20 ms apart: the 50 ms quiet period lets only the first and the one at 60 ms count
+  const Hit hits[] = {lid(0), lid(20), lid(40), lid(60)};
+  rig.run(300, hits, 4);
+  TEST_ASSERT_TRUE(Serial.printed("Knock detected (2/4)"));
+  TEST_ASSERT_FALSE(Serial.printed("Knock detected (3/4)"));
+}
+
+void test_sustained_shaking_is_one_knock() {
+  Rig rig;
+  rig.begin();
+  adxl.script(0, 0, 600, 20);   // 100 ms above threshold: never re-arms
+  rig.run(300);
+  TEST_ASSERT_TRUE(Serial.printed("Sequence started"));
+  TEST_ASSERT_FALSE(Serial.printed("Knock detected"));
+}
+
+void test_rhythm_matches_at_any_tempo() {
+  static const uint16_t gaps[] = {200, 200, 400};
+  Rig rig;
+  rig.knock.setPattern(gaps, 3, 10);
+  rig.begin();
+  const Hit fast[] = {lid(0), lid(150), lid(300), lid(600)};   // Same rhythm, 25% faster
+  rig.run(800, fast, 4);
+  TEST_ASSERT_TRUE(rig.knock.isSolved());
+}
+
+void test_rhythm_mismatch_is_rejected() {
+  static const uint16_t gaps[] = {200, 200, 400};
+  Rig rig;
+  rig.knock.setPattern(gaps, 3, 10);
+  rig.begin();
+  const Hit wrong[] = {lid(0), lid(400), lid(600), lid(800)};
+  rig.run(1000, wrong, 4);
+  TEST_ASSERT_FALSE(rig.knock.isSolved());
+  TEST_ASSERT_TRUE(Serial.printed("Rhythm mismatch"));
+}
+
+void test_face_sequence() {
+  static const KnockDetectionPuzzle::Face faces[] = {
+    KnockDetectionPuzzle::Face::Z_NEG, KnockDetectionPuzzle::Face::X_POS, KnockDetectionPuzzle::Face::Z_NEG
+  };
+  Rig rig;
+  rig.knock.setFaceSequence(faces, 3);
+  rig.begin();
+  const Hit wrong[] = {lid(0), lid(250), lid(500)};
+  rig.run(700, wrong, 3);
+  TEST_ASSERT_TRUE(Serial.printed("Wrong faces knocked"));
+  TEST_ASSERT_FALSE(rig.knock.isSolved());
+
+  rig.run(2500);   // Let the failed attempt time out
+  const Hit right[] = {lid(0), sideXPos(250), lid(500)};
+  rig.run(700, right, 3);
+  TEST_ASSERT_TRUE(rig.knock.isSolved());
+}
+
+void test_solved_puzzle_releases_the_responsive_idle() {
+  Rig rig;
+  rig.begin();
+  adxl.latchEvents(0x08);   // Inactivity
+  rig.run(50);
+  TEST_ASSERT_EQUAL_HEX8(0x0A, adxl.regs[0x2C]);   // Waiting for the opening knock: 100 Hz
+  const Hit hits[] = {lid(0), lid(250), lid(500), lid(750)};
+  rig.run(900, hits, 4);
+  TEST_ASSERT_TRUE(rig.knock.isSolved());
+  rig.run(50);
+  TEST_ASSERT_EQUAL_HEX8(0x19, adxl.regs[0x2C]);   // Low-power idle
+}
+
+void test_reset_clears_the_sequence() {
+  Rig rig;
+  rig.begin();
+  const Hit three[] = {lid(0), lid(250), lid(500)};
+  rig.run(600, three, 3);
+  rig.knock.reset();
+  const Hit one[] = {lid(0)};
+  rig.run(200, one, 1);
+  TEST_ASSERT_FALSE(rig.knock.isSolved());
+}
+
+void test_configure_rejects_values_the_detector_cannot_use() {
+  Rig rig;
+  rig.begin();
+  const float nan = 0.0f / 0.0f;
+  TEST_ASSERT_FALSE(rig.knock.configure(0, 0.5, 50));        // Never re-arms
+  TEST_ASSERT_FALSE(rig.knock.configure(-3, 0.5, 50));
+  TEST_ASSERT_FALSE(rig.knock.configure(nan, 0.5, 50));
+  TEST_ASSERT_FALSE(rig.knock.configure(1e9, 0.5, 50));      // Beyond the sensor range
+  TEST_ASSERT_FALSE(rig.knock.configure(3, 0, 50));          // Never re-arms
+  TEST_ASSERT_FALSE(rig.knock.configure(3, 1.5, 50));
+  TEST_ASSERT_FALSE(rig.knock.configure(3, nan, 50));
+  TEST_ASSERT_FALSE(rig.knock.configure(0.05, 0.5, 50));     // Re-arm level below one LSB
+  TEST_ASSERT_FALSE(rig.knock.configure(3, 0.5, 5000));      // Longer than the 2 s window
+  TEST_ASSERT_FALSE(Serial.printed("[Knock] threshold="));
+
+  // The old configuration still detects knocks
+  const Hit hits[] = {lid(0), lid(300), lid(600), lid(900)};
+  rig.run(1200, hits, 4);
+  TEST_ASSERT_TRUE(rig.knock.isSolved());
+}
+
+void test_configure_applies_valid_values() {
+  Rig rig;
+  rig.begin();
+  TEST_ASSERT_TRUE(rig.knock.configure(20, 1, 0));
+  TEST_ASSERT_TRUE(Serial.printed("[Knock] threshold=20.00 m/s^2 hysteresis=1.00 quiet=0 ms"));
+  // 300 LSB is about 11.5 m/s^2: below the new threshold
+  const Hit hits[] = {lid(0), lid(300), lid(600), lid(900)};
+  rig.run(1200, hits, 4);
+  TEST_ASSERT_FALSE(rig.knock.isSolved());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_needs_the_accelerometer);
+  RUN_TEST(test_four_knocks_solve);
+  RUN_TEST(test_sequence_times_out);
+  RUN_TEST(test_quiet_period_merges_close_impulses);
+  RUN_TEST(test_sustained_shaking_is_one_knock);
+  RUN_TEST(test_rhythm_matches_at_any_tempo);
+  RUN_TEST(test_rhythm_mismatch_is_rejected);
+  RUN_TEST(test_face_sequence);
+  RUN_TEST(test_solved_puzzle_releases_the_responsive_idle);
+  RUN_TEST(test_reset_clears_the_sequence);
+  RUN_TEST(test_configure_rejects_values_the_detector_cannot_use);
+  RUN_TEST(test_configure_applies_valid_values);
+  return UNITY_END();
+}
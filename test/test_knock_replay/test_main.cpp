@@ -0,0 +1,148 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "KnockReplay.h"
+
+static ADXL345Model adxl;
+
+// KNOCKREC on the model at 100 Hz: knocks from the lid at the given sample indices, rest around them
+static std::string record(const uint16_t* knockAt, uint8_t n, uint16_t samples) {
+  shim::resetArduino();
+  Serial.reset();
+  Wire.detachAll();
+  adxl.reset();
+  Wire.attach(&adxl);
+  SensorHub hub;
+  hub.setDataRates(SensorHub::Rate::HZ_100, SensorHub::Rate::HZ_100);
+  hub.begin();
+  Serial.clearOutput();
+
+  uint16_t next = 0;
+  for (uint8_t i = 0; i < n; i++) {
+    adxl.script(0, 0, 256, knockAt[i] - next);
+    adxl.script(0, 0, 256 + 300);
+    next = knockAt[i] + 1;
+  }
+  Serial.inputAt(micros() + samples * 10000UL + 5000, "x");
+  hub.recordSamples();
+  return Serial.output();
+}
+
+static std::string frame(uint16_t dt, int16_t x, int16_t y, int16_t z) {
+  const uint8_t f[9] = {0xA5, (uint8_t)dt, (uint8_t)(dt >> 8), (uint8_t)x, (uint8_t)((uint16_t)x >> 8),
+                        (uint8_t)y, (uint8_t)((uint16_t)y >> 8), (uint8_t)z, (uint8_t)((uint16_t)z >> 8)};
+  return std::string((const char*)f, sizeof(f));
+}
+
+// The box's rhythm, 300/600/300 ms: knocks at 0.5, 0.8, 1.4 and 1.7 s
+static const uint16_t RHYTHM[] = {49, 79, 139, 169};
+
+void setUp() {}
+void tearDown() {}
+
+void test_recording_replays_to_the_same_knocks() {
+  const std::string capture = record(RHYTHM, 4, 250);
+  KnockRecording recording;
+  std::string error;
+  TEST_ASSERT_TRUE_MESSAGE(recording.parse(capture, error), error.c_str());
+  TEST_ASSERT_EQUAL_UINT32(10000, recording.periodUs);
+  TEST_ASSERT_UINT32_WITHIN(2, 250, recording.frames.size());
+  TEST_ASSERT_EQUAL_UINT32(0, recording.overflows);
+
+  const KnockReplayResult r = replayKnocks(recording, KnockVariant());
+  TEST_ASSERT_TRUE(r.valid);
+  TEST_ASSERT_EQUAL(4, r.hitsMs.size());
+  const uint32_t expectedMs[] = {500, 800, 1400, 1700};
+  for (uint8_t i = 0; i < 4; i++) TEST_ASSERT_UINT32_WITHIN(10, expectedMs[i], r.hitsMs[i]);
+  TEST_ASSERT_EQUAL_INT((int32_t)r.hitsMs[3], r.solvedMs);
+  TEST_ASSERT_TRUE(r.log.find("s [Knock] hit dyn^2=") != std::string::npos);
+  TEST_ASSERT_TRUE(r.log.find("[Knock] ✓ SOLVED!") != std::string::npos);
+}
+
+void test_variants_change_the_outcome() {
+  const std::string capture = record(RHYTHM, 4, 250);
+  KnockRecording recording;
+  std::string error;
+  TEST_ASSERT_TRUE(recording.parse(capture, error));
+
+  KnockVariant deaf;
+  deaf.threshold = 20;   // Above the 11.5 m/s^2 knocks
+  TEST_ASSERT_EQUAL(0, replayKnocks(recording, deaf).hitsMs.size());
+
+  KnockVariant even;
+  const uint16_t evenGaps[] = {300, 300, 300};
+  memcpy(even.rhythm, evenGaps, sizeof(evenGaps));
+  const KnockReplayResult wrongRhythm = replayKnocks(recording, even);
+  TEST_ASSERT_EQUAL(4, wrongRhythm.hitsMs.size());
+  TEST_ASSERT_EQUAL_INT(-1, wrongRhythm.solvedMs);
+  TEST_ASSERT_TRUE(wrongRhythm.log.find("Rhythm mismatch") != std::string::npos);
+
+  KnockVariant counting;
+  counting.rhythmLen = 0;
+  TEST_ASSERT_TRUE(replayKnocks(recording, counting).solvedMs >= 0);
+
+  // A quiet period longer than the 300 ms gaps swallows the knock after each of them
+  KnockVariant slow;
+  slow.quietMs = 400;
+  TEST_ASSERT_EQUAL(2, replayKnocks(recording, slow).hitsMs.size());
+}
+
+void test_out_of_range_variant_is_refused() {
+  KnockRecording recording;
+  std::string error;
+  TEST_ASSERT_TRUE(recording.parse(record(RHYTHM, 1, 60), error));
+  KnockVariant bad;
+  bad.hysteresis = 2;
+  TEST_ASSERT_FALSE(replayKnocks(recording, bad).valid);
+}
+
+void test_text_around_the_recording_is_skipped() {
+  const std::string capture = "> KNOCKREC\r\n*** Recording accelerometer, send any key to stop ***\r\n"
+                              "KNOCKREC BEGIN 5000\r\n" + frame(5000, 1, 2, 256) + frame(5000, -1, -2, 250) +
+                              "\r\nKNOCKREC END 2\r\n> STATUS\r\n";
+  KnockRecording recording;
+  std::string error;
+  TEST_ASSERT_TRUE_MESSAGE(recording.parse(capture, error), error.c_str());
+  TEST_ASSERT_EQUAL_UINT32(5000, recording.periodUs);
+  TEST_ASSERT_EQUAL(2, recording.frames.size());
+  TEST_ASSERT_EQUAL_UINT32(10000, recording.frames[1].us);
+  TEST_ASSERT_EQUAL_INT(-2, recording.frames[1].y);
+  TEST_ASSERT_EQUAL_INT(250, recording.frames[1].z);
+}
+
+void test_full_fifo_frame_counts_as_one_period() {
+  const std::string capture = "KNOCKREC BEGIN 10000\r\n" + frame(10000, 0, 0, 256) + frame(0xFFFF, 0, 0, 256) +
+                              frame(10000, 0, 0, 256) + "\r\nKNOCKREC END 3\r\n";
+  KnockRecording recording;
+  std::string error;
+  TEST_ASSERT_TRUE(recording.parse(capture, error));
+  TEST_ASSERT_EQUAL_UINT32(1, recording.overflows);
+  TEST_ASSERT_EQUAL_UINT32(30000, recording.durationUs());
+}
+
+void test_damaged_captures_are_rejected() {
+  KnockRecording recording;
+  std::string error;
+  TEST_ASSERT_FALSE(recording.parse("> STATUS\r\n", error));
+  TEST_ASSERT_EQUAL_STRING("no KNOCKREC BEGIN line", error.c_str());
+
+  const std::string head = "KNOCKREC BEGIN 10000\r\n" + frame(10000, 0, 0, 256);
+  TEST_ASSERT_FALSE(recording.parse(head + frame(10000, 0, 0, 256).substr(0, 5), error));
+  TEST_ASSERT_EQUAL_STRING("capture ends after 1 frames", error.c_str());
+
+  TEST_ASSERT_FALSE(recording.parse(head + "\x5A" + frame(10000, 0, 0, 256), error));
+  TEST_ASSERT_EQUAL_STRING("lost sync at byte 31 after 1 frames", error.c_str());
+
+  TEST_ASSERT_FALSE(recording.parse(head + "\r\nKNOCKREC END 2\r\n", error));
+  TEST_ASSERT_EQUAL_STRING("KNOCKREC END says 2 frames, found 1", error.c_str());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_recording_replays_to_the_same_knocks);
+  RUN_TEST(test_variants_change_the_outcome);
+  RUN_TEST(test_out_of_range_variant_is_refused);
+  RUN_TEST(test_text_around_the_recording_is_skipped);
+  RUN_TEST(test_full_fifo_frame_counts_as_one_period);
+  RUN_TEST(test_damaged_captures_are_rejected);
+  return UNITY_END();
+}
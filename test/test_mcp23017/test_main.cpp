@@ -0,0 +1,202 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "MCP23017Model.h"
+#include <Adafruit_MCP23X17.h>
+
+static MCP23017Model mcp(0x20);
+static Adafruit_MCP23X17 driver;
+
+static void writeRegs(uint8_t address, const uint8_t* data, uint8_t len) {
+  Wire.beginTransmission(0x20);
+  Wire.write(address);
+  Wire.write(data, len);
+  Wire.endTransmission();
+}
+
+static void readRegs(uint8_t address, uint8_t* data, uint8_t len) {
+  Wire.beginTransmission(0x20);
+  Wire.write(address);
+  Wire.endTransmission(false);
+  Wire.requestFrom(0x20, len);
+  for (uint8_t i = 0; i < len; i++) data[i] = (uint8_t)Wire.read();
+}
+
+static uint8_t readReg(uint8_t address) {
+  uint8_t v;
+  readRegs(address, &v, 1);
+  return v;
+}
+
+void setUp() {
+  shim::resetArduino();
+  Serial.reset();
+  Wire.detachAll();
+  mcp = MCP23017Model(0x20);
+  Wire.attach(&mcp);
+  driver.begin_I2C(0x20);
+}
+void tearDown() {}
+
+void test_power_on_state() {
+  TEST_ASSERT_EQUAL_HEX8(0xFF, readReg(0x00));
+  TEST_ASSERT_EQUAL_HEX8(0xFF, readReg(0x01));
+  for (uint8_t r = 0x02; r < 0x12; r++) TEST_ASSERT_EQUAL_HEX8(0, readReg(r));
+  TEST_ASSERT_EQUAL_HEX16(0xFFFF, driver.readGPIOAB());   // Floating inputs
+}
+
+void test_sequential_writes_and_reads_wrap() {
+  const uint8_t out[3] = {0x11, 0x22, 0x33};
+  writeRegs(0x14, out, 3);   // OLATA, OLATB, then wraps to IODIRA
+  TEST_ASSERT_EQUAL_HEX8(0x11, mcp.regs[MCP23017Model::OLAT]);
+  TEST_ASSERT_EQUAL_HEX8(0x22, mcp.regs[MCP23017Model::OLAT + 1]);
+  TEST_ASSERT_EQUAL_HEX8(0x33, mcp.regs[MCP23017Model::IODIR]);
+  uint8_t in[3];
+  readRegs(0x14, in, 3);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(out, in, 3);
+}
+
+void test_byte_mode_toggles_within_the_pair() {
+  const uint8_t seqop = MCP23017Model::SEQOP;
+  writeRegs(0x0A, &seqop, 1);
+  const uint8_t out[3] = {0x01, 0x02, 0x03};
+  writeRegs(0x0C, out, 3);   // GPPUA, GPPUB, GPPUA
+  TEST_ASSERT_EQUAL_HEX8(0x03, mcp.regs[MCP23017Model::GPPU]);
+  TEST_ASSERT_EQUAL_HEX8(0x02, mcp.regs[MCP23017Model::GPPU + 1]);
+  TEST_ASSERT_EQUAL_HEX8(0, mcp.regs[MCP23017Model::GPPU + 2]);
+}
+
+void test_iocon_is_one_register_at_both_addresses() {
+  const uint8_t mirror = MCP23017Model::MIRROR;
+  writeRegs(0x0B, &mirror, 1);
+  TEST_ASSERT_EQUAL_HEX8(mirror, readReg(0x0A));
+  TEST_ASSERT_EQUAL_HEX8(mirror, readReg(0x0B));
+}
+
+void test_bank_1_address_map() {
+  const uint8_t bank = MCP23017Model::BANK;
+  writeRegs(0x0A, &bank, 1);
+  const uint8_t dir = 0x0F;
+  writeRegs(0x10, &dir, 1);                        // IODIRB in BANK = 1
+  TEST_ASSERT_EQUAL_HEX8(0x0F, mcp.regs[MCP23017Model::IODIR + 1]);
+  TEST_ASSERT_EQUAL_HEX8(0xFF, mcp.regs[MCP23017Model::IODIR]);
+  TEST_ASSERT_EQUAL_HEX8(bank, readReg(0x05));     // IOCONA
+  TEST_ASSERT_EQUAL_HEX8(bank, readReg(0x15));     // IOCONB
+  TEST_ASSERT_EQUAL_HEX8(0, readReg(0x0C));        // Unimplemented
+  // Sequential: port A registers in order, then on past the gap
+  uint8_t in[2];
+  readRegs(0x00, in, 2);
+  TEST_ASSERT_EQUAL_HEX8(0xFF, in[0]);             // IODIRA
+  TEST_ASSERT_EQUAL_HEX8(0x00, in[1]);             // IPOLA
+  // Back to BANK = 0 through the BANK = 1 address of IOCON
+  const uint8_t zero = 0;
+  writeRegs(0x05, &zero, 1);
+  TEST_ASSERT_EQUAL_HEX8(0x0F, readReg(0x01));
+}
+
+void test_gpio_reads_pins_and_writes_olat() {
+  driver.pinMode(0, OUTPUT);
+  driver.pinMode(8, INPUT_PULLUP);
+  TEST_ASSERT_EQUAL_HEX8(0xFE, mcp.regs[MCP23017Model::IODIR]);
+  TEST_ASSERT_EQUAL_HEX8(0x01, mcp.regs[MCP23017Model::GPPU + 1]);
+  driver.digitalWrite(0, LOW);
+  TEST_ASSERT_FALSE(mcp.outputLevel(0));
+  TEST_ASSERT_EQUAL_HEX8(0xFE, mcp.regs[MCP23017Model::OLAT]);
+  mcp.setInput(8, false);
+  TEST_ASSERT_EQUAL(LOW, driver.digitalRead(8));
+  const uint8_t ipol = 0x01;
+  writeRegs(0x03, &ipol, 1);                       // IPOLB inverts B0
+  TEST_ASSERT_EQUAL(HIGH, driver.digitalRead(8));
+  TEST_ASSERT_EQUAL(LOW, driver.digitalRead(0));   // IPOL does not touch outputs
+}
+
+void test_interrupt_on_change_captures_and_clears() {
+  driver.pinMode(9, INPUT_PULLUP);
+  driver.setupInterruptPin(9, CHANGE);
+  TEST_ASSERT_EQUAL(MCP23XXX_INT_ERR, driver.getLastInterruptPin());
+  TEST_ASSERT_TRUE(mcp.intPin(1));                 // Push-pull, active low: idle high
+  mcp.setInput(9, false);
+  TEST_ASSERT_FALSE(mcp.intPin(1));
+  TEST_ASSERT_TRUE(mcp.intPin(0));                 // Not mirrored
+  mcp.setInput(9, true);                           // Second change while pending: not captured
+  TEST_ASSERT_EQUAL(9, driver.getLastInterruptPin());
+  TEST_ASSERT_EQUAL_HEX16(0xFD00, driver.getCapturedInterrupt());   // Port A never fired
+  TEST_ASSERT_TRUE(mcp.intPin(1));                 // INTCAP read cleared it
+  TEST_ASSERT_EQUAL_HEX8(0, mcp.regs[MCP23017Model::INTF + 1]);
+
+  driver.disableInterruptPin(9);
+  mcp.setInput(9, false);
+  TEST_ASSERT_FALSE(mcp.interruptPending(1));
+}
+
+void test_defval_compare_refires_until_released() {
+  driver.pinMode(2, INPUT_PULLUP);
+  driver.setupInterruptPin(2, LOW);                // Fires while the pin differs from DEFVAL = 1
+  TEST_ASSERT_EQUAL_HEX8(0x04, mcp.regs[MCP23017Model::INTCON]);
+  TEST_ASSERT_EQUAL_HEX8(0x04, mcp.regs[MCP23017Model::DEFVAL]);
+  mcp.setInput(2, false);
+  TEST_ASSERT_TRUE(mcp.interruptPending(0));
+  driver.readGPIOA();                              // Clears, but the pin is still low
+  TEST_ASSERT_TRUE(mcp.interruptPending(0));
+  mcp.setInput(2, true);
+  driver.readGPIOA();
+  TEST_ASSERT_FALSE(mcp.interruptPending(0));
+}
+
+void test_mirror_and_pin_polarity() {
+  driver.pinMode(3, INPUT_PULLUP);
+  driver.setupInterrupts(true, false, HIGH);
+  driver.setupInterruptPin(3, CHANGE);
+  TEST_ASSERT_FALSE(mcp.intPin(0));                // Active high: idle low
+  mcp.setInput(3, false);
+  TEST_ASSERT_TRUE(mcp.intPin(0));
+  TEST_ASSERT_TRUE(mcp.intPin(1));                 // Mirrored onto INTB
+  driver.clearInterrupts();
+  driver.setupInterrupts(false, true, LOW);        // Open drain
+  TEST_ASSERT_TRUE(mcp.intPin(0));
+  mcp.setInput(3, true);
+  TEST_ASSERT_FALSE(mcp.intPin(0));
+  TEST_ASSERT_TRUE(mcp.intPin(1));
+}
+
+void test_driver_transaction_counts() {
+  uint32_t before = mcp.transactions;
+  driver.readGPIOB();
+  TEST_ASSERT_EQUAL_UINT32(before + 2, mcp.transactions);
+  before = mcp.transactions;
+  driver.writeGPIOA(0x55);
+  TEST_ASSERT_EQUAL_UINT32(before + 1, mcp.transactions);
+  before = mcp.transactions;
+  driver.digitalWrite(4, HIGH);
+  TEST_ASSERT_EQUAL_UINT32(before + 3, mcp.transactions);
+  before = mcp.transactions;
+  driver.pinMode(4, OUTPUT);
+  TEST_ASSERT_EQUAL_UINT32(before + 6, mcp.transactions);
+  before = mcp.transactions;
+  driver.readGPIOAB();
+  TEST_ASSERT_EQUAL_UINT32(before + 2, mcp.transactions);
+}
+
+void test_reset_restores_power_on_state() {
+  driver.pinMode(5, OUTPUT);
+  driver.writeGPIOA(0x00);
+  mcp.reset();
+  TEST_ASSERT_EQUAL_HEX8(0xFF, readReg(0x00));
+  TEST_ASSERT_EQUAL_HEX8(0x00, readReg(0x14));
+  TEST_ASSERT_TRUE(mcp.outputLevel(5));            // Input again
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_power_on_state);
+  RUN_TEST(test_sequential_writes_and_reads_wrap);
+  RUN_TEST(test_byte_mode_toggles_within_the_pair);
+  RUN_TEST(test_iocon_is_one_register_at_both_addresses);
+  RUN_TEST(test_bank_1_address_map);
+  RUN_TEST(test_gpio_reads_pins_and_writes_olat);
+  RUN_TEST(test_interrupt_on_change_captures_and_clears);
+  RUN_TEST(test_defval_compare_refires_until_released);
+  RUN_TEST(test_mirror_and_pin_polarity);
+  RUN_TEST(test_driver_transaction_counts);
+  RUN_TEST(test_reset_restores_power_on_state);
+  return UNITY_END();
+}
@@ -0,0 +1,421 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "NFCAmiiboPuzzle.h"
+
+static const uint8_t GOOMBA_UID[7] = {0x04, 0xA6, 0x89, 0x72, 0x3C, 0x4D, 0x80};
+static const uint8_t OTHER_UID[7] = {0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+static const uint8_t THIRD_UID[7] = {0x04, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC};
+static const uint16_t GOOMBA = 0x1914;
+static const uint16_t MARIO = 0x0000;
+
+static shim::PN532Model& reader = shim::pn532();
+
+static void run(NFCAmiiboPuzzle& p, uint32_t ms) {
+  const uint32_t end = millis() + ms;
+  while ((int32_t)(millis() - end) < 0) {
+    shim::advanceMs(10);
+    p.update(millis());
+  }
+}
+
+void setUp() {
+  shim::resetArduino();
+  Serial.reset();
+  Wire.detachAll();
+  EEPROM.erase();
+  reader.reset();
+  Wire.attach(&reader);
+}
+void tearDown() {}
+
+void test_blank_eeprom_seeds_the_goomba() {
+  NFCAmiiboPuzzle p;
+  p.begin();
+  TEST_ASSERT_TRUE(Serial.printed("Ready! 1 tag(s) on the allowlist"));
+  TEST_ASSERT_EQUAL((int)NfcRole::SOLVE, (int)p.allowlist().lookup(GOOMBA_UID, 7));
+}
+
+void test_missing_reader_stays_idle() {
+  reader.present = false;
+  NFCAmiiboPuzzle p;
+  p.begin();
+  TEST_ASSERT_TRUE(Serial.printed("PN532 not found"));
+  run(p, 1000);
+  TEST_ASSERT_EQUAL_UINT32(0, reader.polls);
+  TEST_ASSERT_EQUAL_INT(0, p.ledBrightness());
+}
+
+void test_allowlisted_tag_solves_and_teaches_the_character() {
+  const shim::NfcTag goomba = shim::amiiboTag(GOOMBA_UID, GOOMBA);
+  NFCAmiiboPuzzle p;
+  p.begin();
+  run(p, 200);
+  TEST_ASSERT_FALSE(p.isSolved());
+  reader.tag = &goomba;
+  run(p, 200);
+  TEST_ASSERT_TRUE(p.isSolved());
+  TEST_ASSERT_TRUE(Serial.printed("Required character 1914"));
+
+  // Another figure of the same character now solves as well; a different one does not
+  const shim::NfcTag secondGoomba = shim::amiiboTag(OTHER_UID, GOOMBA);
+  const shim::NfcTag mario = shim::amiiboTag(THIRD_UID, MARIO);
+  p.reset();
+  reader.tag = &mario;
+  run(p, 300);
+  TEST_ASSERT_FALSE(p.isSolved());
+  TEST_ASSERT_TRUE(Serial.printed("Wrong amiibo!"));
+  reader.tag = &secondGoomba;
+  run(p, 300);
+  TEST_ASSERT_TRUE(p.isSolved());
+  TEST_ASSERT_TRUE(Serial.printed("CHARACTER MATCHED!"));
+}
+
+void test_character_survives_a_restart() {
+  const shim::NfcTag goomba = shim::amiiboTag(GOOMBA_UID, GOOMBA);
+  {
+    NFCAmiiboPuzzle p;
+    p.begin();
+    reader.tag = &goomba;
+    run(p, 200);
+  }
+  const shim::NfcTag secondGoomba = shim::amiiboTag(OTHER_UID, GOOMBA);
+  reader.tag = &secondGoomba;
+  NFCAmiiboPuzzle p;
+  p.begin();
+  run(p, 200);
+  TEST_ASSERT_TRUE(p.isSolved());
+}
+
+void test_tag_that_is_no_amiibo_is_rejected() {
+  NFCAmiiboPuzzle p;
+  p.begin();
+  p.setRequiredCharacter(GOOMBA);
+  shim::NfcTag plain = shim::amiiboTag(OTHER_UID, GOOMBA);
+  plain.pages[22][3] = 0x00;   // ID does not end in 0x02
+  reader.tag = &plain;
+  run(p, 300);
+  TEST_ASSERT_FALSE(p.isSolved());
+}
+
+void test_hovering_tag_is_reported_once() {
+  const shim::NfcTag mario = shim::amiiboTag(THIRD_UID, MARIO);
+  NFCAmiiboPuzzle p;
+  p.begin();
+  reader.tag = &mario;
+  run(p, 700);
+  const std::string& out = Serial.output();
+  const size_t first = out.find("Detected UID");
+  TEST_ASSERT_TRUE(first != std::string::npos);
+  TEST_ASSERT_TRUE(out.find("Detected UID", first + 1) == std::string::npos);
+}
+
+void test_polling_backs_off_when_nothing_is_near() {
+  NFCAmiiboPuzzle p;
+  p.begin();
+  const uint16_t configured = reader.commands[PN532_COMMAND_RFCONFIGURATION];   // Retry limit
+  TEST_ASSERT_EQUAL_UINT8(0x10, reader.retries);
+  run(p, 3000);
+  const uint32_t hoverPolls = reader.polls;
+  TEST_ASSERT_UINT32_WITHIN(2, 30, hoverPolls);        // 100 ms during the hover window
+  TEST_ASSERT_EQUAL_UINT16(configured, reader.commands[PN532_COMMAND_RFCONFIGURATION]);
+  TEST_ASSERT_TRUE(reader.fieldOn);
+
+  // Past the hover window the field is switched off after every poll
+  run(p, 5000);
+  const uint16_t rfOffs = reader.commands[PN532_COMMAND_RFCONFIGURATION] - configured;
+  TEST_ASSERT_UINT32_WITHIN(1, reader.polls - hoverPolls, rfOffs);
+  TEST_ASSERT_FALSE(reader.fieldOn);
+  const uint32_t before = reader.polls;
+  run(p, 4000);
+  TEST_ASSERT_UINT32_WITHIN(1, 5, reader.polls - before);   // Capped at 800 ms
+
+  // Activity brings the fast rate straight back
+  p.pollBurst(millis());
+  const uint32_t burst = reader.polls;
+  run(p, 1000);
+  TEST_ASSERT_UINT32_WITHIN(1, 10, reader.polls - burst);
+}
+
+void test_solved_reader_is_powered_down_once() {
+  const shim::NfcTag goomba = shim::amiiboTag(GOOMBA_UID, GOOMBA);
+  NFCAmiiboPuzzle p;
+  p.begin();
+  reader.tag = &goomba;
+  run(p, 200);
+  reader.tag = nullptr;
+  run(p, 3000);   // 2 s success feedback, then solved
+  TEST_ASSERT_EQUAL_UINT16(1, reader.commands[PN532_COMMAND_POWERDOWN]);
+  const uint32_t polls = reader.polls;
+  run(p, 5000);
+  TEST_ASSERT_EQUAL_UINT16(1, reader.commands[PN532_COMMAND_POWERDOWN]);
+  TEST_ASSERT_EQUAL_UINT32(polls, reader.polls);
+
+  // Reset wakes and re-initialises the chip
+  const uint32_t queries = reader.firmwareQueries;
+  p.reset();
+  TEST_ASSERT_GREATER_THAN(queries, reader.firmwareQueries);
+  run(p, 500);
+  TEST_ASSERT_GREATER_THAN(polls, reader.polls);
+}
+
+void test_failed_power_down_backs_off_and_recovers() {
+  const shim::NfcTag goomba = shim::amiiboTag(GOOMBA_UID, GOOMBA);
+  NFCAmiiboPuzzle p;
+  p.begin();
+  reader.tag = &goomba;
+  run(p, 200);
+  reader.tag = nullptr;
+  reader.ignoreCommand = PN532_COMMAND_POWERDOWN;
+  run(p, 12000);
+  // Each attempt blocks for the ACK timeout; retries come after 1, 2, 4, 8 s
+  TEST_ASSERT_LESS_OR_EQUAL(5, reader.commands[PN532_COMMAND_POWERDOWN]);
+  TEST_ASSERT_GREATER_OR_EQUAL(3, reader.commands[PN532_COMMAND_POWERDOWN]);
+  TEST_ASSERT_TRUE(Serial.printed("Re-initialising PN532"));
+
+  reader.ignoreCommand = -1;
+  run(p, 20000);
+  TEST_ASSERT_TRUE(Serial.printed("PN532 powered down"));
+}
+
+void test_bench_poll_wakes_a_powered_down_reader() {
+  const shim::NfcTag goomba = shim::amiiboTag(GOOMBA_UID, GOOMBA);
+  NFCAmiiboPuzzle p;
+  p.begin();
+  reader.tag = &goomba;
+  run(p, 3000);
+  reader.tag = nullptr;
+  TEST_ASSERT_EQUAL_UINT16(1, reader.commands[PN532_COMMAND_POWERDOWN]);
+  const uint32_t polls = reader.polls, queries = reader.firmwareQueries;
+  TEST_ASSERT_TRUE(p.benchPoll());
+  TEST_ASSERT_EQUAL_UINT32(polls + 1, reader.polls);
+  TEST_ASSERT_GREATER_THAN(queries, reader.firmwareQueries);
+  // Still solved: the next tick powers it down again
+  run(p, 20);
+  TEST_ASSERT_EQUAL_UINT16(2, reader.commands[PN532_COMMAND_POWERDOWN]);
+}
+
+void test_irq_mode_detects_split_phase() {
+  const shim::NfcTag goomba = shim::amiiboTag(GOOMBA_UID, GOOMBA);
+  NFCAmiiboPuzzle p(0, 6);
+  p.begin();
+  reader.tag = &goomba;
+  shim::advanceMs(10);
+  p.update(millis());        // Starts the detection
+  TEST_ASSERT_FALSE(p.isSolved());
+  TEST_ASSERT_EQUAL(LOW, digitalRead(6));
+  shim::advanceMs(10);
+  p.update(millis());        // IRQ asserted: collect the result
+  TEST_ASSERT_TRUE(p.isSolved());
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(6));
+}
+
+void test_split_phase_poll_never_waits_for_the_card() {
+  const shim::NfcTag goomba = shim::amiiboTag(GOOMBA_UID, GOOMBA);
+  NFCAmiiboPuzzle p(0, 6);
+  p.begin();
+  reader.detectUs = 40000;   // Slow target selection
+  reader.tag = &goomba;
+  uint32_t worstUs = 0, ticks = 0;
+  while (!p.isSolved() && ticks < 100) {
+    shim::advanceMs(10);
+    const uint32_t t0 = micros();
+    p.update(millis());
+    worstUs = max(worstUs, (uint32_t)(micros() - t0));
+    ticks++;
+    if (ticks == 1) TEST_ASSERT_EQUAL(HIGH, digitalRead(6));   // ACKed, target not listed yet
+  }
+  TEST_ASSERT_TRUE(p.isSolved());
+  TEST_ASSERT_EQUAL_UINT32(1, reader.polls);
+  // Start and collection each cost a frame or two and at most one 10 ms wait for the ACK;
+  // the 40 ms selection itself is never waited on
+  TEST_ASSERT_LESS_THAN(40000, worstUs);
+}
+
+void test_card_arrival_to_solved_latency() {
+  const shim::NfcTag goomba = shim::amiiboTag(GOOMBA_UID, GOOMBA);
+  NFCAmiiboPuzzle p;
+  p.begin();
+  run(p, 500);
+  const uint32_t arrival = millis() + 37;   // Between two polls
+  reader.at(arrival, &goomba);
+  while (!p.isSolved() && (int32_t)(millis() - arrival) < 1000) {
+    shim::advanceMs(10);
+    p.update(millis());
+  }
+  TEST_ASSERT_TRUE(p.isSolved());
+  // One 100 ms poll interval plus the poll itself and the two amiibo ID page reads
+  TEST_ASSERT_LESS_OR_EQUAL(100 + 60, millis() - arrival);
+}
+
+void test_card_tapped_repeatedly_counts_once_until_it_stays_away() {
+  const shim::NfcTag mario = shim::amiiboTag(THIRD_UID, MARIO);
+  NFCAmiiboPuzzle p;
+  p.begin();
+  const uint32_t t = millis();
+  reader.at(t + 100, &mario);    // Wobbling on the edge of the field: gaps shorter than 800 ms
+  reader.at(t + 400, nullptr);
+  reader.at(t + 900, &mario);
+  reader.at(t + 1200, nullptr);
+  reader.at(t + 1700, &mario);
+  reader.at(t + 2000, nullptr);
+  run(p, 2500);
+  TEST_ASSERT_EQUAL_UINT32(1, Serial.count("Detected UID"));
+  reader.at(t + 3000, &mario);   // Back after more than 800 ms away
+  run(p, 1000);
+  TEST_ASSERT_EQUAL_UINT32(2, Serial.count("Detected UID"));
+}
+
+void test_uid_must_match_in_full() {
+  shim::NfcTag prefix = shim::amiiboTag(GOOMBA_UID, GOOMBA);   // 4-byte UID: the Goomba's first bytes
+  prefix.uidLen = 4;
+  shim::NfcTag lastByte = shim::amiiboTag(GOOMBA_UID, GOOMBA);
+  lastByte.uid[6] ^= 0x01;
+  NFCAmiiboPuzzle p;
+  p.begin();
+  reader.tag = &prefix;
+  run(p, 300);
+  TEST_ASSERT_TRUE(Serial.printed("Detected UID[4]: 04:A6:89:72"));
+  reader.tag = nullptr;
+  run(p, 1000);
+  reader.tag = &lastByte;
+  run(p, 300);
+  TEST_ASSERT_FALSE(p.isSolved());
+  TEST_ASSERT_EQUAL_UINT32(2, Serial.count("Wrong amiibo!"));
+}
+
+void test_learn_mode_enrolls_the_next_tag() {
+  const shim::NfcTag hint = shim::amiiboTag(OTHER_UID, MARIO);
+  NFCAmiiboPuzzle p;
+  p.begin();
+  p.startLearning(NfcRole::HINT, millis());
+  reader.tag = &hint;
+  run(p, 200);
+  TEST_ASSERT_TRUE(Serial.printed("Enrolled as HINT"));
+  TEST_ASSERT_EQUAL((int)NfcRole::HINT, (int)p.allowlist().lookup(OTHER_UID, 7));
+
+  // Presented again after the hover cooldown it raises a hint action instead of solving
+  reader.tag = nullptr;
+  run(p, 1000);
+  reader.tag = &hint;
+  run(p, 200);
+  TEST_ASSERT_EQUAL((int)NfcRole::HINT, (int)p.takeAction());
+  TEST_ASSERT_EQUAL((int)NfcRole::NONE, (int)p.takeAction());
+  TEST_ASSERT_FALSE(p.isSolved());
+}
+
+// Loop like the sketch: an admin tag resets the puzzle; returns the number of resets
+static uint16_t runWithAdmin(NFCAmiiboPuzzle& p, uint32_t ms) {
+  uint16_t resets = 0;
+  const uint32_t end = millis() + ms;
+  while ((int32_t)(millis() - end) < 0) {
+    shim::advanceMs(10);
+    p.update(millis());
+    if (p.takeAction() == NfcRole::ADMIN_RESET) {
+      p.reset();
+      resets++;
+    }
+  }
+  return resets;
+}
+
+void test_hovering_tag_is_reported_once_while_it_stays() {
+  const shim::NfcTag mario = shim::amiiboTag(THIRD_UID, MARIO);
+  NFCAmiiboPuzzle p;
+  p.begin();
+  reader.tag = &mario;
+  run(p, 5000);
+  TEST_ASSERT_EQUAL_UINT32(1, Serial.count("Wrong amiibo!"));
+  reader.tag = nullptr;
+  run(p, 1000);
+  reader.tag = &mario;
+  run(p, 300);
+  TEST_ASSERT_EQUAL_UINT32(2, Serial.count("Wrong amiibo!"));
+}
+
+void test_admin_tag_left_on_the_reader_resets_once() {
+  const shim::NfcTag admin = shim::amiiboTag(OTHER_UID, MARIO);
+  NFCAmiiboPuzzle p;
+  p.begin();
+  p.allowlist().add(OTHER_UID, 7, NfcRole::ADMIN_RESET);
+  reader.tag = &admin;
+  TEST_ASSERT_EQUAL_UINT16(1, runWithAdmin(p, 5000));
+  // Taken away and presented again, it acts again
+  reader.tag = nullptr;
+  runWithAdmin(p, 1000);
+  reader.tag = &admin;
+  TEST_ASSERT_EQUAL_UINT16(1, runWithAdmin(p, 1000));
+}
+
+void test_admin_tag_acts_after_solve() {
+  const shim::NfcTag goomba = shim::amiiboTag(GOOMBA_UID, GOOMBA);
+  const shim::NfcTag admin = shim::amiiboTag(OTHER_UID, MARIO);
+  NFCAmiiboPuzzle p;
+  p.begin();
+  p.allowlist().add(OTHER_UID, 7, NfcRole::ADMIN_RESET);
+  reader.tag = &goomba;
+  run(p, 200);
+  reader.tag = nullptr;
+  run(p, 3000);
+  TEST_ASSERT_TRUE(p.isSolved());
+  TEST_ASSERT_EQUAL_UINT16(0, reader.commands[PN532_COMMAND_POWERDOWN]);
+
+  // Slow role poll while solved
+  const uint32_t polls = reader.polls;
+  run(p, 8000);
+  TEST_ASSERT_UINT32_WITHIN(1, 10, reader.polls - polls);
+
+  // The solving figure does nothing more; the admin tag still resets
+  reader.tag = &goomba;
+  run(p, 1000);
+  TEST_ASSERT_EQUAL_UINT32(1, Serial.count("AMIIBO ACCEPTED"));
+  reader.tag = nullptr;
+  run(p, 1000);
+  reader.tag = &admin;
+  TEST_ASSERT_EQUAL_UINT16(1, runWithAdmin(p, 1000));
+  TEST_ASSERT_FALSE(p.isSolved());
+}
+
+void test_hint_tag_added_after_power_down_wakes_the_reader() {
+  const shim::NfcTag goomba = shim::amiiboTag(GOOMBA_UID, GOOMBA);
+  const shim::NfcTag hint = shim::amiiboTag(OTHER_UID, MARIO);
+  NFCAmiiboPuzzle p;
+  p.begin();
+  reader.tag = &goomba;
+  run(p, 200);
+  reader.tag = nullptr;
+  run(p, 3000);
+  TEST_ASSERT_EQUAL_UINT16(1, reader.commands[PN532_COMMAND_POWERDOWN]);
+
+  p.allowlist().add(OTHER_UID, 7, NfcRole::HINT);
+  p.allowlistChanged(millis());
+  reader.tag = &hint;
+  run(p, 1000);
+  TEST_ASSERT_EQUAL((int)NfcRole::HINT, (int)p.takeAction());
+  TEST_ASSERT_TRUE(p.isSolved());
+  TEST_ASSERT_EQUAL_UINT16(1, reader.commands[PN532_COMMAND_POWERDOWN]);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_blank_eeprom_seeds_the_goomba);
+  RUN_TEST(test_missing_reader_stays_idle);
+  RUN_TEST(test_allowlisted_tag_solves_and_teaches_the_character);
+  RUN_TEST(test_character_survives_a_restart);
+  RUN_TEST(test_tag_that_is_no_amiibo_is_rejected);
+  RUN_TEST(test_hovering_tag_is_reported_once);
+  RUN_TEST(test_polling_backs_off_when_nothing_is_near);
+  RUN_TEST(test_solved_reader_is_powered_down_once);
+  RUN_TEST(test_failed_power_down_backs_off_and_recovers);
+  RUN_TEST(test_bench_poll_wakes_a_powered_down_reader);
+  RUN_TEST(test_irq_mode_detects_split_phase);
+  RUN_TEST(test_split_phase_poll_never_waits_for_the_card);
+  RUN_TEST(test_card_arrival_to_solved_latency);
+  RUN_TEST(test_card_tapped_repeatedly_counts_once_until_it_stays_away);
+  RUN_TEST(test_uid_must_match_in_full);
+  RUN_TEST(test_learn_mode_enrolls_the_next_tag);
+  RUN_TEST(test_hovering_tag_is_reported_once_while_it_stays);
+  RUN_TEST(test_admin_tag_left_on_the_reader_resets_once);
+  RUN_TEST(test_admin_tag_acts_after_solve);
+  RUN_TEST(test_hint_tag_added_after_power_down_wakes_the_reader);
+  return UNITY_END();
+}
@@ -0,0 +1,255 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <Adafruit_PN532.h>
+
+static const uint8_t UID[7] = {0x04, 0xA6, 0x89, 0x72, 0x3C, 0x4D, 0x80};
+
+static shim::PN532Model& chip = shim::pn532();
+
+// Normal information frame for a host command
+static uint8_t buildFrame(const uint8_t* cmd, uint8_t len, uint8_t* frame) {
+  const uint8_t n = len + 1;
+  uint8_t sum = PN532_HOSTTOPN532;
+  frame[0] = 0x00;
+  frame[1] = 0x00;
+  frame[2] = 0xFF;
+  frame[3] = n;
+  frame[4] = (uint8_t)(~n + 1);
+  frame[5] = PN532_HOSTTOPN532;
+  for (uint8_t i = 0; i < len; i++) {
+    frame[6 + i] = cmd[i];
+    sum += cmd[i];
+  }
+  frame[6 + len] = (uint8_t)(~sum + 1);
+  frame[7 + len] = 0x00;
+  return len + 8;
+}
+
+static void writeRaw(const uint8_t* data, uint8_t len) {
+  Wire.beginTransmission(PN532_I2C_ADDRESS);
+  Wire.write(data, len);
+  Wire.endTransmission();
+}
+
+static void sendFrame(const uint8_t* cmd, uint8_t len) {
+  uint8_t frame[32];
+  writeRaw(frame, buildFrame(cmd, len, frame));
+}
+
+static uint8_t status() {
+  Wire.requestFrom(PN532_I2C_ADDRESS, 1);
+  return (uint8_t)Wire.read();
+}
+
+// Status byte plus n frame bytes
+static void readRaw(uint8_t* data, uint8_t n) {
+  Wire.requestFrom(PN532_I2C_ADDRESS, n + 1);
+  for (uint8_t i = 0; i <= n; i++) data[i] = (uint8_t)Wire.read();
+}
+
+static void expectAck() {
+  uint8_t in[7];
+  readRaw(in, 6);
+  TEST_ASSERT_EQUAL_HEX8(0x01, in[0]);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(shim::PN532Model::ACK, in + 1, 6);
+}
+
+// Length and data checksums of a response frame (after the status byte) add up
+static void expectValidResponse(const uint8_t* f, uint8_t cmd) {
+  TEST_ASSERT_EQUAL_HEX8(0x00, f[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x00, f[1]);
+  TEST_ASSERT_EQUAL_HEX8(0xFF, f[2]);
+  TEST_ASSERT_EQUAL_HEX8(0, (uint8_t)(f[3] + f[4]));
+  TEST_ASSERT_EQUAL_HEX8(PN532_PN532TOHOST, f[5]);
+  TEST_ASSERT_EQUAL_HEX8(cmd + 1, f[6]);
+  uint8_t sum = 0;
+  for (uint8_t i = 0; i <= f[3]; i++) sum += f[5 + i];
+  TEST_ASSERT_EQUAL_HEX8(0, sum);
+  TEST_ASSERT_EQUAL_HEX8(0x00, f[6 + f[3]]);
+}
+
+void setUp() {
+  shim::resetArduino();
+  Serial.reset();
+  Wire.detachAll();
+  chip.reset();
+  Wire.attach(&chip);
+}
+void tearDown() {}
+
+void test_status_byte_then_ack_then_response() {
+  chip.ackUs = 2000;                                // Well above the cost of a status read
+  chip.responseUs = 5000;
+  const uint8_t cmd[] = {PN532_COMMAND_GETFIRMWAREVERSION};
+  sendFrame(cmd, sizeof(cmd));
+  TEST_ASSERT_EQUAL_HEX8(0x00, status());           // Busy
+  shim::advanceUs(chip.ackUs);
+  TEST_ASSERT_EQUAL_HEX8(0x01, status());           // A status poll consumes nothing
+  expectAck();
+  TEST_ASSERT_EQUAL_HEX8(0x00, status());
+  shim::advanceUs(chip.responseUs);
+  uint8_t in[14];
+  readRaw(in, 13);
+  TEST_ASSERT_EQUAL_HEX8(0x01, in[0]);
+  expectValidResponse(in + 1, PN532_COMMAND_GETFIRMWAREVERSION);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(shim::PN532Model::FIRMWARE, in + 8, 4);
+  TEST_ASSERT_EQUAL_HEX8(0x00, status());           // Nothing left
+  TEST_ASSERT_EQUAL_UINT32(1, chip.firmwareQueries);
+}
+
+void test_bad_checksums_are_dropped_unacknowledged() {
+  const uint8_t cmd[] = {PN532_COMMAND_GETFIRMWAREVERSION};
+  uint8_t frame[16];
+  const uint8_t len = buildFrame(cmd, sizeof(cmd), frame);
+  frame[4] ^= 0x01;                                 // Length checksum
+  writeRaw(frame, len);
+  buildFrame(cmd, sizeof(cmd), frame);
+  frame[7] ^= 0x01;                                 // Data checksum
+  writeRaw(frame, len);
+  shim::advanceMs(10);
+  TEST_ASSERT_EQUAL_HEX8(0x00, status());
+  TEST_ASSERT_EQUAL_UINT32(2, chip.badFrames);
+  TEST_ASSERT_EQUAL_UINT16(0, chip.commands[PN532_COMMAND_GETFIRMWAREVERSION]);
+}
+
+void test_host_nack_repeats_and_ack_aborts() {
+  const uint8_t cmd[] = {PN532_COMMAND_GETFIRMWAREVERSION};
+  sendFrame(cmd, sizeof(cmd));
+  shim::advanceMs(5);
+  expectAck();
+  uint8_t first[14], again[14];
+  readRaw(first, 13);
+  writeRaw(shim::PN532Model::NACK, 6);
+  shim::advanceMs(1);
+  readRaw(again, 13);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(first, again, 14);
+  TEST_ASSERT_EQUAL_UINT32(1, chip.hostNacks);
+
+  sendFrame(cmd, sizeof(cmd));
+  writeRaw(shim::PN532Model::ACK, 6);
+  shim::advanceMs(5);
+  TEST_ASSERT_EQUAL_HEX8(0x00, status());
+  TEST_ASSERT_EQUAL_UINT32(1, chip.hostAcks);
+}
+
+void test_passive_target_follows_the_timeline() {
+  const shim::NfcTag tag = shim::amiiboTag(UID, 0x1914);
+  const uint8_t cmd[] = {PN532_COMMAND_INLISTPASSIVETARGET, 1, PN532_MIFARE_ISO14443A};
+  uint8_t in[23];
+
+  // No card within the retry window: zero targets after missUs
+  sendFrame(cmd, sizeof(cmd));
+  const uint32_t start = micros();
+  shim::advanceUs(chip.ackUs);
+  expectAck();
+  shim::clockUs() = start + chip.ackUs + chip.missUs - 500;
+  TEST_ASSERT_EQUAL_HEX8(0x00, status());
+  shim::advanceUs(500);
+  readRaw(in, 10);
+  expectValidResponse(in + 1, PN532_COMMAND_INLISTPASSIVETARGET);
+  TEST_ASSERT_EQUAL_HEX8(0, in[8]);                 // NbTg
+  TEST_ASSERT_TRUE(chip.fieldOn);
+
+  // The card arrives mid-command: listed detectUs after it entered the field
+  const uint32_t arrival = millis() + 2;
+  chip.at(arrival, &tag);
+  sendFrame(cmd, sizeof(cmd));
+  shim::advanceUs(chip.ackUs);
+  expectAck();
+  shim::clockUs() = arrival * 1000 + chip.detectUs - 500;
+  TEST_ASSERT_EQUAL_HEX8(0x00, status());
+  shim::advanceUs(500);
+  readRaw(in, 22);
+  expectValidResponse(in + 1, PN532_COMMAND_INLISTPASSIVETARGET);
+  TEST_ASSERT_EQUAL_HEX8(1, in[8]);
+  TEST_ASSERT_EQUAL_HEX8(7, in[13]);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(UID, in + 14, 7);
+  TEST_ASSERT_EQUAL_UINT32(2, chip.polls);
+}
+
+void test_page_read_needs_the_listed_card() {
+  const shim::NfcTag tag = shim::amiiboTag(UID, 0x1914);
+  Adafruit_PN532 nfc(0xFF, 0xFF);
+  nfc.begin();
+  chip.tag = &tag;
+  uint8_t uid[10], uidLen = 0, page[4];
+  TEST_ASSERT_TRUE(nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLen, 50));
+  TEST_ASSERT_EQUAL_UINT8(7, uidLen);
+  TEST_ASSERT_EQUAL_UINT8(1, nfc.ntag2xx_ReadPage(21, page));
+  TEST_ASSERT_EQUAL_HEX8(0x19, page[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x14, page[1]);
+  chip.at(millis() + 1, nullptr);                   // Taken away
+  shim::advanceMs(1);
+  TEST_ASSERT_EQUAL_UINT8(0, nfc.ntag2xx_ReadPage(22, page));
+  TEST_ASSERT_FALSE(nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLen, 50));
+}
+
+void test_irq_line_is_low_while_a_frame_is_ready() {
+  chip.missUs = 30000;                              // Longer than the library's 10 ms ACK wait
+  Adafruit_PN532 nfc(6, 0xFF);
+  nfc.begin();
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(6));
+  TEST_ASSERT_TRUE(nfc.startPassiveTargetIDDetection(PN532_MIFARE_ISO14443A));   // ACK read
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(6));
+  shim::advanceUs(chip.missUs);
+  TEST_ASSERT_EQUAL(LOW, digitalRead(6));
+  uint8_t uid[10], uidLen = 0;
+  TEST_ASSERT_FALSE(nfc.readDetectedPassiveTargetID(uid, &uidLen));              // No target
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(6));
+}
+
+void test_power_down_and_wake() {
+  Adafruit_PN532 nfc(0xFF, 0xFF);
+  nfc.begin();
+  uint8_t cmd[] = {PN532_COMMAND_POWERDOWN, 0x80};
+  TEST_ASSERT_TRUE(nfc.sendCommandCheckAck(cmd, sizeof(cmd)));
+  TEST_ASSERT_FALSE(chip.poweredDown);              // Not before its response is read
+  shim::advanceMs(5);
+  uint8_t in[11];
+  readRaw(in, 10);
+  TEST_ASSERT_TRUE(chip.poweredDown);
+
+  // The next frame wakes it; the answer comes wakeUs later
+  const uint8_t fw[] = {PN532_COMMAND_GETFIRMWAREVERSION};
+  sendFrame(fw, sizeof(fw));
+  TEST_ASSERT_FALSE(chip.poweredDown);
+  TEST_ASSERT_EQUAL_UINT32(1, chip.wakeups);
+  shim::advanceUs(chip.ackUs);
+  TEST_ASSERT_EQUAL_HEX8(0x00, status());
+  shim::advanceUs(chip.wakeUs);
+  expectAck();
+}
+
+void test_driver_handshake_and_bus_cost() {
+  Adafruit_PN532 nfc(0xFF, 0xFF);
+  nfc.begin();
+  TEST_ASSERT_EQUAL_HEX32(0x32010607, nfc.getFirmwareVersion());
+  TEST_ASSERT_TRUE(nfc.SAMConfig());
+  TEST_ASSERT_TRUE(nfc.setPassiveActivationRetries(0x10));
+  TEST_ASSERT_EQUAL_UINT8(0x10, chip.retries);
+
+  // A blocking no-card poll: the library waits for the ACK and the answer in 10 ms steps
+  uint8_t uid[10], uidLen = 0;
+  const uint32_t t0 = micros();
+  TEST_ASSERT_FALSE(nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLen, 50));
+  const uint32_t cost = micros() - t0;
+  TEST_ASSERT_GREATER_OR_EQUAL(chip.ackUs + chip.missUs, cost);
+  TEST_ASSERT_LESS_OR_EQUAL(25000, cost);
+
+  // Missing module: the handshake times out
+  chip.present = false;
+  TEST_ASSERT_EQUAL_HEX32(0, nfc.getFirmwareVersion());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_status_byte_then_ack_then_response);
+  RUN_TEST(test_bad_checksums_are_dropped_unacknowledged);
+  RUN_TEST(test_host_nack_repeats_and_ack_aborts);
+  RUN_TEST(test_passive_target_follows_the_timeline);
+  RUN_TEST(test_page_read_needs_the_listed_card);
+  RUN_TEST(test_irq_line_is_low_while_a_frame_is_ready);
+  RUN_TEST(test_power_down_and_wake);
+  RUN_TEST(test_driver_handshake_and_bus_cost);
+  return UNITY_END();
+}
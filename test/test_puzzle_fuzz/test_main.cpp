@@ -0,0 +1,79 @@
+// The fuzzers of test/fuzz/ on fixed pseudo-random inputs, so every run checks the same cases
+// without libFuzzer. A failure names the input; regenerate it with input(seed) to debug.
+#include <Arduino.h>
+#include <unity.h>
+#include <vector>
+#include "PuzzleFuzz.h"
+
+static const uint32_t INPUTS = 1000;
+
+// Up to 1 + 2 * MAX_STEPS bytes from a 32-bit LCG
+static std::vector<uint8_t> input(uint32_t seed) {
+  uint32_t x = seed * 2654435761UL + 1;
+  auto next = [&]() {
+    x = x * 1664525UL + 1013904223UL;
+    return (uint8_t)(x >> 24);
+  };
+  std::vector<uint8_t> data(1 + (next() | next() << 8) % (2 * PuzzleFuzz::MAX_STEPS + 1));
+  for (uint8_t& b : data) b = next();
+  return data;
+}
+
+// Run the inputs of seeds [1, INPUTS] and print how many got solved and the slowest update()
+static void fuzz(const char* name, const char* (*fuzzer)(const uint8_t*, size_t, PuzzleFuzz::Stats*)) {
+  uint32_t solved = 0, maxUs = 0;
+  for (uint32_t seed = 1; seed <= INPUTS; seed++) {
+    const std::vector<uint8_t> data = input(seed);
+    PuzzleFuzz::Stats stats;
+    const char* violation = fuzzer(data.data(), data.size(), &stats);
+    if (violation != nullptr) {
+      char message[128];
+      snprintf(message, sizeof(message), "input(%lu): %s", (unsigned long)seed, violation);
+      TEST_FAIL_MESSAGE(message);
+    }
+    if (stats.solvedByInput) solved++;
+    if (stats.maxUpdateUs > maxUs) maxUs = stats.maxUpdateUs;
+  }
+  printf("%s: %lu/%lu inputs solved it, slowest update() %lu us\n", name, (unsigned long)solved,
+         (unsigned long)INPUTS, (unsigned long)maxUs);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_seven_seg_keeps_its_invariants() {
+  fuzz("7Seg", PuzzleFuzz::sevenSeg);
+}
+
+void test_simon_keeps_its_invariants() {
+  fuzz("Simon", PuzzleFuzz::simon);
+}
+
+// Steps that only press what the puzzle expects solve it within the steps
+void test_expected_presses_solve_both() {
+  PuzzleFuzz::Stats stats;
+  std::vector<uint8_t> dial(1, 3);   // 4-digit code
+  for (uint8_t i = 0; i < 4; i++) dial.insert(dial.end(), {5, 0});
+  TEST_ASSERT_NULL(PuzzleFuzz::sevenSeg(dial.data(), dial.size(), &stats));
+  TEST_ASSERT_TRUE(stats.solvedByInput);
+
+  std::vector<uint8_t> songs(1, 0);
+  for (uint8_t round = 0; round < 3; round++) {
+    songs.insert(songs.end(), {2, 0, 3 | 9 << 3, 255, 3 | 9 << 3, 255});   // Chord, 2 x 255 ms at 10 ms
+    for (uint8_t len = 1; len <= 6; len++) {
+      songs.insert(songs.end(), {5, 40});   // 4 s for the playback
+      for (uint8_t i = 0; i < len; i++) songs.insert(songs.end(), {1, 0});
+    }
+  }
+  TEST_ASSERT_NULL(PuzzleFuzz::simon(songs.data(), songs.size(), &stats));
+  TEST_ASSERT_TRUE(stats.solvedByInput);
+  TEST_ASSERT_UINT32_WITHIN(PuzzleFuzz::SIMON_BUDGET_US / 2, PuzzleFuzz::SIMON_BUDGET_US / 2, stats.maxUpdateUs);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_seven_seg_keeps_its_invariants);
+  RUN_TEST(test_simon_keeps_its_invariants);
+  RUN_TEST(test_expected_presses_solve_both);
+  return UNITY_END();
+}
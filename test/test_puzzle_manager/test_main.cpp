@@ -0,0 +1,251 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "MCP23017Model.h"
+#include "PuzzleManager.h"
+#include "SimonSaysPuzzle.h"
+
+static const uint8_t LOCKED = 10, UNLOCKED = 100;
+
+static MCP23017Model mcp(0x20);
+
+class FakePuzzle : public Puzzle {
+public:
+  void begin() override { begun = true; }
+  void update(uint32_t) override {
+    updates++;
+    shim::advanceUs(busyUs);
+  }
+  bool isSolved() const override { return solved; }
+  void reset() override {
+    solved = false;
+    resets++;
+  }
+  void restoreHardware() override { restores++; }
+  const __FlashStringHelper* name() const override { return F("Fake"); }
+  int ledBrightness() const override { return brightness; }
+
+  bool begun = false, solved = false;
+  int brightness = -1;
+  uint32_t updates = 0, resets = 0, restores = 0, busyUs = 0;
+};
+
+static FakePuzzle a, b;
+static Puzzle* const PUZZLES[2] = {&a, &b};
+
+static void tick(PuzzleManager<2>& m) {
+  shim::advanceMs(10);
+  m.update(millis());
+}
+
+void setUp() {
+  shim::resetArduino();
+  Serial.reset();
+  Wire.detachAll();
+  mcp = MCP23017Model(0x20);
+  Wire.attach(&mcp);
+  a = FakePuzzle();
+  b = FakePuzzle();
+}
+void tearDown() {}
+
+void test_begin_configures_leds_and_locks() {
+  PuzzleManager<2> m(0x20, 9, LOCKED, UNLOCKED, true);
+  m.attach(PUZZLES);
+  m.begin();
+  TEST_ASSERT_EQUAL_HEX8(0x07, mcp.regs[MCP23017Model::IODIR]);   // A3-A7 outputs
+  TEST_ASSERT_EQUAL_HEX8(0xFF, mcp.regs[MCP23017Model::OLAT]);    // Active low: all off
+  TEST_ASSERT_TRUE(a.begun && b.begun);
+  TEST_ASSERT_EQUAL(LOCKED, m.getServo()->read());
+}
+
+void test_missing_mcp_is_reported() {
+  mcp.present = false;
+  PuzzleManager<2> m(0x20, 9, LOCKED, UNLOCKED, true);
+  m.attach(PUZZLES);
+  m.begin();
+  TEST_ASSERT_TRUE(Serial.printed("Failed to initialize MCP23017"));
+}
+
+void test_leds_follow_puzzles() {
+  PuzzleManager<2> m(0x20, 9, LOCKED, UNLOCKED, true);
+  m.attach(PUZZLES);
+  m.begin();
+  a.solved = true;
+  tick(m);
+  TEST_ASSERT_FALSE(mcp.outputLevel(3));   // Lit
+  TEST_ASSERT_TRUE(mcp.outputLevel(4));
+  b.brightness = 200;                      // Puzzle-controlled LED, unsolved
+  tick(m);
+  TEST_ASSERT_FALSE(mcp.outputLevel(4));
+  b.brightness = 50;
+  tick(m);
+  TEST_ASSERT_TRUE(mcp.outputLevel(4));
+  a.solved = false;
+  tick(m);
+}
+
+void test_unchanged_leds_cost_no_bus_traffic() {
+  PuzzleManager<2> m(0x20, 9, LOCKED, UNLOCKED, true);
+  m.attach(PUZZLES);
+  m.begin();
+  tick(m);
+  uint32_t before = mcp.transactions;
+  for (uint8_t i = 0; i < 10; i++) tick(m);
+  TEST_ASSERT_EQUAL_UINT32(before, mcp.transactions);
+
+  // A change is one port A write, whatever the number of LEDs that changed
+  a.solved = true;
+  b.brightness = 255;
+  before = mcp.transactions;
+  const uint32_t t0 = micros();
+  m.update(millis());
+  TEST_ASSERT_EQUAL_UINT32(before + 1, mcp.transactions);
+  TEST_ASSERT_EQUAL_UINT32(3 * TwoWire::BYTE_US, micros() - t0);
+  TEST_ASSERT_EQUAL_HEX8(0xE7, mcp.regs[MCP23017Model::OLAT]);
+  a.solved = false;
+  tick(m);
+}
+
+void test_led_port_is_checked_once_a_second() {
+  PuzzleManager<2> m(0x20, 9, LOCKED, UNLOCKED, true);
+  m.attach(PUZZLES);
+  m.begin();
+  tick(m);
+  const uint32_t before = mcp.transactions;
+  for (uint16_t i = 0; i < 300; i++) tick(m);
+  TEST_ASSERT_EQUAL_UINT32(3 * 2, mcp.transactions - before);   // IODIRA read per second
+  TEST_ASSERT_FALSE(Serial.printed("WARNING"));
+}
+
+void test_expander_reset_is_repaired() {
+  PuzzleManager<2> m(0x20, 9, LOCKED, UNLOCKED, true);
+  m.attach(PUZZLES);
+  m.begin();
+  a.solved = true;
+  tick(m);
+  mcp.reset();                               // Brown-out: all inputs, LEDs dark
+  TEST_ASSERT_TRUE(mcp.outputLevel(3));
+  for (uint8_t i = 0; i < 110; i++) tick(m);
+  TEST_ASSERT_TRUE(Serial.printed("WARNING: MCP23017 lost its configuration"));
+  TEST_ASSERT_EQUAL_UINT32(1, a.restores);
+  TEST_ASSERT_EQUAL_UINT32(1, b.restores);
+  TEST_ASSERT_EQUAL_HEX8(0x07, mcp.regs[MCP23017Model::IODIR]);
+  TEST_ASSERT_FALSE(mcp.outputLevel(3));
+  TEST_ASSERT_TRUE(mcp.outputLevel(4));
+  a.solved = false;
+  tick(m);
+}
+
+void test_expander_reset_restores_simons_port_b() {
+  PuzzleManager<2> m(0x20, 9, LOCKED, UNLOCKED, true);
+  SimonSaysPuzzle simon(m.getMCP(), 5);
+  Puzzle* const puzzles[2] = {&simon, &a};
+  m.attach(puzzles);
+  m.begin();
+  TEST_ASSERT_EQUAL_HEX8(0x0F, mcp.regs[MCP23017Model::IODIR + 1]);
+  mcp.reset();
+  TEST_ASSERT_EQUAL_HEX8(0x00, mcp.regs[MCP23017Model::GPPU + 1]);   // Buttons float
+  for (uint8_t i = 0; i < 110; i++) tick(m);
+  TEST_ASSERT_EQUAL_HEX8(0x0F, mcp.regs[MCP23017Model::IODIR + 1]);
+  TEST_ASSERT_EQUAL_HEX8(0x0F, mcp.regs[MCP23017Model::GPPU + 1]);
+  TEST_ASSERT_EQUAL_HEX8(0x07, mcp.regs[MCP23017Model::IODIR]);
+
+  // Playable again: the start chord plays the first note on an LED output
+  mcp.setInput(8, false);
+  mcp.setInput(9, false);
+  mcp.setInput(11, false);
+  tick(m);
+  mcp.setInput(8, true);
+  mcp.setInput(9, true);
+  mcp.setInput(11, true);
+  bool lit = false;
+  for (uint16_t i = 0; i < 300 && !lit; i++) {
+    tick(m);
+    for (uint8_t pin = 12; pin <= 15; pin++) lit |= !mcp.outputLevel(pin);
+  }
+  TEST_ASSERT_TRUE(lit);
+}
+
+void test_reset_all_rewrites_the_latch() {
+  PuzzleManager<2> m(0x20, 9, LOCKED, UNLOCKED, true);
+  m.attach(PUZZLES);
+  m.begin();
+  tick(m);
+  mcp.regs[MCP23017Model::OLAT] = 0x00;      // Latch lost, shadow still says all off
+  m.resetAll();
+  TEST_ASSERT_EQUAL_HEX8(0xFF, mcp.regs[MCP23017Model::OLAT]);
+}
+
+void test_all_solved_unlocks_and_reset_locks() {
+  PuzzleManager<2> m(0x20, 9, LOCKED, UNLOCKED, true);
+  m.attach(PUZZLES);
+  m.begin();
+  a.solved = true;
+  tick(m);
+  TEST_ASSERT_FALSE(m.allSolved());
+  TEST_ASSERT_EQUAL(LOCKED, m.getServo()->read());
+  b.solved = true;
+  tick(m);
+  TEST_ASSERT_TRUE(m.allSolved());
+  TEST_ASSERT_EQUAL(UNLOCKED, m.getServo()->read());
+  const uint32_t writes = m.getServo()->writes;
+  tick(m);
+  TEST_ASSERT_EQUAL_UINT32(writes, m.getServo()->writes);   // Unlocked once
+
+  m.resetAll();
+  TEST_ASSERT_FALSE(m.allSolved());
+  TEST_ASSERT_EQUAL(LOCKED, m.getServo()->read());
+  TEST_ASSERT_EQUAL_UINT32(1, a.resets);
+  TEST_ASSERT_EQUAL_UINT32(1, b.resets);
+  TEST_ASSERT_EQUAL_HEX8(0xFF, mcp.regs[MCP23017Model::OLAT]);
+  tick(m);
+}
+
+void test_slow_update_is_reported() {
+  PuzzleManager<2> m(0x20, 9, LOCKED, UNLOCKED, true);
+  m.attach(PUZZLES);
+  m.begin();
+  a.busyUs = 5000;
+  tick(m);
+  TEST_ASSERT_FALSE(Serial.printed("WARNING"));
+  b.busyUs = 25000;
+  tick(m);
+  TEST_ASSERT_TRUE(Serial.printed("WARNING: P1 (Fake) update() took 25000 us"));
+  Serial.clearOutput();
+  tick(m);   // Only a new worst case warns
+  TEST_ASSERT_FALSE(Serial.printed("WARNING"));
+
+  m.printStats();
+  TEST_ASSERT_TRUE(Serial.printed("Max update() us: 5000 25000"));
+}
+
+void test_stats_report_solve_times() {
+  // Own instantiation: the state-change tracking is per PuzzleManager<N>
+  FakePuzzle c;
+  Puzzle* const one[1] = {&c};
+  PuzzleManager<1> m(0x20, 9, LOCKED, UNLOCKED, true);
+  m.attach(one);
+  m.begin();
+  shim::advanceMs(1234);
+  c.solved = true;
+  m.update(millis());
+  Serial.clearOutput();
+  m.printStats();
+  TEST_ASSERT_TRUE(Serial.printed("solved at 1234 ms"));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_begin_configures_leds_and_locks);
+  RUN_TEST(test_missing_mcp_is_reported);
+  RUN_TEST(test_leds_follow_puzzles);
+  RUN_TEST(test_unchanged_leds_cost_no_bus_traffic);
+  RUN_TEST(test_led_port_is_checked_once_a_second);
+  RUN_TEST(test_expander_reset_is_repaired);
+  RUN_TEST(test_expander_reset_restores_simons_port_b);
+  RUN_TEST(test_reset_all_rewrites_the_latch);
+  RUN_TEST(test_all_solved_unlocks_and_reset_locks);
+  RUN_TEST(test_slow_update_is_reported);
+  RUN_TEST(test_stats_report_solve_times);
+  return UNITY_END();
+}
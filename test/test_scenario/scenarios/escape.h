@@ -0,0 +1,17 @@
+// Every puzzle in turn, as a group plays it, until the box opens
+static const char SCENARIO_escape[] = R"scenario(
+t=0 key on
+t=0.5s dial 9197
+expect solved 0
+t=5s tilt up
+t=15.5s tilt down
+expect solved 1
+simon play
+expect "Simon Says puzzle SOLVED"
+nfc 04:A6:89:72:3C:4D:80
+expect solved 3
+knock 300,600,300
+wait 1s
+expect "*** ALL PUZZLES SOLVED - UNLOCKING BOX! ***"
+expect unlocked
+)scenario";
@@ -0,0 +1,14 @@
+// Field report: knocking evenly while the tilt is still held. Tilt solves after its 10 s hold,
+// the even knocks miss the 300/600/300 rhythm, and the figure still works afterwards.
+static const char SCENARIO_even_knocks[] = R"scenario(
+t=0 key on
+t=1.2s tilt up
+t=11.5s knock x4 @300ms
+expect solved 1
+expect unsolved 4
+t=15s nfc 04:A6:89:72:3C:4D:80
+expect "AMIIBO ACCEPTED"
+expect solved 3
+tilt down
+expect locked
+)scenario";
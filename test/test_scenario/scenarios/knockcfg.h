@@ -0,0 +1,9 @@
+// KNOCKCFG with garbage arguments prints the usage line and keeps the detector's settings
+static const char SCENARIO_knockcfg[] = R"scenario(
+serial KNOCKCFG abc x y
+expect "Usage: KNOCKCFG"
+serial KNOCKCFG
+expect "[Knock] threshold=3.50 m/s^2"
+knock 300,600,300
+expect solved 4
+)scenario";
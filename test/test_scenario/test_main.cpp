@@ -0,0 +1,94 @@
+// Scripted escape sessions (see shim/Scenario.h for the format) against the real sketch.
+// Each scenario starts from a key cycle, so every puzzle is reset and the session clock restarts;
+// its solve times and loop statistics are printed after it. Field bug reports go in scenarios/
+// as a script that reproduces them, with the expectations the fix has to meet.
+#include <Arduino.h>
+#include <unity.h>
+#include "main.cpp"
+#include "Scenario.h"
+
+#include "scenarios/escape.h"
+#include "scenarios/even_knocks.h"
+#include "scenarios/knockcfg.h"
+
+static void play(const char* name, const char* script) {
+  session::Scenario scenario;
+  const bool ok = scenario.run(script);
+  printf("---- %s ----\n", name);
+  scenario.report();
+  TEST_ASSERT_TRUE_MESSAGE(ok, scenario.error().c_str());
+}
+
+void setUp() {
+  session::key(false);
+  session::key(true);
+  session::run(3000);   // Startup jingle and the NFC reader's restart
+  Serial.clearOutput();
+  session::cpuUs = 0;
+  Wire.bytes = 0;
+}
+
+void tearDown() {}
+
+void test_escape() {
+  play("escape", SCENARIO_escape);
+  TEST_ASSERT_TRUE(manager.allSolved());
+}
+
+void test_even_knocks() {
+  play("even_knocks", SCENARIO_even_knocks);
+}
+
+void test_knockcfg_rejects_garbage() {
+  play("knockcfg", SCENARIO_knockcfg);
+}
+
+void test_statements_run_in_time_order() {
+  session::Scenario scenario;
+  const uint32_t start = millis();
+  TEST_ASSERT_TRUE_MESSAGE(scenario.run("t=0.5s wait 10; t=1s # settle\n  wait 250ms"), scenario.error().c_str());
+  TEST_ASSERT_UINT32_WITHIN(5, 1250, millis() - start);   // A tick may end a little past the mark
+}
+
+void test_errors_name_the_line() {
+  session::Scenario scenario;
+  TEST_ASSERT_FALSE(scenario.run("wait 10\nfrobnicate"));
+  TEST_ASSERT_EQUAL_STRING("line 2: unknown action frobnicate", scenario.error().c_str());
+
+  TEST_ASSERT_FALSE(scenario.run("t=2s wait 1\nt=1s key on"));
+  TEST_ASSERT_EQUAL_STRING("line 2: t=1s key on: already", scenario.error().substr(0, 28).c_str());
+
+  TEST_ASSERT_FALSE(scenario.run("nfc 04:A6:89 # short\nwait 10"));
+  TEST_ASSERT_EQUAL_STRING("line 1: nfc needs a 7-byte UID, got 04:A6:89", scenario.error().c_str());
+
+  TEST_ASSERT_FALSE(scenario.run("simon press 0,4"));
+  TEST_ASSERT_EQUAL_STRING("line 1: bad buttons 0,4", scenario.error().c_str());
+}
+
+void test_failed_expectation_stops_the_script() {
+  session::Scenario scenario;
+  const uint32_t start = millis();
+  TEST_ASSERT_FALSE(scenario.run("serial STATUS; expect \"ALL SOLVED\"; wait 5s"));
+  TEST_ASSERT_EQUAL_STRING("line 1: expected \"ALL SOLVED\" in the serial output", scenario.error().c_str());
+  TEST_ASSERT_UINT32_WITHIN(5, 100, millis() - start);
+
+  TEST_ASSERT_FALSE(scenario.run("expect solved 2"));
+  TEST_ASSERT_EQUAL_STRING("line 1: expected puzzle 2 (Simon Says) solved", scenario.error().c_str());
+
+  // Text matches are ordered: STATUS lists Puzzle 0 before Puzzle 4
+  TEST_ASSERT_TRUE(scenario.run("serial STATUS; expect \"Puzzle 0\"; expect \"Puzzle 4\""));
+  TEST_ASSERT_FALSE(scenario.run("serial STATUS; expect \"Puzzle 4\"; expect \"Puzzle 0\""));
+}
+
+int main(int argc, char** argv) {
+  session::attach();
+  session::boot();
+  UNITY_BEGIN();
+  RUN_TEST(test_escape);
+  RUN_TEST(test_even_knocks);
+  RUN_TEST(test_knockcfg_rejects_garbage);
+  RUN_TEST(test_statements_run_in_time_order);
+  RUN_TEST(test_errors_name_the_line);
+  RUN_TEST(test_failed_expectation_stops_the_script);
+  return UNITY_END();
+}
@@ -0,0 +1,179 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <vector>
+#include "ADXL345Model.h"
+#include "SensorHub.h"
+
+static ADXL345Model adxl;
+
+// Records every sample it is handed; optionally asks for a responsive idle
+class Recorder : public AccelSubscriber {
+public:
+  void onAccelSample(const AccelSample& s) override { samples.push_back(s); }
+  bool wantsResponsiveIdle() const override { return responsive; }
+  std::vector<AccelSample> samples;
+  bool responsive = false;
+};
+
+static const uint8_t BW_RATE = 0x2C;
+
+void setUp() {
+  shim::resetArduino();
+  Serial.reset();
+  Wire.detachAll();
+  adxl.reset();
+  Wire.attach(&adxl);
+}
+void tearDown() {}
+
+void test_begin_without_sensor_is_not_ready() {
+  Wire.detachAll();
+  SensorHub hub;
+  hub.begin();
+  TEST_ASSERT_FALSE(hub.ready());
+  TEST_ASSERT_TRUE(Serial.printed("ADXL345 initialization failed"));
+}
+
+void test_begin_rejects_wrong_device_id() {
+  adxl.regs[0x00] = 0x00;
+  SensorHub hub;
+  hub.begin();
+  TEST_ASSERT_FALSE(hub.ready());
+}
+
+void test_begin_calibrates_rest_vector() {
+  adxl.rest = {12, -8, 250};
+  adxl.reset();
+  SensorHub hub;
+  hub.begin();
+  TEST_ASSERT_TRUE(hub.ready());
+  TEST_ASSERT_TRUE(hub.active());
+  TEST_ASSERT_EQUAL_INT(12, hub.restVector()[0]);
+  TEST_ASSERT_EQUAL_INT(-8, hub.restVector()[1]);
+  TEST_ASSERT_EQUAL_INT(250, hub.restVector()[2]);
+  adxl.rest = {0, 0, 256};
+}
+
+void test_backlog_over_one_tick_is_delivered_in_order_and_dated_within_a_period() {
+  SensorHub hub;
+  hub.begin();
+  Recorder rec;
+  hub.subscribe(&rec);
+  while (adxl.fifoCount() > 0) hub.update(millis());   // Drain and sync
+  rec.samples.clear();
+
+  const uint32_t period = adxl.periodUs();   // Active rate, 200 Hz
+  TEST_ASSERT_EQUAL_UINT32(5000, period);
+  for (int16_t k = 1; k <= 200; k++) adxl.script(k, 0, 256);
+  shim::advanceMs(120);                        // 24 samples queued: more than one tick's 16
+  TEST_ASSERT_EQUAL_UINT8(24, adxl.fifoCount());
+  hub.update(millis());
+  TEST_ASSERT_EQUAL(16, (int)rec.samples.size());
+  for (uint8_t tick = 0; tick < 5; tick++) {
+    shim::advanceMs(10);
+    hub.update(millis());
+  }
+
+  // No sample lost or repeated, oldest first
+  TEST_ASSERT_GREATER_OR_EQUAL(24, (int)rec.samples.size());
+  for (size_t i = 0; i < rec.samples.size(); i++) {
+    TEST_ASSERT_EQUAL_INT((int)i + 1, rec.samples[i].x);
+  }
+  // Strictly increasing, and each dated within one period after the sensor took it
+  for (size_t i = 0; i < rec.samples.size(); i++) {
+    if (i > 0) TEST_ASSERT_GREATER_THAN(0, (int32_t)(rec.samples[i].us - rec.samples[i - 1].us));
+    const uint32_t lateUs = rec.samples[i].us - adxl.scriptedAt[i];
+    TEST_ASSERT_LESS_THAN(period, lateUs);
+  }
+}
+
+void test_resync_after_long_pause_keeps_order() {
+  SensorHub hub;
+  hub.begin();
+  Recorder rec;
+  hub.subscribe(&rec);
+  hub.update(millis());
+  shim::advanceMs(50);
+  hub.update(millis());
+  const uint32_t lastUs = rec.samples.back().us;
+  rec.samples.clear();
+
+  shim::advanceMs(5000);   // Key off: FIFO overflowed long ago
+  hub.update(millis());
+  TEST_ASSERT_EQUAL(16, (int)rec.samples.size());
+  TEST_ASSERT_GREATER_THAN(0, (int32_t)(rec.samples[0].us - lastUs));
+  // The batch is dated against the read, not against the stale last timestamp
+  TEST_ASSERT_GREATER_THAN(micros() - 32 * adxl.periodUs() - 20000, rec.samples[0].us);
+}
+
+void test_rate_follows_activity_and_subscribers() {
+  SensorHub hub;
+  hub.begin();
+  Recorder rec;
+  hub.subscribe(&rec);
+  hub.update(millis());
+  TEST_ASSERT_EQUAL_HEX8(0x0B, adxl.regs[BW_RATE]);      // Active: 200 Hz
+
+  adxl.latchEvents(0x08);                                 // Inactivity
+  shim::advanceMs(10);
+  hub.update(millis());
+  TEST_ASSERT_FALSE(hub.active());
+  TEST_ASSERT_EQUAL_HEX8(0x19, adxl.regs[BW_RATE]);      // Idle: 50 Hz low power
+
+  rec.responsive = true;
+  shim::advanceMs(10);
+  hub.update(millis());
+  TEST_ASSERT_EQUAL_HEX8(0x0A, adxl.regs[BW_RATE]);      // Responsive idle: 100 Hz full power
+
+  adxl.latchEvents(0x10);                                 // Activity
+  shim::advanceMs(10);
+  hub.update(millis());
+  TEST_ASSERT_TRUE(hub.active());
+  TEST_ASSERT_EQUAL_HEX8(0x0B, adxl.regs[BW_RATE]);
+}
+
+void test_rate_is_written_only_on_change() {
+  SensorHub hub;
+  hub.begin();
+  Recorder rec;
+  hub.subscribe(&rec);
+  const uint16_t writes = adxl.regWrites[BW_RATE];
+  for (uint8_t i = 0; i < 50; i++) {
+    shim::advanceMs(10);
+    hub.update(millis());
+  }
+  TEST_ASSERT_EQUAL_UINT16(writes, adxl.regWrites[BW_RATE]);
+}
+
+void test_idle_tick_cost() {
+  SensorHub hub;
+  hub.begin();
+  Recorder rec;
+  hub.subscribe(&rec);
+  while (adxl.fifoCount() > 0) hub.update(millis());
+  adxl.regs[0x2D] = 0;   // Standby: nothing more is queued
+  // Empty FIFO: INT_SOURCE + FIFO_STATUS only
+  const uint32_t before = adxl.transactions;
+  hub.update(millis());
+  TEST_ASSERT_EQUAL_UINT32(before + 4, adxl.transactions);
+
+  // No subscribers: the hub stays off the bus
+  SensorHub unused;
+  unused.begin();
+  const uint32_t after = adxl.transactions;
+  unused.update(millis());
+  TEST_ASSERT_EQUAL_UINT32(after, adxl.transactions);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_begin_without_sensor_is_not_ready);
+  RUN_TEST(test_begin_rejects_wrong_device_id);
+  RUN_TEST(test_begin_calibrates_rest_vector);
+  RUN_TEST(test_backlog_over_one_tick_is_delivered_in_order_and_dated_within_a_period);
+  RUN_TEST(test_resync_after_long_pause_keeps_order);
+  RUN_TEST(test_rate_follows_activity_and_subscribers);
+  RUN_TEST(test_rate_is_written_only_on_change);
+  RUN_TEST(test_idle_tick_cost);
+  return UNITY_END();
+}
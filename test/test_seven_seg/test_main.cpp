@@ -0,0 +1,161 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "PCF8574Model.h"
+#include "SevenSegCodePuzzle.h"
+
+static PCF8574Model pcf(0x25);
+
+// Segment patterns a..g (= PCF P0..P6) per digit
+static const uint8_t DIGIT_SEGMENTS[10] = {0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F};
+static const uint8_t BUTTON = 7;
+
+static void setSwitches(uint8_t segments) {
+  for (uint8_t pin = 0; pin < 7; pin++) pcf.setSwitch(pin, (segments >> pin) & 1);
+}
+
+// Run the puzzle at a 5 ms loop for ms milliseconds
+static void run(SevenSegCodePuzzle& p, uint32_t ms) {
+  const uint32_t end = millis() + ms;
+  while ((int32_t)(millis() - end) < 0) {
+    shim::advanceMs(5);
+    p.update(millis());
+  }
+}
+
+// Dial a pattern on the switches and press the button
+static void enterSegments(SevenSegCodePuzzle& p, uint8_t segments) {
+  setSwitches(segments);
+  run(p, 60);
+  pcf.setSwitch(BUTTON, true);
+  run(p, 60);
+  pcf.setSwitch(BUTTON, false);
+  setSwitches(0);
+  run(p, 60);
+}
+
+static void enterCode(SevenSegCodePuzzle& p, const char* digits) {
+  for (const char* c = digits; *c; c++) enterSegments(p, DIGIT_SEGMENTS[*c - '0']);
+}
+
+void setUp() {
+  shim::resetArduino();
+  Serial.reset();
+  Wire.detachAll();
+  pcf = PCF8574Model(0x25);
+  Wire.attach(&pcf);
+}
+void tearDown() {}
+
+void test_code_validation() {
+  TEST_ASSERT_TRUE(SevenSegCodePuzzle::isValidCode(0x9197, 4));
+  TEST_ASSERT_TRUE(SevenSegCodePuzzle::isValidCode(0x0123, 3));
+  TEST_ASSERT_FALSE(SevenSegCodePuzzle::isValidCode(0x1234, 3));   // Longer than the code length
+  TEST_ASSERT_FALSE(SevenSegCodePuzzle::isValidCode(0x12A4, 4));   // Not BCD
+  TEST_ASSERT_FALSE(SevenSegCodePuzzle::isValidCode(0xF000, 4));
+}
+
+void test_invalid_code_is_reported_at_begin() {
+  static const uint16_t codes[] = {0x12A4};
+  SevenSegCodePuzzle p(10, 11, 0x25, codes, 1);
+  p.begin();
+  TEST_ASSERT_TRUE(Serial.printed("7Seg ERROR: code 0x12A4"));
+}
+
+void test_correct_code_solves_and_locks() {
+  static const uint16_t codes[] = {0x9197};
+  SevenSegCodePuzzle p(10, 11, 0x25, codes, 1);
+  p.begin();
+  TEST_ASSERT_FALSE(Serial.printed("ERROR"));
+  enterCode(p, "919");
+  TEST_ASSERT_FALSE(p.isSolved());
+  enterSegments(p, DIGIT_SEGMENTS[7]);
+  TEST_ASSERT_TRUE(p.isSolved());
+
+  const uint8_t expected[4] = {DIGIT_SEGMENTS[9], DIGIT_SEGMENTS[1], DIGIT_SEGMENTS[9], DIGIT_SEGMENTS[7]};
+  TM1637Display* display = TM1637Display::last();
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, display->shown, 4);
+
+  // Locked: input is ignored and costs no bus traffic
+  const uint32_t before = pcf.transactions;
+  enterSegments(p, DIGIT_SEGMENTS[1]);
+  TEST_ASSERT_EQUAL_UINT32(before, pcf.transactions);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, display->shown, 4);
+}
+
+void test_wrong_code_resets_the_entry() {
+  static const uint16_t codes[] = {0x9197};
+  SevenSegCodePuzzle p(10, 11, 0x25, codes, 1);
+  p.begin();
+  enterCode(p, "9198");
+  TEST_ASSERT_FALSE(p.isSolved());
+  // The failure ritual ends on a blank display; the next full entry is judged on its own
+  enterCode(p, "9197");
+  TEST_ASSERT_TRUE(p.isSolved());
+}
+
+void test_pattern_that_is_no_digit_is_not_stored() {
+  static const uint16_t codes[] = {0x9197};
+  SevenSegCodePuzzle p(10, 11, 0x25, codes, 1);
+  p.begin();
+  enterCode(p, "91");
+  enterSegments(p, SEG_A | SEG_D);   // Not a digit
+  enterCode(p, "97");
+  TEST_ASSERT_TRUE(p.isSolved());
+}
+
+void test_any_listed_code_is_accepted() {
+  static const uint16_t codes[] = {0x1234, 0x9197};
+  SevenSegCodePuzzle first(10, 11, 0x25, codes, 2);
+  first.begin();
+  enterCode(first, "1234");
+  TEST_ASSERT_TRUE(first.isSolved());
+
+  SevenSegCodePuzzle second(10, 11, 0x25, codes, 2);
+  second.begin();
+  enterCode(second, "9197");
+  TEST_ASSERT_TRUE(second.isSolved());
+}
+
+void test_short_code() {
+  static const uint16_t codes[] = {0x0042};
+  SevenSegCodePuzzle p(10, 11, 0x25, codes, 1, 3);
+  p.begin();
+  enterCode(p, "04");
+  TEST_ASSERT_FALSE(p.isSolved());
+  enterCode(p, "2");
+  TEST_ASSERT_TRUE(p.isSolved());
+}
+
+void test_idle_tick_is_one_port_read_and_display_writes_only_on_change() {
+  static const uint16_t codes[] = {0x9197};
+  SevenSegCodePuzzle p(10, 11, 0x25, codes, 1);
+  p.begin();
+  TM1637Display* display = TM1637Display::last();
+  const uint32_t transfers = display->transfers;
+  uint32_t worstUs = 0;
+  for (uint16_t i = 0; i < 200; i++) {   // 1 s at 5 ms
+    shim::advanceMs(5);
+    const uint32_t reads = pcf.transactions;
+    const uint32_t t0 = micros();
+    p.update(millis());
+    const uint32_t us = micros() - t0;
+    if (us > worstUs) worstUs = us;
+    TEST_ASSERT_EQUAL_UINT32(reads + 1, pcf.transactions);
+  }
+  // The cursor blinks every 450 ms: two or three frames in a second, not one per tick
+  TEST_ASSERT_LESS_OR_EQUAL(3, display->transfers - transfers);
+  TEST_ASSERT_LESS_OR_EQUAL(TwoWire::BYTE_US * 2 + TM1637Display::TRANSFER_US, worstUs);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_code_validation);
+  RUN_TEST(test_invalid_code_is_reported_at_begin);
+  RUN_TEST(test_correct_code_solves_and_locks);
+  RUN_TEST(test_wrong_code_resets_the_entry);
+  RUN_TEST(test_pattern_that_is_no_digit_is_not_stored);
+  RUN_TEST(test_any_listed_code_is_accepted);
+  RUN_TEST(test_short_code);
+  RUN_TEST(test_idle_tick_is_one_port_read_and_display_writes_only_on_change);
+  return UNITY_END();
+}
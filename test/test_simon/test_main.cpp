@@ -0,0 +1,207 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <vector>
+#include "MCP23017Model.h"
+#include "SimonSaysPuzzle.h"
+
+// Buttons on B0-B3 (MCP pins 8-11), LEDs on B4-B7 (12-15), both active low
+static MCP23017Model mcp(0x20);
+static Adafruit_MCP23X17 driver;
+
+static const uint8_t SONGS[3][6] = {{0, 1, 1, 2, 3, 3}, {0, 0, 1, 1, 0, 2}, {0, 1, 0, 1, 2, 3}};
+
+static uint8_t litLeds() {
+  uint8_t lit = 0;
+  for (uint8_t b = 0; b < 4; b++) {
+    if (!mcp.outputLevel(12 + b)) lit |= 1 << b;
+  }
+  return lit;
+}
+
+static void tick(SimonSaysPuzzle& s) {
+  shim::advanceMs(10);
+  s.update(millis());
+}
+
+// Run until the puzzle asks for input; returns the LEDs lit on the way, in order
+static std::vector<uint8_t> watchUntilTurn(SimonSaysPuzzle& s) {
+  std::vector<uint8_t> seen;
+  uint8_t lit = 0;
+  Serial.clearOutput();
+  for (uint16_t i = 0; i < 2000 && !Serial.printed("Your turn!"); i++) {
+    tick(s);
+    const uint8_t now = litLeds();
+    for (uint8_t b = 0; b < 4; b++) {
+      if (now & ~lit & (1 << b)) seen.push_back(b);
+    }
+    lit = now;
+  }
+  TEST_ASSERT_TRUE_MESSAGE(Serial.printed("Your turn!"), "sequence never finished");
+  return seen;
+}
+
+// Let the previous press be released, then press and let go of one button
+static void press(SimonSaysPuzzle& s, uint8_t button) {
+  for (uint8_t i = 0; i < 5; i++) tick(s);
+  mcp.setInput(8 + button, false);
+  tick(s);
+  mcp.setInput(8 + button, true);
+}
+
+// Buttons 1, 2 and 4 together
+static void startChord(SimonSaysPuzzle& s) {
+  for (uint8_t i = 0; i < 5; i++) tick(s);
+  mcp.setInput(8, false);
+  mcp.setInput(9, false);
+  mcp.setInput(11, false);
+  tick(s);
+  mcp.setInput(8, true);
+  mcp.setInput(9, true);
+  mcp.setInput(11, true);
+}
+
+// Play one round through its build-up passes, checking each pass extends the last
+static std::vector<uint8_t> playRound(SimonSaysPuzzle& s, uint8_t length) {
+  std::vector<uint8_t> prev;
+  for (uint8_t len = 1; len <= length; len++) {
+    const std::vector<uint8_t> seq = watchUntilTurn(s);
+    TEST_ASSERT_EQUAL(len, (int)seq.size());
+    for (size_t i = 0; i < prev.size(); i++) TEST_ASSERT_EQUAL_UINT8(prev[i], seq[i]);
+    for (uint8_t b : seq) press(s, b);
+    prev = seq;
+  }
+  return prev;
+}
+
+void setUp() {
+  shim::resetArduino();
+  Serial.reset();
+  Wire.detachAll();
+  mcp = MCP23017Model(0x20);
+  Wire.attach(&mcp);
+  driver.begin_I2C(0x20);
+}
+void tearDown() {}
+
+void test_begin_configures_port_b() {
+  SimonSaysPuzzle s(&driver, 5);
+  s.begin();
+  TEST_ASSERT_EQUAL_HEX8(0x0F, mcp.regs[MCP23017Model::IODIR + 1]);   // B0-B3 in, B4-B7 out
+  TEST_ASSERT_EQUAL_HEX8(0x0F, mcp.regs[MCP23017Model::GPPU + 1]);
+  TEST_ASSERT_EQUAL_HEX8(0, litLeds());
+}
+
+void test_songs_play_through_to_solved() {
+  SimonSaysPuzzle s(&driver, 5);
+  s.begin();
+  for (uint8_t round = 0; round < 3; round++) {
+    startChord(s);
+    const std::vector<uint8_t> song = playRound(s, 6);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(SONGS[round], song.data(), 6);
+  }
+  TEST_ASSERT_TRUE(s.isSolved());
+  TEST_ASSERT_EQUAL_HEX8(0, litLeds());
+}
+
+void test_wrong_button_replays_the_same_length() {
+  SimonSaysPuzzle s(&driver, 5);
+  s.begin();
+  startChord(s);
+  std::vector<uint8_t> seq = watchUntilTurn(s);
+  press(s, 1);
+  TEST_ASSERT_TRUE(Serial.printed("Wrong! Expected button 0, got 1"));
+  seq = watchUntilTurn(s);
+  TEST_ASSERT_EQUAL(1, (int)seq.size());
+  TEST_ASSERT_EQUAL_UINT8(0, seq[0]);
+}
+
+void test_four_timeouts_reset_the_game() {
+  SimonSaysPuzzle s(&driver, 5);
+  s.begin();
+  startChord(s);
+  for (uint8_t i = 1; i <= 4; i++) {
+    watchUntilTurn(s);
+    for (uint16_t t = 0; t < 520; t++) tick(s);   // 5.2 s without input
+  }
+  TEST_ASSERT_TRUE(Serial.printed("Too many timeouts"));
+  // Back at the start: without the chord nothing plays
+  Serial.clearOutput();
+  for (uint16_t t = 0; t < 300; t++) tick(s);
+  TEST_ASSERT_FALSE(Serial.printed("Watch and listen"));
+}
+
+void test_procedural_rounds_respect_mask_and_repeat_limit() {
+  SimonSaysPuzzle s(&driver, 5);
+  s.useProceduralSequences(8, 0x0F, 2);
+  s.setNoisePin(A0);
+  s.begin();
+  std::vector<uint8_t> rounds[3];
+  for (uint8_t round = 0; round < 3; round++) {
+    startChord(s);
+    rounds[round] = playRound(s, 8);
+    uint8_t run = 1;
+    for (size_t i = 1; i < rounds[round].size(); i++) {
+      run = rounds[round][i] == rounds[round][i - 1] ? run + 1 : 1;
+      TEST_ASSERT_LESS_OR_EQUAL(2, run);
+    }
+  }
+  TEST_ASSERT_TRUE(s.isSolved());
+  TEST_ASSERT_FALSE(rounds[0] == rounds[1] && rounds[1] == rounds[2]);
+}
+
+void test_procedural_button_mask() {
+  SimonSaysPuzzle s(&driver, 5);
+  s.useProceduralSequences(6, 0x05, 0);
+  s.begin();
+  startChord(s);
+  const std::vector<uint8_t> seq = playRound(s, 6);
+  for (uint8_t b : seq) TEST_ASSERT_TRUE(b == 0 || b == 2);
+}
+
+void test_procedural_replay_after_mistake_is_identical() {
+  SimonSaysPuzzle s(&driver, 5);
+  s.useProceduralSequences(5);
+  s.begin();
+  startChord(s);
+  for (uint8_t len = 1; len < 4; len++) {
+    for (uint8_t b : watchUntilTurn(s)) press(s, b);
+  }
+  const std::vector<uint8_t> first = watchUntilTurn(s);
+  press(s, (first[0] + 1) & 3);   // Wrong on the first step
+  TEST_ASSERT_TRUE(Serial.printed("Wrong!"));
+  const std::vector<uint8_t> again = watchUntilTurn(s);
+  TEST_ASSERT_TRUE(first == again);
+}
+
+void test_waiting_tick_is_one_port_read() {
+  SimonSaysPuzzle s(&driver, 5);
+  s.begin();
+  const uint32_t before = mcp.transactions;
+  const uint32_t t0 = micros();
+  s.update(millis());
+  TEST_ASSERT_EQUAL_UINT32(before + 2, mcp.transactions);
+  TEST_ASSERT_EQUAL_UINT32(4 * TwoWire::BYTE_US, micros() - t0);
+}
+
+void test_without_mcp_update_is_inert() {
+  SimonSaysPuzzle s(nullptr, 5);
+  s.begin();
+  const uint32_t before = mcp.transactions;
+  for (uint8_t i = 0; i < 10; i++) tick(s);
+  TEST_ASSERT_EQUAL_UINT32(before, mcp.transactions);
+  TEST_ASSERT_FALSE(s.isSolved());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_begin_configures_port_b);
+  RUN_TEST(test_songs_play_through_to_solved);
+  RUN_TEST(test_wrong_button_replays_the_same_length);
+  RUN_TEST(test_four_timeouts_reset_the_game);
+  RUN_TEST(test_procedural_rounds_respect_mask_and_repeat_limit);
+  RUN_TEST(test_procedural_button_mask);
+  RUN_TEST(test_procedural_replay_after_mistake_is_identical);
+  RUN_TEST(test_waiting_tick_is_one_port_read);
+  RUN_TEST(test_without_mcp_update_is_inert);
+  return UNITY_END();
+}
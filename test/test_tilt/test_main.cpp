@@ -0,0 +1,266 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "ADXL345Model.h"
+#include "TiltButtonPuzzle.h"
+
+static const uint8_t PIN = 4;   // PCINT20, active low
+
+static ADXL345Model adxl;
+
+// Move the tilt switch; in pin-change mode the PCINT2 vector fires like on the AVR
+static void setSwitch(bool active) {
+  shim::setPin(PIN, active ? LOW : HIGH);
+  if ((PCICR & _BV(PCIE2)) && (*digitalPinToPCMSK(PIN) & _BV(digitalPinToPCMSKbit(PIN)))) {
+    TiltButtonPuzzle::pinChangeISR();
+  }
+}
+
+// Loop at periodMs until ms have passed; returns the millis() at which the puzzle was solved, or 0
+static uint32_t run(TiltButtonPuzzle& p, uint32_t ms, uint32_t periodMs = 5) {
+  const uint32_t end = millis() + ms;
+  while ((int32_t)(millis() - end) < 0) {
+    shim::advanceMs(periodMs);
+    p.update(millis());
+    if (p.isSolved()) return millis();
+  }
+  return 0;
+}
+
+void setUp() {
+  shim::resetArduino();
+  Serial.reset();
+  Wire.detachAll();
+}
+void tearDown() {}
+
+void test_polled_hold_solves_after_hold_time() {
+  TiltButtonPuzzle p(PIN);
+  p.begin();
+  TEST_ASSERT_EQUAL(INPUT_PULLUP, shim::pinModes()[PIN]);
+  run(p, 100);
+  const uint32_t t0 = millis();
+  setSwitch(true);
+  const uint32_t solvedAt = run(p, 11000);
+  TEST_ASSERT_NOT_EQUAL(0, solvedAt);
+  // Debounce (4 samples at 7 ms) plus the 10 s hold
+  TEST_ASSERT_UINT32_WITHIN(20, t0 + 10000 + 30, solvedAt);
+}
+
+void test_polled_release_restarts_the_countdown() {
+  TiltButtonPuzzle p(PIN);
+  p.begin();
+  setSwitch(true);
+  run(p, 6000);
+  TEST_ASSERT_TRUE(Serial.printed("Tilt sensor activated"));
+  setSwitch(false);
+  run(p, 500);
+  TEST_ASSERT_TRUE(Serial.printed("Tilt sensor deactivated"));
+  const uint32_t t0 = millis();
+  setSwitch(true);
+  const uint32_t solvedAt = run(p, 11000);
+  TEST_ASSERT_UINT32_WITHIN(20, t0 + 10000 + 30, solvedAt);
+}
+
+void test_polled_glitch_shorter_than_debounce_is_ignored() {
+  TiltButtonPuzzle p(PIN);
+  p.begin();
+  setSwitch(true);
+  run(p, 15);
+  setSwitch(false);
+  run(p, 200);
+  TEST_ASSERT_FALSE(Serial.printed("Tilt sensor activated"));
+  TEST_ASSERT_EQUAL_INT(0, p.ledBrightness());
+}
+
+void test_led_blinks_during_countdown_and_is_solid_when_solved() {
+  TiltButtonPuzzle p(PIN, true, 30, 1000);
+  p.begin();
+  setSwitch(true);
+  run(p, 100);
+  bool sawOn = false, sawOff = false;
+  for (uint8_t i = 0; i < 12; i++) {
+    run(p, 50);
+    if (p.isSolved()) break;
+    if (p.ledBrightness() == 255) sawOn = true;
+    if (p.ledBrightness() == 0) sawOff = true;
+  }
+  TEST_ASSERT_TRUE(sawOn && sawOff);
+  run(p, 1000);
+  TEST_ASSERT_TRUE(p.isSolved());
+  TEST_ASSERT_EQUAL_INT(-1, p.ledBrightness());
+}
+
+void test_update_does_no_blocking_work() {
+  TiltButtonPuzzle p(PIN);
+  p.begin();
+  setSwitch(true);
+  for (uint16_t i = 0; i < 500; i++) {
+    shim::advanceMs(5);
+    const uint32_t t0 = micros();
+    p.update(millis());
+    TEST_ASSERT_EQUAL_UINT32(t0 + DIGITAL_READ_US, micros());   // The switch read, nothing more
+  }
+}
+
+void test_pin_change_mode_arms_pcint2() {
+  TiltButtonPuzzle p(PIN);
+  p.usePinChangeInterrupt();
+  p.begin();
+  TEST_ASSERT_TRUE(PCICR & _BV(PCIE2));
+  TEST_ASSERT_TRUE(*digitalPinToPCMSK(PIN) & _BV(digitalPinToPCMSKbit(PIN)));
+}
+
+void test_pin_change_mode_needs_port_d() {
+  TiltButtonPuzzle p(9);
+  p.usePinChangeInterrupt();
+  p.begin();
+  TEST_ASSERT_TRUE(Serial.printed("polling instead"));
+  TEST_ASSERT_EQUAL_HEX8(0, PCICR);
+}
+
+void test_pin_change_countdown_starts_at_the_debounced_edge() {
+  TiltButtonPuzzle p(PIN);
+  p.usePinChangeInterrupt();
+  p.begin();
+  shim::advanceMs(1000);
+  const uint32_t edgeAt = millis();
+  setSwitch(true);
+  // The loop only comes round 500 ms later: the countdown still starts 30 ms after the edge
+  shim::advanceMs(500);
+  p.update(millis());
+  TEST_ASSERT_TRUE(Serial.printed("Tilt sensor activated"));
+  shim::advanceMs(edgeAt + 30 + 10000 - 1 - millis());
+  p.update(millis());
+  TEST_ASSERT_FALSE(p.isSolved());
+  shim::advanceMs(1);
+  p.update(millis());
+  TEST_ASSERT_TRUE(p.isSolved());
+}
+
+void test_pin_change_chatter_integrates() {
+  TiltButtonPuzzle p(PIN);
+  p.usePinChangeInterrupt();
+  p.begin();
+  shim::advanceMs(100);
+  const uint32_t t0 = millis();
+  setSwitch(true);           // +10 ms active
+  shim::advanceMs(10);
+  setSwitch(false);          // -4 ms inactive: integrator at 6
+  shim::advanceMs(4);
+  setSwitch(true);           // Needs 24 more ms
+  shim::advanceMs(23);
+  p.update(millis());
+  TEST_ASSERT_FALSE(Serial.printed("Tilt sensor activated"));
+  shim::advanceMs(1);
+  p.update(millis());
+  TEST_ASSERT_TRUE(Serial.printed("Tilt sensor activated"));
+  // Solved 10 s after the integrator filled (t0 + 38), however late the loop looks
+  shim::advanceMs(t0 + 38 + 10000 - millis());
+  p.update(millis());
+  TEST_ASSERT_TRUE(p.isSolved());
+}
+
+void test_pin_change_edge_after_the_loops_now() {
+  TiltButtonPuzzle p(PIN);
+  p.usePinChangeInterrupt();
+  p.begin();
+  shim::advanceMs(100);
+  // The loop samples now, then the switch bounces before update() runs
+  const uint32_t now = millis();
+  shim::advanceMs(3);
+  const uint32_t edgeAt = millis();
+  setSwitch(true);
+  p.update(now);
+  TEST_ASSERT_FALSE(p.isSolved());
+  TEST_ASSERT_FALSE(Serial.printed("Tilt sensor activated"));
+  shim::advanceMs(1);
+  setSwitch(false);
+  shim::advanceMs(1);
+  setSwitch(true);
+  p.update(millis());
+  TEST_ASSERT_FALSE(p.isSolved());
+
+  // Activated 30 ms after the edge less the 1 ms bounce, and solved 10 s after that
+  shim::advanceMs(edgeAt + 32 - millis());
+  const uint32_t late = millis();
+  shim::advanceMs(2);
+  p.update(late);   // ISR-side time is ahead of the loop's again
+  TEST_ASSERT_FALSE(p.isSolved());
+  shim::advanceMs(edgeAt + 32 + 10000 - 1 - millis());
+  p.update(millis());
+  TEST_ASSERT_FALSE(p.isSolved());
+  shim::advanceMs(1);
+  p.update(millis());
+  TEST_ASSERT_TRUE(p.isSolved());
+}
+
+void test_pin_change_activation_dated_after_the_loops_now() {
+  TiltButtonPuzzle p(PIN);
+  p.usePinChangeInterrupt();
+  p.begin();
+  shim::advanceMs(100);
+  setSwitch(true);
+  shim::advanceMs(29);
+  const uint32_t now = millis();
+  shim::advanceMs(2);
+  setSwitch(false);   // The ISR fills the integrator 30 ms after the edge, after now
+  p.update(now);
+  TEST_ASSERT_FALSE(p.isSolved());
+}
+
+void test_pin_change_ignores_other_pins_on_the_port() {
+  TiltButtonPuzzle p(PIN);
+  p.usePinChangeInterrupt();
+  p.begin();
+  shim::setPin(2, LOW);
+  TiltButtonPuzzle::pinChangeISR();   // PCINT18 changed, D4 did not
+  shim::advanceMs(100);
+  p.update(millis());
+  TEST_ASSERT_FALSE(Serial.printed("Tilt sensor activated"));
+}
+
+void test_orientation_mode_follows_the_up_axis() {
+  adxl.reset();
+  Wire.attach(&adxl);
+  SensorHub hub;
+  hub.begin();
+  TiltButtonPuzzle p(PIN, true, 30, 1000);
+  p.useOrientation(&hub, AccelAxis::Z_POS, 30);
+  p.begin();
+
+  // Upright: active
+  for (uint8_t i = 0; i < 20; i++) {
+    shim::advanceMs(10);
+    hub.update(millis());
+    p.update(millis());
+  }
+  TEST_ASSERT_TRUE(Serial.printed("Tilt sensor activated"));
+
+  // Tipped over onto its side: released
+  adxl.rest = {256, 0, 0};
+  for (uint8_t i = 0; i < 40; i++) {
+    shim::advanceMs(10);
+    hub.update(millis());
+    p.update(millis());
+  }
+  TEST_ASSERT_TRUE(Serial.printed("Tilt sensor deactivated"));
+  adxl.rest = {0, 0, 256};
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_polled_hold_solves_after_hold_time);
+  RUN_TEST(test_polled_release_restarts_the_countdown);
+  RUN_TEST(test_polled_glitch_shorter_than_debounce_is_ignored);
+  RUN_TEST(test_led_blinks_during_countdown_and_is_solid_when_solved);
+  RUN_TEST(test_update_does_no_blocking_work);
+  RUN_TEST(test_pin_change_mode_arms_pcint2);
+  RUN_TEST(test_pin_change_mode_needs_port_d);
+  RUN_TEST(test_pin_change_countdown_starts_at_the_debounced_edge);
+  RUN_TEST(test_pin_change_chatter_integrates);
+  RUN_TEST(test_pin_change_edge_after_the_loops_now);
+  RUN_TEST(test_pin_change_activation_dated_after_the_loops_now);
+  RUN_TEST(test_pin_change_ignores_other_pins_on_the_port);
+  RUN_TEST(test_orientation_mode_follows_the_up_axis);
+  return UNITY_END();
+}
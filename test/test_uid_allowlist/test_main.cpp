@@ -0,0 +1,143 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "UidAllowlist.h"
+
+static const uint8_t GOOMBA[] = {0x04, 0xA6, 0x89, 0x72, 0x3C, 0x4D, 0x80};
+
+// Distinct 7-byte UID per index
+static void makeUid(uint8_t i, uint8_t uid[7]) {
+  const uint8_t u[7] = {0x04, (uint8_t)(i * 37), 0x10, (uint8_t)(i ^ 0x5A), 0x22, 0x33, i};
+  memcpy(uid, u, 7);
+}
+
+void setUp() {
+  EEPROM.erase();
+  Serial.reset();
+}
+void tearDown() {}
+
+void test_blank_eeprom_is_formatted_once() {
+  UidAllowlist list(0);
+  TEST_ASSERT_FALSE(list.begin());
+  TEST_ASSERT_EQUAL_UINT8(0, list.count());
+  TEST_ASSERT_TRUE(list.begin());
+}
+
+void test_add_lookup_and_persist() {
+  UidAllowlist list(0);
+  list.begin();
+  TEST_ASSERT_TRUE(list.add(GOOMBA, sizeof(GOOMBA), NfcRole::SOLVE));
+  TEST_ASSERT_EQUAL((int)NfcRole::SOLVE, (int)list.lookup(GOOMBA, sizeof(GOOMBA)));
+
+  // A second instance over the same EEPROM sees the entry
+  UidAllowlist again(0);
+  TEST_ASSERT_TRUE(again.begin());
+  TEST_ASSERT_EQUAL((int)NfcRole::SOLVE, (int)again.lookup(GOOMBA, sizeof(GOOMBA)));
+}
+
+void test_role_change_reuses_the_slot() {
+  UidAllowlist list(0);
+  list.begin();
+  list.add(GOOMBA, sizeof(GOOMBA), NfcRole::SOLVE);
+  TEST_ASSERT_TRUE(list.add(GOOMBA, sizeof(GOOMBA), NfcRole::ADMIN_RESET));
+  TEST_ASSERT_EQUAL_UINT8(1, list.count());
+  TEST_ASSERT_EQUAL((int)NfcRole::ADMIN_RESET, (int)list.lookup(GOOMBA, sizeof(GOOMBA)));
+}
+
+void test_length_is_part_of_the_key() {
+  UidAllowlist list(0);
+  list.begin();
+  list.add(GOOMBA, 4, NfcRole::HINT);
+  TEST_ASSERT_EQUAL((int)NfcRole::NONE, (int)list.lookup(GOOMBA, 7));
+  TEST_ASSERT_EQUAL((int)NfcRole::HINT, (int)list.lookup(GOOMBA, 4));
+  TEST_ASSERT_FALSE(list.add(GOOMBA, 5, NfcRole::HINT));
+  TEST_ASSERT_FALSE(list.add(GOOMBA, 7, NfcRole::NONE));
+}
+
+void test_full_table_and_tombstones() {
+  UidAllowlist list(0);
+  list.begin();
+  uint8_t uid[7];
+  for (uint8_t i = 0; i < UidAllowlist::CAPACITY; i++) {
+    makeUid(i, uid);
+    TEST_ASSERT_TRUE(list.add(uid, 7, NfcRole::SOLVE));
+  }
+  makeUid(UidAllowlist::CAPACITY, uid);
+  TEST_ASSERT_FALSE(list.add(uid, 7, NfcRole::SOLVE));
+
+  // Delete every other entry: the survivors stay reachable through the tombstones
+  for (uint8_t i = 0; i < UidAllowlist::CAPACITY; i += 2) {
+    makeUid(i, uid);
+    TEST_ASSERT_TRUE(list.remove(uid, 7));
+    TEST_ASSERT_FALSE(list.remove(uid, 7));
+  }
+  TEST_ASSERT_EQUAL_UINT8(UidAllowlist::CAPACITY / 2, list.count());
+  for (uint8_t i = 0; i < UidAllowlist::CAPACITY; i++) {
+    makeUid(i, uid);
+    TEST_ASSERT_EQUAL((int)((i & 1) ? NfcRole::SOLVE : NfcRole::NONE), (int)list.lookup(uid, 7));
+  }
+
+  // Tombstones are reused, and a table with no empty slot left still answers misses
+  for (uint8_t i = 0; i < UidAllowlist::CAPACITY; i += 2) {
+    makeUid(i + 100, uid);
+    TEST_ASSERT_TRUE(list.add(uid, 7, NfcRole::HINT));
+  }
+  TEST_ASSERT_EQUAL_UINT8(UidAllowlist::CAPACITY, list.count());
+  makeUid(0, uid);
+  TEST_ASSERT_EQUAL((int)NfcRole::NONE, (int)list.lookup(uid, 7));
+  makeUid(102, uid);
+  TEST_ASSERT_EQUAL((int)NfcRole::HINT, (int)list.lookup(uid, 7));
+}
+
+void test_lookups_do_not_write_eeprom() {
+  UidAllowlist list(0);
+  list.begin();
+  list.add(GOOMBA, sizeof(GOOMBA), NfcRole::SOLVE);
+  const uint32_t writes = EEPROM.writes;
+  for (uint8_t i = 0; i < 10; i++) list.lookup(GOOMBA, sizeof(GOOMBA));
+  list.add(GOOMBA, sizeof(GOOMBA), NfcRole::SOLVE);   // Unchanged role: update() skips the write
+  TEST_ASSERT_EQUAL_UINT32(writes, EEPROM.writes);
+}
+
+void test_tables_at_different_bases_are_separate() {
+  UidAllowlist a(0), b(UidAllowlist::EEPROM_SIZE);
+  a.begin();
+  b.begin();
+  a.add(GOOMBA, sizeof(GOOMBA), NfcRole::SOLVE);
+  TEST_ASSERT_EQUAL((int)NfcRole::NONE, (int)b.lookup(GOOMBA, sizeof(GOOMBA)));
+  TEST_ASSERT_EQUAL_UINT8(0, b.count());
+}
+
+void test_parse_uid() {
+  uint8_t out[UidAllowlist::MAX_UID_LEN];
+  TEST_ASSERT_EQUAL_UINT8(7, UidAllowlist::parseUID("04:A6:89:72:3C:4D:80", out));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(GOOMBA, out, 7);
+  TEST_ASSERT_EQUAL_UINT8(7, UidAllowlist::parseUID("04a689723c4d80", out));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(GOOMBA, out, 7);
+  TEST_ASSERT_EQUAL_UINT8(4, UidAllowlist::parseUID("DEADBEEF", out));
+  TEST_ASSERT_EQUAL_UINT8(0, UidAllowlist::parseUID("04A68", out));        // Odd digit count
+  TEST_ASSERT_EQUAL_UINT8(0, UidAllowlist::parseUID("04A689", out));       // 3 bytes
+  TEST_ASSERT_EQUAL_UINT8(0, UidAllowlist::parseUID("04G68972", out));     // Not hex
+  TEST_ASSERT_EQUAL_UINT8(0, UidAllowlist::parseUID("0102030405060708090A0B", out));  // 11 bytes
+}
+
+void test_parse_role() {
+  TEST_ASSERT_EQUAL((int)NfcRole::SOLVE, (int)UidAllowlist::parseRole("SOLVE"));
+  TEST_ASSERT_EQUAL((int)NfcRole::HINT, (int)UidAllowlist::parseRole("HINT"));
+  TEST_ASSERT_EQUAL((int)NfcRole::ADMIN_RESET, (int)UidAllowlist::parseRole("ADMIN"));
+  TEST_ASSERT_EQUAL((int)NfcRole::NONE, (int)UidAllowlist::parseRole("solve"));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_blank_eeprom_is_formatted_once);
+  RUN_TEST(test_add_lookup_and_persist);
+  RUN_TEST(test_role_change_reuses_the_slot);
+  RUN_TEST(test_length_is_part_of_the_key);
+  RUN_TEST(test_full_table_and_tombstones);
+  RUN_TEST(test_lookups_do_not_write_eeprom);
+  RUN_TEST(test_tables_at_different_bases_are_separate);
+  RUN_TEST(test_parse_uid);
+  RUN_TEST(test_parse_role);
+  return UNITY_END();
+}
@@ -0,0 +1,123 @@
+// Replays KNOCKREC captures through the box's knock detector on the host, with the box's
+// settings and any candidate variants, and prints the knocks each one detects.
+// Capture a session's raw serial output to a file (KNOCKREC, knock, any key), then build and run
+// from the project root:
+//
+//   g++ -std=gnu++11 -Isrc -Itest/shim -DUNIT_TEST tools/knock_replay.cpp -o knock_replay
+//   ./knock_replay -k 4 -c 3.5,0.5,50 -c 2.5,0.5,50 oak_table.bin tiled_floor.bin
+//
+//   -c threshold,hysteresis,quietMs   variant to replay (repeatable; default the box's 3.5,0.5,50)
+//   -r 300,600,300 | -r none          rhythm gaps in ms, or count knocks only (default the box's)
+//   -t percent                        rhythm tolerance (default 15)
+//   -k knocks                         knocks actually made in each capture: report missed/false
+//   -v                                print the detector's log
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "KnockReplay.h"
+
+static void usage() {
+  fprintf(stderr, "usage: knock_replay [-c threshold,hysteresis,quietMs]... [-r gaps|none] [-t percent] "
+                  "[-k knocks] [-v] capture...\n");
+  exit(2);
+}
+
+static bool readFile(const char* path, std::string& data) {
+  FILE* f = fopen(path, "rb");
+  if (f == nullptr) return false;
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.append(buf, n);
+  fclose(f);
+  return true;
+}
+
+int main(int argc, char** argv) {
+  std::vector<KnockVariant> variants;
+  KnockVariant base;
+  int expected = -1;
+  bool verbose = false;
+  int arg = 1;
+  for (; arg < argc && argv[arg][0] == '-'; arg++) {
+    const char* opt = argv[arg];
+    if (strcmp(opt, "-v") == 0) {
+      verbose = true;
+      continue;
+    }
+    if (arg + 1 >= argc) usage();
+    const char* value = argv[++arg];
+    if (strcmp(opt, "-c") == 0) {
+      KnockVariant v;
+      unsigned long quiet;
+      if (sscanf(value, "%f,%f,%lu", &v.threshold, &v.hysteresis, &quiet) != 3) usage();
+      v.quietMs = quiet;
+      variants.push_back(v);
+    } else if (strcmp(opt, "-r") == 0) {
+      base.rhythmLen = 0;
+      for (const char* p = value; strcmp(value, "none") != 0 && *p;) {
+        char* end = nullptr;
+        const unsigned long gap = strtoul(p, &end, 10);
+        if (end == p || gap == 0 || gap > 0xFFFF || base.rhythmLen == 7 || (*end != ',' && *end != '\0')) usage();
+        base.rhythm[base.rhythmLen++] = (uint16_t)gap;
+        p = *end == ',' ? end + 1 : end;
+      }
+    } else if (strcmp(opt, "-t") == 0) {
+      base.tolerancePct = (uint8_t)atoi(value);
+    } else if (strcmp(opt, "-k") == 0) {
+      expected = atoi(value);
+    } else {
+      usage();
+    }
+  }
+  if (arg >= argc) usage();
+  if (variants.empty()) variants.push_back(KnockVariant());
+
+  int rc = 0;
+  for (; arg < argc; arg++) {
+    std::string capture, error;
+    KnockRecording recording;
+    if (!readFile(argv[arg], capture)) {
+      fprintf(stderr, "%s: cannot read\n", argv[arg]);
+      rc = 1;
+      continue;
+    }
+    if (!recording.parse(capture, error)) {
+      fprintf(stderr, "%s: %s\n", argv[arg], error.c_str());
+      rc = 1;
+      continue;
+    }
+    printf("%s: %lu frames over %.2f s at %lu us", argv[arg], (unsigned long)recording.frames.size(),
+           recording.durationUs() / 1e6, (unsigned long)recording.periodUs);
+    if (recording.overflows > 0) printf(", %lu FIFO overflows", (unsigned long)recording.overflows);
+    printf("\n");
+
+    for (size_t i = 0; i < variants.size(); i++) {
+      KnockVariant v = variants[i];
+      memcpy(v.rhythm, base.rhythm, sizeof(v.rhythm));
+      v.rhythmLen = base.rhythmLen;
+      v.tolerancePct = base.tolerancePct;
+      const KnockReplayResult r = replayKnocks(recording, v);
+      printf("  threshold %.2f hysteresis %.2f quiet %lu ms: ", v.threshold, v.hysteresis, (unsigned long)v.quietMs);
+      if (!r.valid) {
+        printf("out of range\n");
+        rc = 1;
+        continue;
+      }
+      printf("%lu knocks", (unsigned long)r.hitsMs.size());
+      for (size_t h = 0; h < r.hitsMs.size(); h++) printf("%s%.2f", h == 0 ? " at " : " ", r.hitsMs[h] / 1000.0);
+      if (!r.hitsMs.empty()) printf(" s");
+      if (r.solvedMs >= 0) {
+        printf(", solved at %.2f s", r.solvedMs / 1000.0);
+      } else {
+        printf(", not solved");
+      }
+      if (expected >= 0) {
+        const int hits = (int)r.hitsMs.size();
+        printf(" (%d missed, %d false)", hits < expected ? expected - hits : 0, hits > expected ? hits - expected : 0);
+      }
+      printf("\n");
+      if (verbose) printf("%s", r.log.c_str());
+    }
+  }
+  return rc;
+}